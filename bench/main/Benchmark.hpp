@@ -0,0 +1,108 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+//========================================
+
+// Minimal benchmark harness
+// Every benchmark is repeated with doubling iteration count until it runs for at least the minimal time,
+// results are printed in the end as a single line of JSON, so that it can be picked out of the console log:
+//     {"target": "...", "benchmarks": [{"name": "...", "iterations": N, "ns_per_op": X, "frames_per_s": Y}, ...]}
+// frames_per_s is only reported for benchmarks that represent a whole frame
+// Progress is printed to stderr in a human readable form
+class Benchmark
+{
+public:
+	Benchmark(const char* target, int64_t min_time_us = 200'000):
+		m_target(target),
+		m_min_time_us(min_time_us)
+	{}
+	
+	Benchmark(const Benchmark& copy) = delete;
+	
+	// Function is called with the number of iterations to run
+	template<typename F>
+	void run(const char* name, F&& function, bool frame = false)
+	{
+		size_t iterations = 1;
+		int64_t elapsed_us = 0;
+		
+		while (true)
+		{
+			auto start = esp_timer_get_time();
+			function(iterations);
+			elapsed_us = esp_timer_get_time() - start;
+			
+			if (elapsed_us >= m_min_time_us)
+				break;
+			
+			iterations *= 2;
+		}
+		
+		Result result = { name, iterations, elapsed_us * 1000.0 / iterations, frame };
+		m_results.push_back(result);
+		
+		fprintf(stderr, "%-32s %10zu %14.1f ns/op", result.name, result.iterations, result.ns_per_op);
+		if (frame)
+			fprintf(stderr, " %10.1f frames/s", 1e9 / result.ns_per_op);
+		
+		fprintf(stderr, "\n");
+		
+		// Lets the idle task feed the watchdog between benchmarks
+		vTaskDelay(1);
+	}
+	
+	void print() const
+	{
+		printf("{\"target\": \"%s\", \"benchmarks\": [", m_target);
+		for (size_t i = 0; i < m_results.size(); i++)
+		{
+			const auto& result = m_results[i];
+			printf(
+				"%s{\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.1f",
+				i? ", ": "",
+				result.name,
+				result.iterations,
+				result.ns_per_op
+			);
+			
+			if (result.frame)
+				printf(", \"frames_per_s\": %.1f", 1e9 / result.ns_per_op);
+			
+			printf("}");
+		}
+		
+		printf("]}\n");
+		fflush(stdout);
+	}
+	
+	// Keeps the compiler from optimizing away computation of the value
+	template<typename T>
+	static void DoNotOptimize(const T& value)
+	{
+		asm volatile("" : : "r"(&value) : "memory");
+	}
+	
+private:
+	struct Result
+	{
+		const char* name;
+		size_t      iterations;
+		double      ns_per_op;
+		bool        frame;
+	};
+	
+	const char*         m_target;
+	int64_t             m_min_time_us;
+	std::vector<Result> m_results {};
+	
+};
+
+//========================================
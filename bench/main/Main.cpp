@@ -0,0 +1,503 @@
+#include "freertos/FreeRTOS.h"
+
+#include "esp_log.h"
+
+#include "driver/spi_master.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numbers>
+#include <vector>
+#include <cmath>
+
+#include <Peripherals/SH1106Display.hpp>
+#include <Render.hpp>
+#include <Layer.hpp>
+#include <Font.hpp>
+#include <Sample.hpp>
+#include <Selector.hpp>
+#include <MathChannel.hpp>
+#include <LogicAnalyzer.hpp>
+#include <LimitTest.hpp>
+#include <Trigger.hpp>
+#include <CicDecimator.hpp>
+#include <SignalGenerator.hpp>
+#include <SampleCodec.hpp>
+#include <Benchmark.hpp>
+
+//========================================
+
+static const char* TAG = "bench";
+
+constexpr auto SCREEN_SPI_HOST = SPI2_HOST;
+
+extern const uint8_t FONT_BEGIN[] asm("_binary_font_bin_start");
+extern const uint8_t FONT_END  [] asm("_binary_font_bin_end"  );
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+	constexpr const char* TARGET = "linux";
+#else
+	constexpr const char* TARGET = CONFIG_IDF_TARGET;
+#endif
+
+// Window sizes in samples: shortest window at the lowest rate up to the longest one at the highest rate
+constexpr size_t WINDOW_SIZES[] = { 10, 128, 1'000, 25'000 };
+
+//========================================
+
+static void InitDisplay(SH1106Display& display)
+{
+	spi_bus_config_t spi_bus_config = {};
+	spi_bus_config.miso_io_num = -1;
+	spi_bus_config.mosi_io_num = CONFIG_DISPLAY_PIN_MOSI;
+	spi_bus_config.sclk_io_num = CONFIG_DISPLAY_PIN_SCK;
+	spi_bus_config.quadwp_io_num = -1;
+	spi_bus_config.quadhd_io_num = -1;
+	spi_bus_config.max_transfer_sz = 0xFFFF;
+	ESP_ERROR_CHECK(spi_bus_initialize(SCREEN_SPI_HOST, &spi_bus_config, SPI_DMA_CH_AUTO));
+	
+	display.setup(
+		SCREEN_SPI_HOST,
+		static_cast<gpio_num_t>(CONFIG_DISPLAY_PIN_DC),
+		1'000'000 * CONFIG_DISPLAY_SPI_FREQ_MHZ
+	);
+}
+
+// 50 Hz sine sampled at 25 kHz with the same amplitude as the test signal source
+static std::vector<Sample> MakeSamples(size_t count)
+{
+	std::vector<Sample> samples(count);
+	for (size_t i = 0; i < count; i++)
+		samples[i] = 1000 * std::sin(50 * 2.0 * std::numbers::pi * i / 25'000);
+	
+	return samples;
+}
+
+//========================================
+
+static void RunPrimitives(Benchmark& bench, SH1106Display& display, const Font& font)
+{
+	bench.run("SH1106Display::clear", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			display.clear();
+	});
+	
+	// One op is a single pixel, the whole screen is swept to avoid measuring a single cached byte
+	bench.run("SH1106Display::setPixel", [&](size_t iterations)
+	{
+		const auto& size = display.getSize();
+		for (size_t i = 0; i < iterations; i++)
+			display.setPixel(Vector2i(i % size.x, i / size.x % size.y), i & 1);
+	});
+	
+	bench.run("Line/horizontal", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Line(display, Vector2i(0, 32), Vector2i(127, 32));
+	});
+	
+	bench.run("Line/vertical", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Line(display, Vector2i(64, 0), Vector2i(64, 63));
+	});
+	
+	bench.run("Line/diagonal", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Line(display, Vector2i(0, 0), Vector2i(127, 63));
+	});
+	
+	bench.run("Rectangle/32x16", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Rectangle(display, Vector2i(8, 8), Vector2i(32, 16));
+	});
+	
+	bench.run("RoundedRectangle/128x16", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			RoundedRectangle(display, Vector2i(0, 48), Vector2i(128, 16), 4);
+	});
+	
+	bench.run("Circle/r16", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Circle(display, Vector2f(64, 32), 16);
+	});
+	
+	bench.run("Text/16", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Text(display, font, Vector2i(0, 48), "Sample rate 1000");
+	});
+	
+	bench.run("Font::getGlyph", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Benchmark::DoNotOptimize(font.getGlyph(' ' + i % ('~' - ' ' + 1)));
+	});
+	
+	bench.run("Graticule", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Graticule(display, Vector2i(8, 4));
+	});
+	
+	// Menu shown with an item that does not change, as well as one changing every frame
+	static Layer layer;
+	static IntSelectorItem item("Sample rate", "%d Hz", 1000, 100, 25000, 100);
+	static Selector selector(item);
+	
+	RotaryEncoder::Event press = {};
+	press.type = RotaryEncoder::Event::Button;
+	press.button = true;
+	selector.onEvent(press);
+	
+	bench.run("Selector::render", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			selector.render(layer, font);
+	});
+	
+	bench.run("Selector::render/changing", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+		{
+			item.setValue(100 + i % 1000);
+			selector.render(layer, font);
+		}
+	});
+	
+	bench.run("SH1106Display::compose/or", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			display.compose(layer, Layer::Blend::Or);
+	});
+	
+	bench.run("SH1106Display::compose/over", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			display.compose(layer, Layer::Blend::Over);
+	});
+	
+	// Frame changing every time, as well as the same one again which has nothing to send
+	bench.run("SH1106Display::flush", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+		{
+			display.setPixel(Vector2i(i % 128, 0), i & 1);
+			display.flush();
+		}
+	});
+	
+	bench.run("SH1106Display::flush/unchanged", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			display.flush();
+	});
+}
+
+// Plot path of the render loop at various window sizes, only the whole frame is reported in frames/s
+static void RunPlot(Benchmark& bench, SH1106Display& display)
+{
+	static char names[std::size(WINDOW_SIZES)][5][48] = {};
+	
+	for (size_t window = 0; window < std::size(WINDOW_SIZES); window++)
+	{
+		size_t size = WINDOW_SIZES[window];
+		auto samples = MakeSamples(size);
+		
+		// Quarter period behind, so that the pairs trace a circle
+		auto samples_y = MakeSamples(size + 125);
+		samples_y.erase(samples_y.begin(), samples_y.begin() + 125);
+		
+		auto* autoscale_name = names[window][0];
+		auto* plot_name      = names[window][1];
+		auto* peak_name      = names[window][2];
+		auto* xy_name        = names[window][3];
+		auto* frame_name     = names[window][4];
+		snprintf(autoscale_name, std::size(names[window][0]), "Autoscale/%zu", size);
+		snprintf(plot_name,      std::size(names[window][1]), "Plot/%zu",      size);
+		snprintf(peak_name,      std::size(names[window][2]), "Plot/peak/%zu", size);
+		snprintf(xy_name,        std::size(names[window][3]), "PlotXY/%zu",    size);
+		snprintf(frame_name,     std::size(names[window][4]), "Frame/%zu",     size);
+		
+		bench.run(autoscale_name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				Benchmark::DoNotOptimize(std::ranges::minmax_element(samples));
+		});
+		
+		bench.run(plot_name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				Plot(display, samples, .0001, -.1, .1);
+		});
+		
+		bench.run(peak_name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				Plot(display, samples, .0001, -.1, .1, PlotMode::Peak);
+		});
+		
+		bench.run(xy_name, [&](size_t iterations)
+		{
+			const auto& display_size = display.getSize();
+			for (size_t i = 0; i < iterations; i++)
+			{
+				auto [x_min, x_max] = std::ranges::minmax_element(samples);
+				auto [y_min, y_max] = std::ranges::minmax_element(samples_y);
+				PlotXY(
+					display,
+					samples,
+					samples_y,
+					AxisScale(*x_min, *x_max, display_size.x),
+					AxisScale(*y_min, *y_max, display_size.y)
+				);
+			}
+		});
+		
+		// Everything the render loop does except for the menu and the display transfer
+		bench.run(frame_name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+			{
+				display.clear();
+				
+				auto [min, max] = std::ranges::minmax_element(samples);
+				Plot(display, samples, .0001, *min * .0001, *max * .0001);
+			}
+		}, true);
+	}
+}
+
+// Math kernels over the longest window, the way the processing loop feeds them a block at a time
+static void RunMath(Benchmark& bench)
+{
+	constexpr size_t size = WINDOW_SIZES[std::size(WINDOW_SIZES) - 1];
+	constexpr size_t block_size = 32;
+	
+	static const auto a = MakeSamples(size);
+	static const auto b = MakeSamples(size + 125);
+	static std::vector<Sample> output(size);
+	static MathChannel math;
+	
+	constexpr std::pair<const char*, MathChannel::Operation> operations[] = {
+		{ "MathChannel/difference", MathChannel::Operation::Difference },
+		{ "MathChannel/product",    MathChannel::Operation::Product    },
+		{ "MathChannel/integral",   MathChannel::Operation::Integral   },
+		{ "MathChannel/derivative", MathChannel::Operation::Derivative }
+	};
+	
+	for (const auto& [name, operation]: operations)
+	{
+		math.setup(operation, .0001, .0001, 25'000, size);
+		
+		bench.run(name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+			{
+				for (size_t begin = 0; begin < size; begin += block_size)
+				{
+					size_t length = std::min(block_size, size - begin);
+					math.process(
+						std::span(a).subspan(begin, length),
+						std::span(b).subspan(begin, length),
+						std::span(output).subspan(begin, length)
+					);
+				}
+			}
+		}, true);
+	}
+}
+
+// Digital mode over the longest window of a 50 Hz square wave with a quarter duty cycle
+static void RunLogic(Benchmark& bench)
+{
+	constexpr size_t size = WINDOW_SIZES[std::size(WINDOW_SIZES) - 1];
+	
+	static std::vector<Sample> samples(size);
+	for (size_t i = 0; i < size; i++)
+		samples[i] = i % 500 < 125? 1000: 0;
+	
+	static LogicAnalyzer logic;
+	
+	bench.run("LogicAnalyzer::capture", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			logic.capture(samples, i % size, 400, 600);
+	}, true);
+	
+	bench.run("LogicAnalyzer::decodeUart", [&](size_t iterations)
+	{
+		std::array<LogicAnalyzer::Byte, 32> bytes;
+		for (size_t i = 0; i < iterations; i++)
+			Benchmark::DoNotOptimize(logic.decodeUart(bytes));
+	}, true);
+	
+	bench.run("LogicAnalyzer::decodePulses", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			Benchmark::DoNotOptimize(logic.decodePulses());
+	}, true);
+}
+
+// Per sample cost in the processing loop, against a mask learned from the signal itself
+static void RunLimitTest(Benchmark& bench)
+{
+	constexpr size_t size = WINDOW_SIZES[std::size(WINDOW_SIZES) - 1];
+	
+	static const auto samples = MakeSamples(size);
+	static LimitTest limit_test;
+	limit_test.startMask(size);
+	for (size_t i = 0; i < size; i++)
+		limit_test.learn(samples[i], i);
+	
+	limit_test.finishMask(10);
+	
+	// One op is a single sample
+	bench.run("LimitTest::check", [&](size_t iterations)
+	{
+		for (size_t i = 0; i < iterations; i++)
+			limit_test.check(samples[i % size], i % size, i);
+	});
+}
+
+// Generator blocks at the highest rate, alone and fed through the per-sample trigger and decimation stages
+static void RunGenerator(Benchmark& bench)
+{
+	constexpr size_t size = WINDOW_SIZES[std::size(WINDOW_SIZES) - 1];
+	
+	static std::vector<Sample> samples(size);
+	static SignalGenerator generator;
+	
+	SignalGenerator::Config config = {};
+	config.frequency_hz = 50;
+	config.sample_rate_hz = 25'000;
+	config.amplitude = 1000;
+	config.duty_percent = 25;
+	
+	constexpr std::pair<const char*, SignalGenerator::Waveform> waveforms[] = {
+		{ "SignalGenerator/sine",     SignalGenerator::Waveform::Sine     },
+		{ "SignalGenerator/square",   SignalGenerator::Waveform::Square   },
+		{ "SignalGenerator/triangle", SignalGenerator::Waveform::Triangle },
+		{ "SignalGenerator/sawtooth", SignalGenerator::Waveform::Sawtooth },
+		{ "SignalGenerator/pulse",    SignalGenerator::Waveform::Pulse    },
+		{ "SignalGenerator/noise",    SignalGenerator::Waveform::Noise    },
+		{ "SignalGenerator/chirp",    SignalGenerator::Waveform::Chirp    }
+	};
+	
+	for (const auto& [name, waveform]: waveforms)
+	{
+		config.waveform = waveform;
+		generator.setup(config);
+		
+		bench.run(name, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				generator.generate(samples);
+		}, true);
+	}
+	
+	// Glitches every 10 ms, caught by the glitch trigger
+	config.waveform = SignalGenerator::Waveform::Pulse;
+	config.glitch_interval = 250;
+	generator.setup(config);
+	
+	static Trigger trigger;
+	Trigger::Config trigger_config = {};
+	trigger_config.low = 400;
+	trigger_config.high = 600;
+	trigger_config.rising = true;
+	trigger_config.width = 4;
+	trigger.setup(trigger_config);
+	
+	static CicDecimator decimator;
+	decimator.setup(16);
+	
+	// One op is a single sample
+	bench.run("SignalGenerator -> Trigger -> CicDecimator", [&](size_t iterations)
+	{
+		std::array<Sample, SignalGenerator::s_block_size> block;
+		for (size_t i = 0; i < iterations; i += block.size())
+		{
+			generator.generate(block);
+			
+			for (Sample sample: block)
+			{
+				Benchmark::DoNotOptimize(trigger.process(sample, i));
+				Benchmark::DoNotOptimize(decimator.add(sample + 32768));
+			}
+		}
+	});
+}
+
+// Compression of the longest window the way the DATA export does it, a slow rail and the test sine
+static void RunCodec(Benchmark& bench)
+{
+	constexpr size_t size = WINDOW_SIZES[std::size(WINDOW_SIZES) - 1];
+	
+	static std::vector<Sample> rail(size);
+	for (size_t i = 0; i < size; i++)
+		rail[i] = 4000 + (i / 100 % 4) - (i % 7 == 0);
+	
+	static const auto sine = MakeSamples(size);
+	static std::vector<uint8_t> encoded(SampleCodec::GetMaxEncodedSize(size));
+	static std::vector<Sample> decoded(size);
+	
+	constexpr std::pair<const char*, const char*> names[] = {
+		{ "SampleCodec::Encode/rail", "SampleCodec::Decode/rail" },
+		{ "SampleCodec::Encode/sine", "SampleCodec::Decode/sine" }
+	};
+	
+	for (size_t input = 0; input < std::size(names); input++)
+	{
+		const auto& samples = input? sine: rail;
+		
+		// One op is the whole window
+		size_t encoded_size = 0;
+		bench.run(names[input].first, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				SampleCodec::Encode(samples, encoded, &encoded_size);
+		});
+		
+		bench.run(names[input].second, [&](size_t iterations)
+		{
+			for (size_t i = 0; i < iterations; i++)
+				Benchmark::DoNotOptimize(SampleCodec::Decode(std::span(encoded).first(encoded_size), decoded));
+		});
+		
+		ESP_LOGI(TAG, "%s: %.2fx", names[input].first, samples.size() * sizeof(Sample) / static_cast<float>(encoded_size));
+	}
+}
+
+//========================================
+
+extern "C" void app_main()
+{
+	static SH1106Display display;
+	InitDisplay(display);
+	
+	static Font font(FONT_BEGIN, FONT_END);
+	
+	ESP_LOGI(TAG, "running benchmarks on %s", TARGET);
+	
+	Benchmark bench(TARGET);
+	RunPrimitives(bench, display, font);
+	RunPlot(bench, display);
+	RunMath(bench);
+	RunLogic(bench);
+	RunLimitTest(bench);
+	RunGenerator(bench);
+	RunCodec(bench);
+	bench.print();
+	
+	#ifdef CONFIG_IDF_TARGET_LINUX
+		std::exit(0);
+	#endif
+}
+
+//========================================
@@ -0,0 +1,124 @@
+#include "esp_log.h"
+
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali_scheme.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#include <SimulatorInternal.hpp>
+#include <Waveform.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+struct adc_oneshot_unit_ctx_t
+{
+	adc_unit_t unit;
+	
+	std::array<adc_oneshot_chan_cfg_t, 10> channels;
+};
+
+struct adc_cali_scheme_t
+{
+	adc_atten_t    atten;
+	adc_bitwidth_t bitwidth;
+};
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+Waveform s_waveform {};
+
+// Approximate input range of each attenuation, mV
+constexpr int FullScale[] = { 950, 1250, 1750, 3100 };
+
+int GetBitWidth(adc_bitwidth_t bitwidth)
+{
+	return bitwidth == ADC_BITWIDTH_DEFAULT? 12: bitwidth;
+}
+
+// 550 mV offset with 300 mV 50 Hz sine unless a waveform is given
+double GetInputVoltage(double time)
+{
+	return s_waveform.isLoaded()
+		? s_waveform.sample(time, 0)
+		: 550 + 300 * std::sin(2 * std::numbers::pi * 50 * time);
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+extern "C" esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t* init_config, adc_oneshot_unit_handle_t* ret_unit)
+{
+	if (const char* path = Simulator::GetEnvironment("SIM_ADC_WAVEFORM"); path && !s_waveform.isLoaded() && !s_waveform.load(path))
+		ESP_LOGE(TAG, "failed to load ADC waveform '%s'", path);
+	
+	*ret_unit = new adc_oneshot_unit_ctx_t { init_config->unit_id, {} };
+	return ESP_OK;
+}
+
+extern "C" esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle)
+{
+	delete handle;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel, const adc_oneshot_chan_cfg_t* config)
+{
+	if (static_cast<size_t>(channel) >= handle->channels.size())
+		return ESP_ERR_INVALID_ARG;
+	
+	handle->channels[channel] = *config;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int* out_raw)
+{
+	if (static_cast<size_t>(chan) >= handle->channels.size())
+		return ESP_ERR_INVALID_ARG;
+	
+	const auto& config = handle->channels[chan];
+	int max_code = (1 << GetBitWidth(config.bitwidth)) - 1;
+	
+	double code = GetInputVoltage(Simulator::GetTime()) / FullScale[config.atten] * max_code;
+	*out_raw = std::clamp<int>(std::lround(code), 0, max_code);
+	
+	return ESP_OK;
+}
+
+//========================================
+
+extern "C" esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t* config, adc_cali_handle_t* ret_handle)
+{
+	*ret_handle = new adc_cali_scheme_t { config->atten, config->bitwidth };
+	return ESP_OK;
+}
+
+extern "C" esp_err_t adc_cali_delete_scheme_line_fitting(adc_cali_handle_t handle)
+{
+	delete handle;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int* voltage)
+{
+	int max_code = (1 << GetBitWidth(handle->bitwidth)) - 1;
+	*voltage = raw * FullScale[handle->atten] / max_code;
+	
+	return ESP_OK;
+}
+
+//========================================
@@ -0,0 +1,183 @@
+#include "esp_log.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+
+#include <SimulatorInternal.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+// Emulated SH1106 controller
+class Panel
+{
+public:
+	void write(std::span<const uint8_t> bytes, bool data)
+	{
+		for (auto byte: bytes)
+		{
+			if (data)
+				writeData(byte);
+			
+			else
+				writeCommand(byte);
+		}
+	}
+	
+private:
+	static constexpr int s_columns      = 132;
+	static constexpr int s_pages        = 8;
+	static constexpr int s_width        = 128;
+	static constexpr int s_height       = 64;
+	static constexpr int s_column_offset = (s_columns - s_width) / 2;
+	
+	std::array<std::array<uint8_t, s_columns>, s_pages> m_ram {};
+	
+	int  m_page             = 0;
+	int  m_column           = 0;
+	int  m_rmw_column       = 0;
+	int  m_last_page        = -1;
+	bool m_argument_pending = false;
+	bool m_reverse          = false;
+	bool m_remap            = false;
+	bool m_scan_reversed    = false;
+	bool m_on               = false;
+	bool m_dirty            = false;
+	
+	unsigned m_frame = 0;
+	
+	void writeCommand(uint8_t command)
+	{
+		// Second byte of a double byte command
+		if (m_argument_pending)
+		{
+			m_argument_pending = false;
+			return;
+		}
+		
+		switch (command)
+		{
+			case 0x81: // Contrast
+			case 0xA8: // Multiplex ratio
+			case 0xAD: // DC-DC
+			case 0xD3: // Display offset
+			case 0xD5: // Oscillator
+			case 0xD9: // Precharge
+			case 0xDA: // Common pads
+			case 0xDB: // VCOM
+				m_argument_pending = true;
+				return;
+			
+			case 0xE0: // Read-modify-write start
+				m_rmw_column = m_column;
+				return;
+			
+			case 0xEE: // Read-modify-write end
+				m_column = m_rmw_column;
+				return;
+		
+		}
+		
+		if      ((command & 0xF0) == 0x00) m_column = (m_column & 0xF0) | (command & 0x0F);
+		else if ((command & 0xF0) == 0x10) m_column = (m_column & 0x0F) | (command & 0x0F) << 4;
+		else if ((command & 0xF8) == 0xB0) m_page = command & 0x07;
+		else if ((command & 0xFE) == 0xA0) m_remap = command & 1;
+		else if ((command & 0xFE) == 0xA6) m_reverse = command & 1;
+		else if ((command & 0xFE) == 0xAE) m_on = command & 1;
+		else if ((command & 0xF0) == 0xC0) m_scan_reversed = command & 0x08;
+	}
+	
+	void writeData(uint8_t byte)
+	{
+		// Frame boundaries are not visible on the bus, so writing to a page that is not after the previous one starts a new frame
+		if (m_page != m_last_page)
+		{
+			if (m_page < m_last_page && m_dirty)
+				emitFrame();
+			
+			m_last_page = m_page;
+		}
+		
+		if (m_column < s_columns)
+			m_ram[m_page][m_column++] = byte;
+		
+		m_dirty = true;
+		
+		if (m_page == s_pages - 1 && m_column == s_columns)
+			emitFrame();
+	}
+	
+	bool getPixel(int x, int y) const
+	{
+		// Remapped segments and reversed scan direction give the natural orientation
+		int column = (m_remap? x: s_width - 1 - x) + s_column_offset;
+		int row = m_scan_reversed? y: s_height - 1 - y;
+		
+		return m_on && ((m_ram[row / 8][column] >> row % 8 & 1) ^ m_reverse);
+	}
+	
+	void emitFrame()
+	{
+		m_dirty = false;
+		m_frame++;
+		
+		if (const char* directory = Simulator::GetEnvironment("SIM_FRAMES_DIR"))
+		{
+			char path[512] = "";
+			snprintf(path, std::size(path), "%s/frame_%06u.pbm", directory, m_frame);
+			
+			if (auto* file = fopen(path, "wb"))
+			{
+				// PBM treats set bits as black, so lit pixels are written as zeros to look like the panel
+				fprintf(file, "P4\n%d %d\n", s_width, s_height);
+				for (int y = 0; y < s_height; y++)
+				{
+					for (int x = 0; x < s_width; x += 8)
+					{
+						uint8_t byte = 0;
+						for (int bit = 0; bit < 8; bit++)
+							byte |= !getPixel(x + bit, y) << (7 - bit);
+						
+						fputc(byte, file);
+					}
+				}
+				
+				fclose(file);
+			}
+			
+			else
+				ESP_LOGE(TAG, "failed to write frame '%s'", path);
+		}
+		
+		if (const char* limit = Simulator::GetEnvironment("SIM_FRAME_LIMIT"); limit && m_frame >= std::strtoul(limit, nullptr, 10))
+		{
+			ESP_LOGI(TAG, "frame limit reached");
+			std::exit(0);
+		}
+	}
+	
+};
+
+Panel s_panel {};
+
+//========================================
+
+} // namespace
+
+//========================================
+
+void Simulator::WriteDisplay(std::span<const uint8_t> bytes, bool data)
+{
+	s_panel.write(bytes, data);
+}
+
+//========================================
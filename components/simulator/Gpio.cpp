@@ -0,0 +1,172 @@
+#include "esp_log.h"
+
+#include "driver/gpio.h"
+
+#include <array>
+
+#include <SimulatorInternal.hpp>
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+struct Pin
+{
+	gpio_mode_t     mode      = GPIO_MODE_DISABLE;
+	gpio_int_type_t interrupt = GPIO_INTR_DISABLE;
+	gpio_isr_t      handler   = nullptr;
+	void*           arg       = nullptr;
+	bool            level     = false;
+};
+
+std::array<Pin, GPIO_NUM_MAX> s_pins {};
+bool s_isr_service_installed = false;
+
+bool IsValid(gpio_num_t pin)
+{
+	return 0 <= pin && pin < GPIO_NUM_MAX;
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+void Simulator::SetInputLevel(gpio_num_t pin, bool level)
+{
+	if (!IsValid(pin))
+		return;
+	
+	auto& state = s_pins[pin];
+	bool previous_level = state.level;
+	state.level = level;
+	
+	if (previous_level != level)
+		UpdatePulseCounters(pin, level);
+	
+	if (!s_isr_service_installed || !state.handler)
+		return;
+	
+	bool triggered = false;
+	switch (state.interrupt)
+	{
+		case GPIO_INTR_POSEDGE:    triggered = !previous_level &&  level;  break;
+		case GPIO_INTR_NEGEDGE:    triggered =  previous_level && !level;  break;
+		case GPIO_INTR_ANYEDGE:    triggered =  previous_level !=  level;  break;
+		case GPIO_INTR_LOW_LEVEL:  triggered = !level;                     break;
+		case GPIO_INTR_HIGH_LEVEL: triggered =  level;                     break;
+		default:                                                           break;
+	}
+	
+	if (triggered)
+		state.handler(state.arg);
+}
+
+bool Simulator::GetLevel(gpio_num_t pin)
+{
+	return IsValid(pin) && s_pins[pin].level;
+}
+
+//========================================
+
+extern "C" esp_err_t gpio_config(const gpio_config_t* config)
+{
+	for (int pin = 0; pin < GPIO_NUM_MAX; pin++)
+	{
+		if (!(config->pin_bit_mask >> pin & 1))
+			continue;
+		
+		auto& state = s_pins[pin];
+		state.mode = config->mode;
+		state.interrupt = config->intr_type;
+		
+		// Inputs idle at the level of their pulls
+		if (config->mode == GPIO_MODE_INPUT)
+			state.level = config->pull_up_en == GPIO_PULLUP_ENABLE;
+	}
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+	if (!IsValid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	
+	s_pins[gpio_num] = Pin {};
+	s_pins[gpio_num].level = true;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+	if (!IsValid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	
+	s_pins[gpio_num].mode = mode;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+	if (!IsValid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	
+	s_pins[gpio_num].level = level;
+	return ESP_OK;
+}
+
+extern "C" int gpio_get_level(gpio_num_t gpio_num)
+{
+	return Simulator::GetLevel(gpio_num);
+}
+
+//========================================
+
+extern "C" esp_err_t gpio_install_isr_service(int /*intr_alloc_flags*/)
+{
+	if (s_isr_service_installed)
+		return ESP_ERR_INVALID_STATE;
+	
+	s_isr_service_installed = true;
+	Simulator::StartEncoderScript();
+	
+	return ESP_OK;
+}
+
+extern "C" void gpio_uninstall_isr_service()
+{
+	s_isr_service_installed = false;
+}
+
+extern "C" esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args)
+{
+	if (!IsValid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	
+	if (!s_isr_service_installed)
+		return ESP_ERR_INVALID_STATE;
+	
+	s_pins[gpio_num].handler = isr_handler;
+	s_pins[gpio_num].arg = args;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+	if (!IsValid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	
+	s_pins[gpio_num].handler = nullptr;
+	s_pins[gpio_num].arg = nullptr;
+	
+	return ESP_OK;
+}
+
+//========================================
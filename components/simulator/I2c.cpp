@@ -0,0 +1,192 @@
+#include "esp_log.h"
+
+#include "driver/i2c_master.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#include <SimulatorInternal.hpp>
+#include <Waveform.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+struct i2c_master_bus_t
+{
+	i2c_port_num_t port;
+};
+
+// Emulated INA226
+struct i2c_master_dev_t
+{
+	uint16_t address;
+	uint8_t  pointer;
+	
+	std::array<uint16_t, 8> registers;
+};
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+constexpr uint16_t DefaultConfiguration = 0x4127;
+constexpr uint16_t ConversionReadyFlag  = 1 << 3;
+
+constexpr double ShuntVoltageLSB = .0025;  // mV
+constexpr double BusVoltageLSB   = .00125; // V
+
+Waveform s_waveform {};
+uint32_t s_noise_state = 1;
+
+void LoadWaveform()
+{
+	if (s_waveform.isLoaded())
+		return;
+	
+	if (const char* path = Simulator::GetEnvironment("SIM_INA226_WAVEFORM"); path && !s_waveform.load(path))
+		ESP_LOGE(TAG, "failed to load INA226 waveform '%s'", path);
+}
+
+// Deterministic +-1 LSB noise, so that runs are reproducible
+int Noise()
+{
+	s_noise_state = s_noise_state * 1'103'515'245 + 12'345;
+	return static_cast<int>(s_noise_state >> 16) % 3 - 1;
+}
+
+int16_t Quantize(double value, double lsb)
+{
+	return static_cast<int16_t>(std::clamp(std::lround(value / lsb) + Noise(), -32768l, 32767l));
+}
+
+// Bus is 5 V with 50 Hz ripple, shunt is a 1 Hz sawtooth load current
+double GetBusVoltage(double time)
+{
+	return s_waveform.isLoaded()
+		? s_waveform.sample(time, 0)
+		: 5 + .05 * std::sin(2 * std::numbers::pi * 50 * time);
+}
+
+double GetShuntVoltage(double time)
+{
+	return s_waveform.isLoaded()
+		? s_waveform.sample(time, 1)
+		: 20 * (time - std::floor(time));
+}
+
+uint16_t ReadRegister(i2c_master_dev_t* device)
+{
+	switch (device->pointer)
+	{
+		case 0x01: return Quantize(GetShuntVoltage(Simulator::GetTime()), ShuntVoltageLSB);
+		case 0x02: return std::max<int16_t>(Quantize(GetBusVoltage(Simulator::GetTime()), BusVoltageLSB), 0);
+		case 0xFE: return 0x5449; // Manufacturer ID, "TI"
+		case 0xFF: return 0x2260; // Die ID
+	}
+	
+	if (device->pointer < device->registers.size())
+		return device->registers[device->pointer];
+	
+	return 0;
+}
+
+void WriteRegister(i2c_master_dev_t* device, uint16_t value)
+{
+	switch (device->pointer)
+	{
+		case 0x00:
+			device->registers = {};
+			device->registers[0x00] = value & (1 << 15)? DefaultConfiguration: value;
+			device->registers[0x06] = ConversionReadyFlag;
+			return;
+		
+		case 0x06:
+			// Conversions complete instantly, so the ready flag is always set
+			device->registers[0x06] = (value & 0xFC13) | ConversionReadyFlag;
+			return;
+		
+		case 0x05:
+		case 0x07:
+			device->registers[device->pointer] = value;
+			return;
+	
+	}
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+extern "C" esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* bus_config, i2c_master_bus_handle_t* ret_bus_handle)
+{
+	LoadWaveform();
+	
+	*ret_bus_handle = new i2c_master_bus_t { bus_config->i2c_port };
+	return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle)
+{
+	delete bus_handle;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t /*bus_handle*/, const i2c_device_config_t* dev_config, i2c_master_dev_handle_t* ret_handle)
+{
+	auto* device = new i2c_master_dev_t { dev_config->device_address, 0, {} };
+	device->registers[0x00] = DefaultConfiguration;
+	device->registers[0x06] = ConversionReadyFlag;
+	
+	*ret_handle = device;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+	delete handle;
+	return ESP_OK;
+}
+
+//========================================
+
+// First byte sets register pointer, following two are written to the register MSB first
+extern "C" esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, int /*xfer_timeout_ms*/)
+{
+	if (!write_size)
+		return ESP_ERR_INVALID_ARG;
+	
+	i2c_dev->pointer = write_buffer[0];
+	if (write_size >= 3)
+		WriteRegister(i2c_dev, write_buffer[1] << 8 | write_buffer[2]);
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t* read_buffer, size_t read_size, int /*xfer_timeout_ms*/)
+{
+	uint16_t value = ReadRegister(i2c_dev);
+	for (size_t i = 0; i < read_size; i++)
+		read_buffer[i] = i % 2? value & 0xFF: value >> 8;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+	if (esp_err_t error = i2c_master_transmit(i2c_dev, write_buffer, write_size, xfer_timeout_ms); error != ESP_OK)
+		return error;
+	
+	return i2c_master_receive(i2c_dev, read_buffer, read_size, xfer_timeout_ms);
+}
+
+//========================================
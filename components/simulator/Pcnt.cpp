@@ -0,0 +1,291 @@
+#include "esp_log.h"
+
+#include "driver/pulse_cnt.h"
+
+#include <array>
+#include <mutex>
+#include <algorithm>
+
+#include <SimulatorInternal.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+// Counting is done synchronously whenever an input level changes, glitch filter is not emulated
+// since simulated inputs never bounce
+
+struct pcnt_chan_t
+{
+	pcnt_unit_t* unit = nullptr;
+	
+	pcnt_chan_config_t config {};
+	
+	pcnt_channel_edge_action_t  pos_action  = PCNT_CHANNEL_EDGE_ACTION_HOLD;
+	pcnt_channel_edge_action_t  neg_action  = PCNT_CHANNEL_EDGE_ACTION_HOLD;
+	pcnt_channel_level_action_t high_action = PCNT_CHANNEL_LEVEL_ACTION_KEEP;
+	pcnt_channel_level_action_t low_action  = PCNT_CHANNEL_LEVEL_ACTION_KEEP;
+};
+
+struct pcnt_unit_t
+{
+	pcnt_unit_config_t config {};
+	
+	std::array<pcnt_chan_t*, 2> channels {};
+	
+	bool enabled = false;
+	bool running = false;
+	
+	int count       = 0;
+	int accumulated = 0;
+};
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+std::mutex s_mutex;
+std::array<pcnt_unit_t*, 8> s_units {};
+
+int Apply(pcnt_channel_edge_action_t edge_action, pcnt_channel_level_action_t level_action)
+{
+	int step = 0;
+	switch (edge_action)
+	{
+		case PCNT_CHANNEL_EDGE_ACTION_INCREASE: step =  1; break;
+		case PCNT_CHANNEL_EDGE_ACTION_DECREASE: step = -1; break;
+		default:                                           break;
+	}
+	
+	switch (level_action)
+	{
+		case PCNT_CHANNEL_LEVEL_ACTION_INVERSE: return -step;
+		case PCNT_CHANNEL_LEVEL_ACTION_HOLD:    return 0;
+		default:                                return step;
+	}
+}
+
+void Count(pcnt_unit_t& unit, int step)
+{
+	unit.count += step;
+	
+	// Counter is reset once it reaches a limit, the driver accumulates the limit value
+	if (unit.count >= unit.config.high_limit || unit.count <= unit.config.low_limit)
+	{
+		if (unit.config.flags.accum_count)
+			unit.accumulated += unit.count;
+		
+		unit.count = 0;
+	}
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+void Simulator::UpdatePulseCounters(gpio_num_t pin, bool level)
+{
+	std::lock_guard lock(s_mutex);
+	
+	for (auto* unit: s_units)
+	{
+		if (!unit || !unit->running)
+			continue;
+		
+		for (auto* channel: unit->channels)
+		{
+			if (!channel || channel->config.edge_gpio_num != pin)
+				continue;
+			
+			bool edge = level ^ channel->config.flags.invert_edge_input;
+			bool level_input = GetLevel(static_cast<gpio_num_t>(channel->config.level_gpio_num)) ^ channel->config.flags.invert_level_input;
+			
+			Count(
+				*unit,
+				Apply(
+					edge? channel->pos_action: channel->neg_action,
+					level_input? channel->high_action: channel->low_action
+				)
+			);
+		}
+	}
+}
+
+//========================================
+
+extern "C" esp_err_t pcnt_new_unit(const pcnt_unit_config_t* config, pcnt_unit_handle_t* ret_unit)
+{
+	if (!config || !ret_unit || config->low_limit >= 0 || config->high_limit <= 0)
+		return ESP_ERR_INVALID_ARG;
+	
+	std::lock_guard lock(s_mutex);
+	
+	auto slot = std::ranges::find(s_units, nullptr);
+	if (slot == s_units.end())
+	{
+		ESP_LOGE(TAG, "no free pulse counter units");
+		return ESP_ERR_NOT_FOUND;
+	}
+	
+	*slot = new pcnt_unit_t;
+	(*slot)->config = *config;
+	
+	*ret_unit = *slot;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_del_unit(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	auto slot = std::ranges::find(s_units, unit);
+	if (slot == s_units.end() || unit->enabled || std::ranges::any_of(unit->channels, std::identity()))
+		return ESP_ERR_INVALID_STATE;
+	
+	*slot = nullptr;
+	delete unit;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_set_glitch_filter(pcnt_unit_handle_t unit, const pcnt_glitch_filter_config_t* config)
+{
+	// Hardware filter threshold is 10 bits of APB cycles
+	if (!unit || (config && config->max_glitch_ns > 1023 * 1000 / 80))
+		return ESP_ERR_INVALID_ARG;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_enable(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	if (unit->enabled)
+		return ESP_ERR_INVALID_STATE;
+	
+	unit->enabled = true;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_disable(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	if (!unit->enabled)
+		return ESP_ERR_INVALID_STATE;
+	
+	unit->enabled = false;
+	unit->running = false;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_start(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	if (!unit->enabled)
+		return ESP_ERR_INVALID_STATE;
+	
+	unit->running = true;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_stop(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	if (!unit->enabled)
+		return ESP_ERR_INVALID_STATE;
+	
+	unit->running = false;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_clear_count(pcnt_unit_handle_t unit)
+{
+	std::lock_guard lock(s_mutex);
+	
+	unit->count = 0;
+	unit->accumulated = 0;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_get_count(pcnt_unit_handle_t unit, int* value)
+{
+	if (!unit || !value)
+		return ESP_ERR_INVALID_ARG;
+	
+	std::lock_guard lock(s_mutex);
+	
+	*value = unit->accumulated + unit->count;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_unit_add_watch_point(pcnt_unit_handle_t unit, int watch_point)
+{
+	if (!unit || watch_point < unit->config.low_limit || watch_point > unit->config.high_limit)
+		return ESP_ERR_INVALID_ARG;
+	
+	return ESP_OK;
+}
+
+//========================================
+
+extern "C" esp_err_t pcnt_new_channel(pcnt_unit_handle_t unit, const pcnt_chan_config_t* config, pcnt_channel_handle_t* ret_chan)
+{
+	if (!unit || !config || !ret_chan)
+		return ESP_ERR_INVALID_ARG;
+	
+	std::lock_guard lock(s_mutex);
+	
+	auto slot = std::ranges::find(unit->channels, nullptr);
+	if (slot == unit->channels.end())
+		return ESP_ERR_NOT_FOUND;
+	
+	*slot = new pcnt_chan_t;
+	(*slot)->unit = unit;
+	(*slot)->config = *config;
+	
+	*ret_chan = *slot;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_del_channel(pcnt_channel_handle_t chan)
+{
+	std::lock_guard lock(s_mutex);
+	
+	*std::ranges::find(chan->unit->channels, chan) = nullptr;
+	delete chan;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_channel_set_edge_action(pcnt_channel_handle_t chan, pcnt_channel_edge_action_t pos_act, pcnt_channel_edge_action_t neg_act)
+{
+	std::lock_guard lock(s_mutex);
+	
+	chan->pos_action = pos_act;
+	chan->neg_action = neg_act;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t pcnt_channel_set_level_action(pcnt_channel_handle_t chan, pcnt_channel_level_action_t high_act, pcnt_channel_level_action_t low_act)
+{
+	std::lock_guard lock(s_mutex);
+	
+	chan->high_action = high_act;
+	chan->low_action = low_act;
+	
+	return ESP_OK;
+}
+
+//========================================
@@ -0,0 +1,239 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sdkconfig.h"
+
+#include "rom/ets_sys.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <SimulatorInternal.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+const char* Simulator::GetEnvironment(const char* name)
+{
+	const char* value = std::getenv(name);
+	return value && *value? value: nullptr;
+}
+
+double Simulator::GetTime()
+{
+	return esp_timer_get_time() / 1'000'000.0;
+}
+
+//======================================== Tasks
+
+extern "C" BaseType_t __real_xTaskCreatePinnedToCore(
+	TaskFunction_t task_function,
+	const char*    name,
+	uint32_t       stack_depth,
+	void*          parameters,
+	UBaseType_t    priority,
+	TaskHandle_t*  created_task,
+	BaseType_t     core_id
+);
+
+// Linux port is single core, so pinning is dropped; priorities are capped by the creator's
+// priority, otherwise busy-waiting tasks that rely on running on a core of their own would
+// starve everything else instead of being time sliced
+extern "C" BaseType_t __wrap_xTaskCreatePinnedToCore(
+	TaskFunction_t task_function,
+	const char*    name,
+	uint32_t       stack_depth,
+	void*          parameters,
+	UBaseType_t    priority,
+	TaskHandle_t*  created_task,
+	BaseType_t     /*core_id*/
+)
+{
+	return __real_xTaskCreatePinnedToCore(
+		task_function,
+		name,
+		std::max<uint32_t>(stack_depth, configMINIMAL_STACK_SIZE),
+		parameters,
+		std::min(priority, uxTaskPriorityGet(nullptr)),
+		created_task,
+		tskNO_AFFINITY
+	);
+}
+
+extern "C" void ets_delay_us(uint32_t us)
+{
+	auto end_time = esp_timer_get_time() + us;
+	while (esp_timer_get_time() < end_time);
+}
+
+//======================================== Encoder script
+
+namespace
+{
+
+//========================================
+
+struct ScriptStep
+{
+	enum Action
+	{
+		Clockwise,
+		CounterClockwise,
+		Press,
+		Release,
+		Click,
+		Exit
+	};
+	
+	int64_t time_ms;
+	Action  action;
+	int     count;
+};
+
+std::vector<ScriptStep> s_script {};
+
+//========================================
+
+void Rotate(bool clockwise, int count)
+{
+	constexpr auto pin_a = static_cast<gpio_num_t>(CONFIG_ENCODER_PIN_A);
+	constexpr auto pin_b = static_cast<gpio_num_t>(CONFIG_ENCODER_PIN_B);
+	
+	// Quadrature sequence of one clockwise detent starting from the idle state (both pins pulled up),
+	// counterclockwise one is the same with pins swapped
+	constexpr bool sequence[4][2] = {
+		{ true,  false },
+		{ false, false },
+		{ false, true  },
+		{ true,  true  }
+	};
+	
+	for (int detent = 0; detent < count; detent++)
+	{
+		for (const auto& state: sequence)
+		{
+			bool a = clockwise? state[0]: state[1];
+			bool b = clockwise? state[1]: state[0];
+			
+			if (Simulator::GetLevel(pin_a) != a)
+				Simulator::SetInputLevel(pin_a, a);
+			
+			if (Simulator::GetLevel(pin_b) != b)
+				Simulator::SetInputLevel(pin_b, b);
+			
+			vTaskDelay(1);
+		}
+	}
+}
+
+void ScriptLoop(void*)
+{
+	constexpr auto pin_press = static_cast<gpio_num_t>(CONFIG_ENCODER_PIN_PRESS);
+	
+	auto start_time_ms = esp_timer_get_time() / 1000;
+	for (const auto& step: s_script)
+	{
+		if (auto delay_ms = start_time_ms + step.time_ms - esp_timer_get_time() / 1000; delay_ms > 0)
+			vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(delay_ms)));
+		
+		switch (step.action)
+		{
+			case ScriptStep::Clockwise:
+			case ScriptStep::CounterClockwise:
+				Rotate(step.action == ScriptStep::Clockwise, step.count);
+				break;
+			
+			case ScriptStep::Press:
+				Simulator::SetInputLevel(pin_press, false);
+				break;
+			
+			case ScriptStep::Release:
+				Simulator::SetInputLevel(pin_press, true);
+				break;
+			
+			case ScriptStep::Click:
+				Simulator::SetInputLevel(pin_press, false);
+				vTaskDelay(pdMS_TO_TICKS(50));
+				Simulator::SetInputLevel(pin_press, true);
+				break;
+			
+			case ScriptStep::Exit:
+				ESP_LOGI(TAG, "encoder script requested exit");
+				std::exit(0);
+		
+		}
+	}
+	
+	vTaskDelete(nullptr);
+}
+
+//========================================
+
+} // namespace
+
+void Simulator::StartEncoderScript()
+{
+	const char* path = GetEnvironment("SIM_ENCODER_SCRIPT");
+	if (!path)
+		return;
+	
+	std::ifstream file(path);
+	if (!file)
+	{
+		ESP_LOGE(TAG, "failed to open encoder script '%s'", path);
+		return;
+	}
+	
+	std::string line;
+	for (size_t line_number = 1; std::getline(file, line); line_number++)
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+		
+		std::istringstream stream(line);
+		
+		ScriptStep step = {};
+		std::string action;
+		
+		if (!(stream >> step.time_ms >> action))
+		{
+			ESP_LOGE(TAG, "encoder script '%s':%zu: expected time and action", path, line_number);
+			continue;
+		}
+		
+		if (!(stream >> step.count))
+			step.count = 1;
+		
+		if      (action == "cw"     ) step.action = ScriptStep::Clockwise;
+		else if (action == "ccw"    ) step.action = ScriptStep::CounterClockwise;
+		else if (action == "press"  ) step.action = ScriptStep::Press;
+		else if (action == "release") step.action = ScriptStep::Release;
+		else if (action == "click"  ) step.action = ScriptStep::Click;
+		else if (action == "exit"   ) step.action = ScriptStep::Exit;
+		
+		else
+		{
+			ESP_LOGE(TAG, "encoder script '%s':%zu: unknown action '%s'", path, line_number, action.c_str());
+			continue;
+		}
+		
+		s_script.push_back(step);
+	}
+	
+	std::ranges::stable_sort(s_script, {}, &ScriptStep::time_ms);
+	ESP_LOGI(TAG, "loaded encoder script '%s': %zu steps", path, s_script.size());
+	
+	xTaskCreatePinnedToCore(ScriptLoop, "Encoder script", 4096, nullptr, uxTaskPriorityGet(nullptr), nullptr, tskNO_AFFINITY);
+}
+
+//========================================
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "driver/gpio.h"
+
+#include <span>
+#include <cstdint>
+
+//========================================
+
+namespace Simulator
+{
+
+//========================================
+
+// Returns nullptr if the variable is not set
+const char* GetEnvironment(const char* name);
+
+// Current simulation time in seconds
+double GetTime();
+
+// Changes level of an input pin, invoking its interrupt handler like the GPIO ISR service would
+void SetInputLevel(gpio_num_t pin, bool level);
+bool GetLevel(gpio_num_t pin);
+
+// Counts the edge on every pulse counter channel attached to the pin
+void UpdatePulseCounters(gpio_num_t pin, bool level);
+
+// Runs SIM_ENCODER_SCRIPT in a separate task
+void StartEncoderScript();
+
+// Bytes sent to the display controller, D/C pin selects between commands and display data
+void WriteDisplay(std::span<const uint8_t> bytes, bool data);
+
+//========================================
+
+} // namespace Simulator
+
+//========================================
@@ -0,0 +1,124 @@
+#include "sdkconfig.h"
+
+#include "driver/spi_master.h"
+
+#include <deque>
+#include <span>
+
+#include <SimulatorInternal.hpp>
+
+//========================================
+
+struct spi_device_t
+{
+	spi_device_interface_config_t  config;
+	std::deque<spi_transaction_t*> results;
+};
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+bool s_bus_initialized[SPI_HOST_MAX] = {};
+
+void Transmit(spi_device_handle_t handle, spi_transaction_t* transaction)
+{
+	if (handle->config.pre_cb)
+		handle->config.pre_cb(transaction);
+	
+	const auto* data = transaction->flags & SPI_TRANS_USE_TXDATA
+		? transaction->tx_data
+		: static_cast<const uint8_t*>(transaction->tx_buffer);
+	
+	// Display controller is the only device on the bus
+	Simulator::WriteDisplay(
+		std::span(data, (transaction->length + 7) / 8),
+		Simulator::GetLevel(static_cast<gpio_num_t>(CONFIG_DISPLAY_PIN_DC))
+	);
+	
+	if (handle->config.post_cb)
+		handle->config.post_cb(transaction);
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+extern "C" esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* /*bus_config*/, spi_common_dma_t /*dma_chan*/)
+{
+	if (s_bus_initialized[host_id])
+		return ESP_ERR_INVALID_STATE;
+	
+	s_bus_initialized[host_id] = true;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+	s_bus_initialized[host_id] = false;
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle)
+{
+	if (!s_bus_initialized[host_id])
+		return ESP_ERR_INVALID_STATE;
+	
+	*handle = new spi_device_t { *dev_config, {} };
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+	delete handle;
+	return ESP_OK;
+}
+
+//========================================
+
+extern "C" esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc)
+{
+	Transmit(handle, trans_desc);
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc)
+{
+	Transmit(handle, trans_desc);
+	return ESP_OK;
+}
+
+// Queued transactions are completed right away
+extern "C" esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t /*ticks_to_wait*/)
+{
+	Transmit(handle, trans_desc);
+	handle->results.push_back(trans_desc);
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t /*ticks_to_wait*/)
+{
+	if (handle->results.empty())
+		return ESP_ERR_TIMEOUT;
+	
+	*trans_desc = handle->results.front();
+	handle->results.pop_front();
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_acquire_bus(spi_device_handle_t /*device*/, TickType_t /*wait*/)
+{
+	return ESP_OK;
+}
+
+extern "C" void spi_device_release_bus(spi_device_handle_t /*dev*/)
+{}
+
+//========================================
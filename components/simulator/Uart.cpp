@@ -0,0 +1,138 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "driver/uart.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+// Master side of the pseudo terminal of every installed port, -1 if not installed
+std::array<int, UART_NUM_MAX> s_terminals = { -1, -1, -1 };
+
+int GetTerminal(uart_port_t port)
+{
+	return port < UART_NUM_MAX? s_terminals[port]: -1;
+}
+
+//========================================
+
+} // namespace
+
+//========================================
+
+// Host side opens the printed terminal like a serial port, baud rate and pins do not matter
+extern "C" esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, void* uart_queue, int intr_alloc_flags)
+{
+	if (uart_num >= UART_NUM_MAX || s_terminals[uart_num] != -1)
+		return ESP_ERR_INVALID_ARG;
+	
+	int terminal = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (terminal < 0 || grantpt(terminal) || unlockpt(terminal))
+	{
+		ESP_LOGE(TAG, "failed to open a pseudo terminal for UART%d", uart_num);
+		return ESP_FAIL;
+	}
+	
+	// Raw, so that binary data passes unchanged
+	termios attributes = {};
+	tcgetattr(terminal, &attributes);
+	cfmakeraw(&attributes);
+	tcsetattr(terminal, TCSANOW, &attributes);
+	
+	s_terminals[uart_num] = terminal;
+	ESP_LOGI(TAG, "UART%d is at %s", uart_num, ptsname(terminal));
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+	int terminal = GetTerminal(uart_num);
+	if (terminal < 0)
+		return ESP_ERR_INVALID_STATE;
+	
+	close(terminal);
+	s_terminals[uart_num] = -1;
+	
+	return ESP_OK;
+}
+
+extern "C" esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t* uart_config)
+{
+	return GetTerminal(uart_num) < 0? ESP_ERR_INVALID_STATE: ESP_OK;
+}
+
+extern "C" esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+	return GetTerminal(uart_num) < 0? ESP_ERR_INVALID_STATE: ESP_OK;
+}
+
+// Blocking read would stall every task of the Linux port, so the terminal is polled once per tick instead
+extern "C" int uart_read_bytes(uart_port_t uart_num, void* buf, uint32_t length, TickType_t ticks_to_wait)
+{
+	int terminal = GetTerminal(uart_num);
+	if (terminal < 0)
+		return -1;
+	
+	auto start = xTaskGetTickCount();
+	while (true)
+	{
+		ssize_t count = read(terminal, buf, length);
+		if (count > 0)
+			return count;
+		
+		// Also when no client has the terminal open yet
+		if (count < 0 && errno != EAGAIN && errno != EIO)
+			return -1;
+		
+		if (xTaskGetTickCount() - start >= ticks_to_wait)
+			return 0;
+		
+		vTaskDelay(1);
+	}
+}
+
+// Waits for the client to take the data instead of dropping it, like the driver blocks on a full buffer
+extern "C" int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size)
+{
+	int terminal = GetTerminal(uart_num);
+	if (terminal < 0)
+		return -1;
+	
+	const auto* bytes = static_cast<const uint8_t*>(src);
+	size_t written = 0;
+	while (written < size)
+	{
+		ssize_t count = write(terminal, bytes + written, size - written);
+		if (count > 0)
+			written += count;
+		
+		else if (count < 0 && errno != EAGAIN)
+			return -1;
+		
+		else
+			vTaskDelay(1);
+	}
+	
+	return written;
+}
+
+//========================================
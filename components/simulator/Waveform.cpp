@@ -0,0 +1,92 @@
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <Waveform.hpp>
+
+//========================================
+
+static const char* TAG = "sim";
+
+//========================================
+
+bool Waveform::load(const char* path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		ESP_LOGE(TAG, "failed to open waveform '%s'", path);
+		return false;
+	}
+	
+	m_times.clear();
+	m_values.clear();
+	m_columns = 0;
+	
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+		
+		std::istringstream stream(line);
+		
+		double time = 0;
+		if (!(stream >> time))
+			continue;
+		
+		size_t columns = 0;
+		for (double value = 0; stream >> value; columns++)
+			m_values.push_back(value);
+		
+		if (m_columns && columns != m_columns)
+		{
+			ESP_LOGE(TAG, "waveform '%s': inconsistent column count", path);
+			m_times.clear();
+			return false;
+		}
+		
+		if (!m_times.empty() && time <= m_times.back())
+		{
+			ESP_LOGE(TAG, "waveform '%s': time must be increasing", path);
+			m_times.clear();
+			return false;
+		}
+		
+		m_columns = columns;
+		m_times.push_back(time);
+	}
+	
+	ESP_LOGI(TAG, "loaded waveform '%s': %zu points", path, m_times.size());
+	return isLoaded();
+}
+
+bool Waveform::isLoaded() const
+{
+	return !m_times.empty();
+}
+
+double Waveform::sample(double time, size_t column) const
+{
+	if (m_times.empty() || column >= m_columns)
+		return 0;
+	
+	if (double period = m_times.back() - m_times.front(); period > 0)
+		time = m_times.front() + std::fmod(time, period);
+	
+	auto next = std::ranges::upper_bound(m_times, time) - m_times.begin();
+	if (next == 0)
+		return m_values[column];
+	
+	if (next == static_cast<ptrdiff_t>(m_times.size()))
+		return m_values[(next - 1) * m_columns + column];
+	
+	double t = (time - m_times[next - 1]) / (m_times[next] - m_times[next - 1]);
+	return std::lerp(m_values[(next - 1) * m_columns + column], m_values[next * m_columns + column], t);
+}
+
+//========================================
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//========================================
+
+// Tabulated signal loaded from a text file
+// Every line holds time in seconds followed by values of each column
+class Waveform
+{
+public:
+	Waveform() = default;
+	
+	bool load(const char* path);
+	bool isLoaded() const;
+	
+	// Linearly interpolated value, waveform is looped over its duration
+	double sample(double time, size_t column) const;
+	
+private:
+	std::vector<double> m_times   {};
+	std::vector<double> m_values  {};
+	size_t              m_columns = 0;
+	
+};
+
+//========================================
@@ -0,0 +1,24 @@
+#pragma once
+
+//========================================
+
+// Host simulator of the oscilloscope hardware
+//
+// Building:
+//     idf.py --preview set-target linux
+//     idf.py build
+//     ./build/oscilloscope.elf
+//
+// Runtime configuration is read from the environment:
+//     SIM_FRAMES_DIR      - directory to write every display frame to as PBM, frames are not saved if unset
+//     SIM_FRAME_LIMIT     - exits after this amount of frames
+//     SIM_INA226_WAVEFORM - waveform file replayed by INA226 (columns: time s, bus voltage V, shunt voltage mV)
+//     SIM_ADC_WAVEFORM    - waveform file replayed by internal ADC (columns: time s, voltage mV)
+//     SIM_ENCODER_SCRIPT  - rotary encoder script (lines: time ms, cw|ccw|press|release|click|exit, optional count)
+//
+// Every installed UART is a pseudo terminal, its path is logged at startup.
+//
+// Waveform files are whitespace separated text, lines starting with '#' are ignored.
+// Waveforms are linearly interpolated and looped. Built-in test signals are used when files are not set.
+
+//========================================
@@ -0,0 +1,53 @@
+#pragma once
+
+// Simulated subset of ESP-IDF SPI driver
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//========================================
+
+typedef enum
+{
+	SPI1_HOST = 0,
+	SPI2_HOST = 1,
+	SPI3_HOST = 2,
+	SPI_HOST_MAX
+} spi_host_device_t;
+
+typedef enum
+{
+	SPI_DMA_DISABLED = 0,
+	SPI_DMA_CH1      = 1,
+	SPI_DMA_CH2      = 2,
+	SPI_DMA_CH_AUTO  = 3
+} spi_common_dma_t;
+
+typedef struct
+{
+	int      mosi_io_num;
+	int      miso_io_num;
+	int      sclk_io_num;
+	int      quadwp_io_num;
+	int      quadhd_io_num;
+	int      max_transfer_sz;
+	uint32_t flags;
+	int      intr_flags;
+} spi_bus_config_t;
+
+//========================================
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, spi_common_dma_t dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host_id);
+
+//========================================
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// Simulated subset of ESP-IDF ADC calibration driver
+
+#include "esp_adc/adc_oneshot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//========================================
+
+typedef struct adc_cali_scheme_t* adc_cali_handle_t;
+
+typedef enum
+{
+	ADC_CALI_SCHEME_VER_LINE_FITTING = 1 << 0
+} adc_cali_scheme_ver_t;
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int* voltage);
+
+//========================================
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "esp_adc/adc_cali_scheme.h"
@@ -0,0 +1,19 @@
+#pragma once
+
+// Simulated subset of ESP32 ROM functions
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//========================================
+
+void ets_delay_us(uint32_t us);
+
+//========================================
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+
+#include <Arena.hpp>
+
+//========================================
+
+Arena::~Arena()
+{
+	heap_caps_free(m_data);
+}
+
+//========================================
+
+void Arena::setup(size_t capacity)
+{
+	m_data = reinterpret_cast<uint8_t*>(heap_caps_malloc(capacity, MALLOC_CAP_8BIT));
+	ESP_ERROR_CHECK(m_data? ESP_OK: ESP_ERR_NO_MEM);
+	
+	m_capacity = capacity;
+	m_used = 0;
+}
+
+void Arena::reset()
+{
+	m_used = 0;
+}
+
+size_t Arena::getCapacity() const
+{
+	return m_capacity;
+}
+
+size_t Arena::getUsed() const
+{
+	return m_used;
+}
+
+//========================================
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+//========================================
+
+// Bump allocator over a single block taken from the heap at boot; allocations are only ever released all at once,
+// so buffers whose sizes follow the configuration reuse the same memory instead of fragmenting the heap over time
+class Arena
+{
+public:
+	Arena() = default;
+	Arena(const Arena& copy) = delete;
+	~Arena();
+	
+	void setup(size_t capacity);
+	
+	// Uninitialized, empty if it does not fit
+	template<typename T>
+	std::span<T> allocate(size_t count);
+	
+	// Everything allocated so far is invalidated
+	void reset();
+	
+	size_t getCapacity() const;
+	size_t getUsed() const;
+	
+private:
+	uint8_t* m_data     = nullptr;
+	size_t   m_capacity = 0;
+	size_t   m_used     = 0;
+	
+};
+
+//========================================
+
+template<typename T>
+std::span<T> Arena::allocate(size_t count)
+{
+	static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without calling destructors");
+	
+	size_t begin = (m_used + alignof(T) - 1) & ~(alignof(T) - 1);
+	if (begin > m_capacity || count > (m_capacity - begin) / sizeof(T))
+		return {};
+	
+	m_used = begin + count * sizeof(T);
+	
+	auto* data = reinterpret_cast<T*>(m_data + begin);
+	std::uninitialized_default_construct_n(data, count);
+	
+	return std::span(data, count);
+}
+
+//========================================
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+//========================================
+
+// Lock-free single producer, single consumer queue of pointers, used to hand blocks over between pipeline stages
+// Each index has a single writer; the release store of the tail publishes the slot along with everything written
+// to the block before it was pushed, so ownership of the block passes to the consumer with the pointer
+template<typename T, size_t N>
+class BlockQueue
+{
+public:
+	static_assert((N & (N - 1)) == 0, "queue capacity must be a power of two");
+	
+	BlockQueue() = default;
+	BlockQueue(const BlockQueue& copy) = delete;
+	
+	// Producer side, false if full
+	bool push(T* block);
+	
+	// Consumer side, null if empty
+	T* pop();
+	
+	size_t getSize() const;
+	
+private:
+	std::array<T*, N> m_slots {};
+	
+	std::atomic<uint32_t> m_head = 0; // Written by the consumer
+	std::atomic<uint32_t> m_tail = 0; // Written by the producer
+	
+};
+
+//========================================
+
+template<typename T, size_t N>
+bool BlockQueue<T, N>::push(T* block)
+{
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail - m_head.load(std::memory_order_acquire) == N)
+		return false;
+	
+	m_slots[tail & (N - 1)] = block;
+	m_tail.store(tail + 1, std::memory_order_release);
+	
+	return true;
+}
+
+template<typename T, size_t N>
+T* BlockQueue<T, N>::pop()
+{
+	uint32_t head = m_head.load(std::memory_order_relaxed);
+	if (head == m_tail.load(std::memory_order_acquire))
+		return nullptr;
+	
+	T* block = m_slots[head & (N - 1)];
+	m_head.store(head + 1, std::memory_order_release);
+	
+	return block;
+}
+
+template<typename T, size_t N>
+size_t BlockQueue<T, N>::getSize() const
+{
+	return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+}
+
+//========================================
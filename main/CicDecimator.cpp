@@ -0,0 +1,72 @@
+#include <algorithm>
+
+#include <CicDecimator.hpp>
+
+//========================================
+
+void CicDecimator::setup(uint32_t decimation)
+{
+	m_decimation = std::clamp<uint32_t>(decimation, 1, s_max_decimation);
+	
+	m_gain = 1;
+	for (size_t stage = 0; stage < s_stages; stage++)
+		m_gain *= m_decimation;
+	
+	m_integrators.fill(0);
+	m_combs.fill(0);
+	m_history.fill(0);
+	
+	m_input_count = 0;
+	m_output_count = 0;
+	m_output = 0;
+}
+
+bool CicDecimator::add(uint32_t input)
+{
+	uint64_t value = input;
+	for (auto& integrator: m_integrators)
+		value = integrator += value;
+	
+	if (++m_input_count < m_decimation)
+		return false;
+	
+	m_input_count = 0;
+	
+	for (auto& comb: m_combs)
+	{
+		uint64_t previous = comb;
+		comb = value;
+		value -= previous;
+	}
+	
+	// Combs start from zero history, outputs are only valid once every stage has seen a full one
+	if (++m_output_count <= s_stages)
+		return false;
+	
+	int32_t output = (value << s_fraction_bits) / m_gain;
+	
+	// First valid output fills the compensation history, so that it starts without a step
+	if (m_output_count == s_stages + 1)
+		m_history.fill(output);
+	
+	std::shift_right(m_history.begin(), m_history.end(), 1);
+	m_history[0] = output;
+	
+	// Sharpening filter [-3, 22, -3] / 16 lifts the passband back by the droop of three stages at a quarter
+	// of the output rate, at the cost of a single output of delay
+	m_output = (22 * m_history[1] - 3 * (m_history[0] + m_history[2])) / 16;
+	
+	return true;
+}
+
+int32_t CicDecimator::getOutput() const
+{
+	return m_output;
+}
+
+uint32_t CicDecimator::getDecimation() const
+{
+	return m_decimation;
+}
+
+//========================================
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+//========================================
+
+// Cascaded integrator-comb decimator with a droop compensation filter at the output rate
+// Integrators run on every input and only add, combs and compensation run once per output; registers wrap around,
+// which is fine as long as they hold input bits + stages * log2(decimation), 36 for 12 bit input at the maximum
+// Averaging decimation inputs gains half a bit of resolution per doubling on a noisy input, so the output keeps
+// a fraction of the input unit
+class CicDecimator
+{
+public:
+	static constexpr size_t   s_stages         = 3;
+	static constexpr uint32_t s_max_decimation = 256;
+	static constexpr int      s_fraction_bits  = 8; // Of the output
+	
+	CicDecimator() = default;
+	CicDecimator(const CicDecimator& copy) = delete;
+	
+	// Resets the state, the first outputs are held back until the combs have settled
+	void setup(uint32_t decimation);
+	
+	// Returns true once there is a new output
+	bool add(uint32_t input);
+	
+	// Latest output in input units with s_fraction_bits fraction bits
+	int32_t getOutput() const;
+	
+	uint32_t getDecimation() const;
+	
+private:
+	uint32_t m_decimation = 1;
+	uint64_t m_gain       = 1; // Decimation to the power of stages
+	
+	std::array<uint64_t, s_stages> m_integrators {};
+	std::array<uint64_t, s_stages> m_combs       {}; // Previous inputs of every comb
+	
+	uint32_t m_input_count  = 0;
+	uint32_t m_output_count = 0;
+	
+	// Compensation filter inputs, newest first
+	std::array<int32_t, 3> m_history {};
+	int32_t m_output = 0;
+	
+};
+
+//========================================
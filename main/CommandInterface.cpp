@@ -0,0 +1,149 @@
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include <CommandInterface.hpp>
+
+//========================================
+
+static const char* TAG = "commands";
+
+//========================================
+
+CommandInterface::~CommandInterface()
+{
+	if (m_port != UART_NUM_MAX)
+		uart_driver_delete(m_port);
+}
+
+//========================================
+
+void CommandInterface::setup(uart_port_t port, int pin_tx, int pin_rx, int baud_rate)
+{
+	uart_config_t config = {};
+	config.baud_rate = baud_rate;
+	config.data_bits = UART_DATA_8_BITS;
+	config.parity = UART_PARITY_DISABLE;
+	config.stop_bits = UART_STOP_BITS_1;
+	config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+	config.source_clk = UART_SCLK_DEFAULT;
+	
+	ESP_ERROR_CHECK(uart_driver_install(port, s_rx_buffer_size, s_tx_buffer_size, 0, nullptr, 0));
+	ESP_ERROR_CHECK(uart_param_config(port, &config));
+	ESP_ERROR_CHECK(uart_set_pin(port, pin_tx, pin_rx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+	
+	m_port = port;
+	ESP_LOGI(TAG, "listening on UART%d at %d baud", static_cast<int>(port), baud_rate);
+}
+
+CommandInterface::Command CommandInterface::readCommand()
+{
+	while (true)
+	{
+		char ch = 0;
+		if (uart_read_bytes(m_port, &ch, 1, portMAX_DELAY) != 1)
+			continue;
+		
+		if (ch == '\r')
+			continue;
+		
+		if (ch != '\n')
+		{
+			if (m_line_length < m_line.size())
+				m_line[m_line_length++] = ch;
+			
+			else
+				m_overflow = true;
+			
+			continue;
+		}
+		
+		std::string_view line(m_line.data(), m_line_length);
+		bool overflow = m_overflow;
+		
+		m_line_length = 0;
+		m_overflow = false;
+		
+		if (overflow)
+		{
+			write("ERR line too long\n");
+			continue;
+		}
+		
+		// Empty lines let the client resynchronize
+		if (!Trim(line).empty())
+			return Parse(line);
+	}
+}
+
+void CommandInterface::write(std::string_view text)
+{
+	uart_write_bytes(m_port, text.data(), text.size());
+}
+
+void CommandInterface::write(std::span<const uint8_t> data)
+{
+	uart_write_bytes(m_port, data.data(), data.size());
+}
+
+// Verb is the first word, the rest is the label with an optional value after '='
+CommandInterface::Command CommandInterface::Parse(std::string_view line)
+{
+	constexpr std::pair<std::string_view, Verb> VERBS[] = {
+		{ "ID",     Verb::Id     },
+		{ "LIST",   Verb::List   },
+		{ "GET",    Verb::Get    },
+		{ "SET",    Verb::Set    },
+		{ "RUN",    Verb::Run    },
+		{ "STOP",   Verb::Stop   },
+		{ "SINGLE", Verb::Single },
+		{ "STATUS", Verb::Status },
+		{ "DATA",   Verb::Data   },
+		{ "LOG",    Verb::Log    }
+	};
+	
+	line = Trim(line);
+	
+	size_t verb_end = std::min(line.find(' '), line.size());
+	auto verb = line.substr(0, verb_end);
+	auto arguments = Trim(line.substr(verb_end));
+	
+	Command command = {};
+	for (const auto& [name, value]: VERBS)
+		if (EqualsIgnoreCase(verb, name))
+			command.verb = value;
+	
+	if (size_t separator = arguments.find('='); separator != std::string_view::npos)
+	{
+		command.label = Trim(arguments.substr(0, separator));
+		command.value = Trim(arguments.substr(separator + 1));
+	}
+	
+	else
+		command.label = arguments;
+	
+	return command;
+}
+
+bool CommandInterface::EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+	return std::ranges::equal(
+		a,
+		b,
+		[](char x, char y)
+		{
+			return std::toupper(static_cast<uint8_t>(x)) == std::toupper(static_cast<uint8_t>(y));
+		}
+	);
+}
+
+std::string_view CommandInterface::Trim(std::string_view text)
+{
+	size_t begin = std::min(text.find_first_not_of(' '), text.size());
+	size_t end = text.find_last_not_of(' ') + 1;
+	
+	return text.substr(begin, end - begin);
+}
+
+//========================================
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include "driver/uart.h"
+
+#include <array>
+#include <span>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+//========================================
+
+// Line based remote control over a UART, see tools/oscilloscope_client.py for the host side
+//
+// Requests are single lines, verbs are case insensitive:
+//     ID                    - OK <name>
+//     LIST                  - <label>=<value> line for every setting, then OK
+//     GET <label>           - OK <value>
+//     SET <label>=<value>   - OK, value is either the text shown by the menu or a bare number
+//     RUN | STOP | SINGLE   - OK, single acquires a buffer, or a capture when triggered, then stops
+//     STATUS                - OK RUN|STOP|ARMED
+//     DATA                  - only while stopped: BLOCK <sample count> <volts per code> <sample rate Hz> line,
+//                             then the samples oldest first as SampleCodec blocks, then OK
+//     LOG <tier>[=<time>]   - <time> <channel> <count> <min> <avg> <max> <missed> line for every record of the data
+//                             logger tier (SECONDS, MINUTES or HOURS) from the log time in seconds on, then OK;
+//                             values are in volts for every channel, shunt voltage included, missed are the sample
+//                             periods of the interval without a sample, flash stalls mostly
+//
+// Failed requests are answered with ERR <reason>. Lines are parsed in place, nothing is allocated
+class CommandInterface
+{
+public:
+	static constexpr size_t s_max_line_length = 96;
+	
+	enum class Verb: uint8_t
+	{
+		Invalid,
+		Id,
+		List,
+		Get,
+		Set,
+		Run,
+		Stop,
+		Single,
+		Status,
+		Data,
+		Log
+	};
+	
+	// Views into the line, valid until the next one is read
+	struct Command
+	{
+		Verb             verb;
+		std::string_view label;
+		std::string_view value;
+	};
+	
+	CommandInterface() = default;
+	CommandInterface(const CommandInterface& copy) = delete;
+	~CommandInterface();
+	
+	void setup(uart_port_t port, int pin_tx, int pin_rx, int baud_rate);
+	
+	// Blocks until a whole line is received, lines too long to fit are answered with an error and skipped
+	Command readCommand();
+	
+	void write(std::string_view text);
+	void write(std::span<const uint8_t> data);
+	
+	static Command Parse(std::string_view line);
+	static bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+	
+private:
+	static constexpr size_t s_rx_buffer_size = 1024;
+	static constexpr size_t s_tx_buffer_size = 4096;
+	
+	uart_port_t m_port = UART_NUM_MAX;
+	
+	std::array<char, s_max_line_length> m_line {};
+	size_t m_line_length = 0;
+	bool   m_overflow    = false;
+	
+	static std::string_view Trim(std::string_view text);
+	
+};
+
+//========================================
@@ -0,0 +1,456 @@
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <DataLogger.hpp>
+
+//========================================
+
+static const char* TAG = "logger";
+
+//======================================== Initialization
+
+void DataLogger::setup(const char* partition_label /*= "datalog"*/)
+{
+	m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+	if (!m_partition)
+	{
+		ESP_LOGE(TAG, "partition '%s' not found, logging is disabled", partition_label);
+		return;
+	}
+	
+	// Coarser tiers get smaller rings, but cover much longer periods
+	size_t sector_count = m_partition->size / s_sector_size;
+	size_t hour_sectors = std::max<size_t>(2, sector_count / 16);
+	size_t minute_sectors = std::max<size_t>(2, sector_count / 4);
+	
+	if (sector_count < hour_sectors + minute_sectors + 2)
+	{
+		ESP_LOGE(TAG, "partition '%s' is too small, logging is disabled", partition_label);
+		m_partition = nullptr;
+		return;
+	}
+	
+	m_rings[Seconds].first_sector = 0;
+	m_rings[Seconds].sector_count = sector_count - minute_sectors - hour_sectors;
+	m_rings[Minutes].first_sector = m_rings[Seconds].sector_count;
+	m_rings[Minutes].sector_count = minute_sectors;
+	m_rings[Hours  ].first_sector = m_rings[Minutes].first_sector + minute_sectors;
+	m_rings[Hours  ].sector_count = hour_sectors;
+	
+	// Sampling has not started yet, so the spares are erased right away
+	for (uint8_t tier = 0; tier < TierCount; tier++)
+	{
+		auto& ring = m_rings[tier];
+		recover(ring, static_cast<Tier>(tier));
+		
+		while (ring.spares < GetSpareTarget(ring))
+			eraseSpare(ring);
+	}
+	
+	m_mutex = xSemaphoreCreateMutex();
+	m_queue = xQueueCreate(32, sizeof(Record));
+	
+	xTaskCreatePinnedToCore(
+		[](void* arg)
+		{
+			reinterpret_cast<DataLogger*>(arg)->writerLoop();
+		},
+		"Data logger",
+		4096,
+		this,
+		tskIDLE_PRIORITY + 1,
+		nullptr,
+		0 // CPU0
+	);
+	
+	ESP_LOGI(
+		TAG,
+		"logging to '%s': %zu/%zu/%zu sectors, log time resumes at %" PRIu32 " s",
+		partition_label,
+		m_rings[Seconds].sector_count,
+		m_rings[Minutes].sector_count,
+		m_rings[Hours  ].sector_count,
+		m_time_base
+	);
+}
+
+//======================================== Sampling side
+
+void DataLogger::addSample(Sample value, uint16_t missed, uint8_t channel, float lsb, int64_t time_us)
+{
+	if (!m_queue)
+		return;
+	
+	if (time_us >= m_next_second_us || channel != m_channel) [[unlikely]]
+		rollover(channel, lsb, time_us);
+	
+	auto& aggregate = m_aggregates[Seconds];
+	aggregate.min = std::min(aggregate.min, value);
+	aggregate.max = std::max(aggregate.max, value);
+	aggregate.sum += value;
+	aggregate.count++;
+	aggregate.missed += missed;
+}
+
+void DataLogger::rollover(uint8_t channel, float lsb, int64_t time_us)
+{
+	uint32_t timestamp = m_time_base + static_cast<uint32_t>(time_us / 1'000'000);
+	
+	if (!m_started)
+	{
+		for (uint8_t tier = 0; tier < TierCount; tier++)
+			resetAggregate(static_cast<Tier>(tier), timestamp);
+		
+		m_started = true;
+	}
+	
+	// Intervals don't mix channels, so all the pending aggregates are closed early
+	else if (channel != m_channel)
+	{
+		for (uint8_t tier = 0; tier < TierCount; tier++)
+			commit(static_cast<Tier>(tier), timestamp);
+	}
+	
+	else
+	{
+		commit(Seconds, timestamp);
+		
+		for (uint8_t tier = Minutes; tier < TierCount; tier++)
+			if (timestamp >= m_aggregates[tier].timestamp + s_intervals[tier])
+				commit(static_cast<Tier>(tier), timestamp);
+	}
+	
+	m_channel = channel;
+	m_lsb = lsb;
+	m_next_second_us = (time_us / 1'000'000 + 1) * 1'000'000;
+}
+
+void DataLogger::commit(Tier tier, uint32_t timestamp)
+{
+	auto& aggregate = m_aggregates[tier];
+	if (aggregate.count)
+	{
+		Record record = {};
+		record.timestamp = aggregate.timestamp;
+		record.count = aggregate.count;
+		record.min = aggregate.min * m_lsb;
+		record.avg = static_cast<float>(aggregate.sum) / aggregate.count * m_lsb;
+		record.max = aggregate.max * m_lsb;
+		record.tier = tier;
+		record.channel = m_channel;
+		record.missed = std::min<uint32_t>(aggregate.missed, std::numeric_limits<uint16_t>::max());
+		
+		if (xQueueSend(m_queue, &record, 0) != pdPASS)
+			m_dropped_records++;
+		
+		if (tier + 1 < TierCount)
+		{
+			auto& next = m_aggregates[tier + 1];
+			next.min = std::min(next.min, aggregate.min);
+			next.max = std::max(next.max, aggregate.max);
+			next.sum += aggregate.sum;
+			next.count += aggregate.count;
+			next.missed += aggregate.missed;
+		}
+	}
+	
+	resetAggregate(tier, timestamp);
+}
+
+void DataLogger::resetAggregate(Tier tier, uint32_t timestamp)
+{
+	auto& aggregate = m_aggregates[tier];
+	aggregate.min = std::numeric_limits<Sample>::max();
+	aggregate.max = std::numeric_limits<Sample>::min();
+	aggregate.sum = 0;
+	aggregate.count = 0;
+	aggregate.missed = 0;
+	aggregate.timestamp = timestamp - timestamp % s_intervals[tier];
+}
+
+//======================================== Writer side
+
+void DataLogger::writerLoop()
+{
+	while (true)
+	{
+		Record record = {};
+		bool received = xQueueReceive(m_queue, &record, pdMS_TO_TICKS(1000)) == pdPASS;
+		
+		xSemaphoreTake(m_mutex, portMAX_DELAY);
+		
+		if (received)
+			append(m_rings[record.tier], static_cast<Tier>(record.tier), record);
+		
+		// Partial pages are only written when records have been waiting for too long
+		auto current_time = esp_timer_get_time();
+		bool flush_requested = m_flush_requested.exchange(false);
+		
+		for (auto& ring: m_rings)
+			if (ring.staged && (flush_requested || current_time - ring.staged_since_us > s_flush_interval_us))
+				writeStaged(ring);
+		
+		// Paced, a single sector is erased per interval, for the ring with the fewest spares left
+		if (!m_erase_paced)
+		{
+			for (auto& ring: m_rings)
+				while (ring.spares < GetSpareTarget(ring))
+					eraseSpare(ring);
+		}
+		
+		else if (current_time - m_last_erase_us >= s_erase_interval_us)
+		{
+			Ring* neediest = nullptr;
+			for (auto& ring: m_rings)
+				if (ring.spares < GetSpareTarget(ring) && (!neediest || ring.spares < neediest->spares))
+					neediest = &ring;
+			
+			if (neediest)
+				eraseSpare(*neediest);
+		}
+		
+		xSemaphoreGive(m_mutex);
+	}
+}
+
+void DataLogger::recover(Ring& ring, Tier tier)
+{
+	ring.index.assign(ring.sector_count, IndexEntry {});
+	
+	bool found = false;
+	for (size_t sector = 0; sector < ring.sector_count; sector++)
+	{
+		SegmentHeader header = {};
+		ESP_ERROR_CHECK(esp_partition_read(m_partition, getSectorOffset(ring, sector), &header, sizeof(header)));
+		
+		if (header.magic != s_magic || header.version != s_version || header.tier != tier || header.crc != Checksum(header))
+			continue;
+		
+		ring.index[sector] = { header.sequence, header.first_timestamp, header.first_record };
+		if (!found || header.sequence > ring.index[ring.head].sequence)
+		{
+			ring.head = sector;
+			found = true;
+		}
+	}
+	
+	// Pretending that the last sector is full, so the first record opens sector 0
+	if (!found)
+	{
+		ring.head = ring.sector_count - 1;
+		ring.write_offset = getSectorOffset(ring, ring.head) + s_sector_size;
+		ring.next_sequence = 0;
+		ring.next_segment = 1;
+		return;
+	}
+	
+	const auto& head = ring.index[ring.head];
+	ring.next_sequence = head.first_record;
+	ring.next_segment = head.sequence + 1;
+	
+	uint32_t end_timestamp = head.first_timestamp;
+	
+	// Looking for the first erased slot of the head sector
+	auto offset = getSectorOffset(ring, ring.head) + sizeof(SegmentHeader);
+	auto sector_end = getSectorOffset(ring, ring.head) + s_sector_size;
+	
+	for (; offset < sector_end; offset += sizeof(Record))
+	{
+		Record record = {};
+		ESP_ERROR_CHECK(esp_partition_read(m_partition, offset, &record, sizeof(record)));
+		
+		if (record.crc == std::numeric_limits<uint32_t>::max() && record.timestamp == std::numeric_limits<uint32_t>::max())
+			break;
+		
+		// Torn writes are skipped, but the slot can't be reused
+		if (record.crc != Checksum(record))
+			continue;
+		
+		ring.next_sequence = record.sequence + 1;
+		end_timestamp = record.timestamp + s_intervals[tier];
+	}
+	
+	ring.write_offset = offset;
+	m_time_base = std::max(m_time_base, end_timestamp);
+}
+
+void DataLogger::append(Ring& ring, Tier tier, Record record)
+{
+	auto sector_end = getSectorOffset(ring, ring.head) + s_sector_size;
+	if (ring.write_offset + (ring.staged + 1) * sizeof(Record) > sector_end)
+	{
+		writeStaged(ring);
+		
+		// Pacing keeps up with the rings filling, a spare is erased on the spot otherwise rather than dropping records
+		if (!ring.spares)
+			eraseSpare(ring);
+		
+		openSpare(ring, tier, record.timestamp);
+	}
+	
+	record.sequence = ring.next_sequence++;
+	record.crc = Checksum(record);
+	
+	if (!ring.staged)
+		ring.staged_since_us = esp_timer_get_time();
+	
+	ring.staging[ring.staged++] = record;
+	
+	// Flash is written in whole pages, records never cross page boundaries
+	if ((ring.write_offset + ring.staged * sizeof(Record)) % (ring.staging.size() * sizeof(Record)) == 0)
+		writeStaged(ring);
+}
+
+void DataLogger::writeStaged(Ring& ring)
+{
+	if (!ring.staged)
+		return;
+	
+	ESP_ERROR_CHECK(esp_partition_write(m_partition, ring.write_offset, ring.staging.data(), ring.staged * sizeof(Record)));
+	
+	ring.write_offset += ring.staged * sizeof(Record);
+	ring.staged = 0;
+}
+
+// Oldest sector of the ring is given up, it stays unwritten after the head and the spares before it, so readers skip it
+void DataLogger::eraseSpare(Ring& ring)
+{
+	size_t sector = (ring.head + 1 + ring.spares) % ring.sector_count;
+	ESP_ERROR_CHECK(esp_partition_erase_range(m_partition, getSectorOffset(ring, sector), s_sector_size));
+	
+	ring.index[sector] = {};
+	ring.spares++;
+	m_last_erase_us = esp_timer_get_time();
+}
+
+void DataLogger::openSpare(Ring& ring, Tier tier, uint32_t first_timestamp)
+{
+	size_t sector = (ring.head + 1) % ring.sector_count;
+	auto offset = getSectorOffset(ring, sector);
+	
+	SegmentHeader header = {};
+	header.magic = s_magic;
+	header.sequence = ring.next_segment++;
+	header.first_timestamp = first_timestamp;
+	header.first_record = ring.next_sequence;
+	header.tier = tier;
+	header.version = s_version;
+	header.crc = Checksum(header);
+	
+	ESP_ERROR_CHECK(esp_partition_write(m_partition, offset, &header, sizeof(header)));
+	
+	ring.index[sector] = { header.sequence, header.first_timestamp, header.first_record };
+	ring.head = sector;
+	ring.write_offset = offset + sizeof(header);
+	ring.spares--;
+}
+
+//======================================== Reading
+
+void DataLogger::flush()
+{
+	m_flush_requested = true;
+}
+
+void DataLogger::setErasePaced(bool paced)
+{
+	m_erase_paced = paced;
+}
+
+size_t DataLogger::read(Tier tier, uint32_t timestamp, uint32_t sequence, std::span<Record> records) const
+{
+	if (!m_partition)
+		return 0;
+	
+	xSemaphoreTake(m_mutex, portMAX_DELAY);
+	
+	const auto& ring = m_rings[tier];
+	
+	// Unwritten sectors are the spares directly following the head, so written ones are contiguous in ring order
+	size_t written = std::ranges::count_if(ring.index, [](const IndexEntry& entry) { return entry.sequence != 0; });
+	size_t oldest = ring.head + 1 + ring.sector_count - written;
+	
+	auto sector_at = [&](size_t position) -> size_t
+	{
+		return (oldest + position) % ring.sector_count;
+	};
+	
+	// Binary search for the last sector starting before the timestamp
+	size_t first = 0;
+	for (size_t count = written; count > 1;)
+	{
+		size_t half = count / 2;
+		if (ring.index[sector_at(first + half)].first_timestamp <= timestamp)
+			first += half;
+		
+		count -= half;
+	}
+	
+	size_t read_count = 0;
+	for (size_t position = first; position < written && read_count < records.size(); position++)
+	{
+		auto sector_offset = getSectorOffset(ring, sector_at(position));
+		auto offset = sector_offset + sizeof(SegmentHeader);
+		auto end = sector_at(position) == ring.head? ring.write_offset: sector_offset + s_sector_size;
+		
+		for (; offset < end && read_count < records.size(); offset += sizeof(Record))
+		{
+			auto& record = records[read_count];
+			ESP_ERROR_CHECK(esp_partition_read(m_partition, offset, &record, sizeof(record)));
+			
+			if (record.crc == Checksum(record) && record.timestamp >= timestamp && record.sequence >= sequence)
+				read_count++;
+		}
+	}
+	
+	// Staged records are the newest ones, they follow whatever has been written
+	for (size_t i = 0; i < ring.staged && read_count < records.size(); i++)
+		if (ring.staging[i].timestamp >= timestamp && ring.staging[i].sequence >= sequence)
+			records[read_count++] = ring.staging[i];
+	
+	xSemaphoreGive(m_mutex);
+	return read_count;
+}
+
+uint32_t DataLogger::getRecordCount(Tier tier) const
+{
+	const auto& ring = m_rings[tier];
+	
+	uint32_t first_record = ring.next_sequence;
+	for (const auto& entry: ring.index)
+		if (entry.sequence != 0)
+			first_record = std::min(first_record, entry.first_record);
+	
+	return ring.next_sequence - first_record;
+}
+
+uint32_t DataLogger::getDroppedRecordCount() const
+{
+	return m_dropped_records;
+}
+
+//========================================
+
+size_t DataLogger::getSectorOffset(const Ring& ring, size_t sector) const
+{
+	return (ring.first_sector + sector) * s_sector_size;
+}
+
+size_t DataLogger::GetSpareTarget(const Ring& ring)
+{
+	return std::min(s_spare_sectors, ring.sector_count - 1);
+}
+
+template<typename T>
+uint32_t DataLogger::Checksum(const T& data)
+{
+	return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&data), sizeof(T) - sizeof(T::crc));
+}
+
+//========================================
\ No newline at end of file
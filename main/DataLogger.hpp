@@ -0,0 +1,188 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "esp_partition.h"
+
+#include <array>
+#include <span>
+#include <vector>
+#include <atomic>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Long-term logger of min/avg/max aggregates
+// Samples are reduced to one record per second, which are folded into per minute and per hour records;
+// every tier is an append-only ring of flash sectors inside a dedicated partition
+// Flash access suspends the cache on both cores, and the sampling loop does not run from IRAM: page writes stall it
+// for about a millisecond, erases for tens of them. A few sectors per tier are therefore kept erased ahead of time;
+// while sampling, they are topped up one erase at a time and no more often than every s_erase_interval_us, which
+// bounds the gaps and still outpaces the seconds tier filling a sector every couple of minutes
+// Making the sampling loop IRAM resident would not help, as the other core is parked for the duration of any flash
+// operation; instead, the sample periods it misses are counted into the records, so that the stalls are measured and
+// the affected intervals marked where the data ends up
+class DataLogger
+{
+public:
+	enum Tier: uint8_t
+	{
+		Seconds,
+		Minutes,
+		Hours,
+		
+		TierCount
+	};
+	
+	#pragma pack(push, 1)
+	
+	struct Record
+	{
+		uint32_t timestamp; // Log time in seconds at which the interval begins
+		uint32_t sequence;  // Record number within the tier
+		uint32_t count;     // Number of samples aggregated
+		float    min;
+		float    avg;
+		float    max;
+		uint8_t  tier;
+		uint8_t  channel;
+		uint16_t missed;    // Sample periods without a sample within the interval, saturated
+		uint32_t crc;
+	};
+	
+	#pragma pack(pop)
+	
+	static_assert(sizeof(Record) == 32);
+	
+	DataLogger() = default;
+	DataLogger(const DataLogger& copy) = delete;
+	
+	void setup(const char* partition_label = "datalog");
+	
+	// Called from the sampling loop, must stay cheap, missed are the sample periods without a sample before this one
+	// Sample codes are only converted to volts once per record using the given LSB
+	void addSample(Sample value, uint16_t missed, uint8_t channel, float lsb, int64_t time_us);
+	
+	// Requests all the staged records to be written on the next writer iteration
+	void flush();
+	
+	// Erases stall sampling, so they are paced while it runs, and done as soon as needed otherwise
+	void setErasePaced(bool paced);
+	
+	// Reads records of the tier starting from the first one that covers given log time, staged ones included
+	// Records before the given sequence number are skipped, so that a reader picks up right after the last one it got,
+	// even among records sharing its timestamp
+	size_t read(Tier tier, uint32_t timestamp, uint32_t sequence, std::span<Record> records) const;
+	
+	uint32_t getRecordCount(Tier tier) const;
+	uint32_t getDroppedRecordCount() const;
+	
+private:
+	#pragma pack(push, 1)
+	
+	struct SegmentHeader
+	{
+		uint32_t magic;
+		uint32_t sequence;        // Incremented every time a sector is (re)opened
+		uint32_t first_timestamp; // Timestamp of the first record in this sector
+		uint32_t first_record;    // Sequence of the first record in this sector
+		uint8_t  tier;
+		uint8_t  version;
+		uint16_t reserved;
+		uint32_t reserved2[2];
+		uint32_t crc;
+	};
+	
+	#pragma pack(pop)
+	
+	static_assert(sizeof(SegmentHeader) == sizeof(Record));
+	
+	struct IndexEntry
+	{
+		uint32_t sequence;
+		uint32_t first_timestamp;
+		uint32_t first_record;
+	};
+	
+	struct Aggregate
+	{
+		Sample   min;
+		Sample   max;
+		int64_t  sum;
+		uint32_t count;
+		uint32_t missed;
+		uint32_t timestamp;
+	};
+	
+	struct Ring
+	{
+		size_t first_sector;
+		size_t sector_count;
+		
+		std::vector<IndexEntry> index; // Per sector, written sectors only have non-zero sequence
+		size_t                  head;  // Sector currently being appended
+		
+		size_t   write_offset;  // Absolute partition offset of the next record slot
+		size_t   spares;        // Erased sectors following the head, ready to be opened
+		uint32_t next_sequence; // Sequence of the next record
+		uint32_t next_segment;  // Sequence of the next opened sector
+		
+		std::array<Record, 8> staging;
+		size_t                staged;
+		int64_t               staged_since_us;
+	};
+	
+	static constexpr uint32_t s_magic                 = 0x474F4C44; // "DLOG"
+	static constexpr uint8_t  s_version               = 1;
+	static constexpr size_t   s_sector_size           = 4096;
+	static constexpr int64_t  s_flush_interval_us     = 60'000'000;
+	static constexpr size_t   s_spare_sectors         = 4;
+	static constexpr int64_t  s_erase_interval_us     = 10'000'000;
+	static constexpr uint32_t s_intervals[TierCount]  = { 1, 60, 3600 };
+	
+	const esp_partition_t* m_partition = nullptr;
+	QueueHandle_t          m_queue     = nullptr;
+	SemaphoreHandle_t      m_mutex     = nullptr;
+	
+	std::array<Ring, TierCount> m_rings {};
+	
+	std::atomic<uint32_t> m_dropped_records = 0;
+	std::atomic<bool>     m_flush_requested = false;
+	std::atomic<bool>     m_erase_paced     = false;
+	
+	// Sampling side
+	std::array<Aggregate, TierCount> m_aggregates {};
+	uint32_t m_time_base      = 0;
+	int64_t  m_next_second_us = 0;
+	uint8_t  m_channel        = 0;
+	float    m_lsb            = 0;
+	bool     m_started        = false;
+	
+	void rollover(uint8_t channel, float lsb, int64_t time_us);
+	void commit(Tier tier, uint32_t timestamp);
+	void resetAggregate(Tier tier, uint32_t timestamp);
+	
+	// Writer side
+	int64_t m_last_erase_us = 0;
+	
+	void writerLoop();
+	void recover(Ring& ring, Tier tier);
+	void append(Ring& ring, Tier tier, Record record);
+	void writeStaged(Ring& ring);
+	void eraseSpare(Ring& ring);
+	void openSpare(Ring& ring, Tier tier, uint32_t first_timestamp);
+	
+	size_t getSectorOffset(const Ring& ring, size_t sector) const;
+	
+	// Head sector is never a spare
+	static size_t GetSpareTarget(const Ring& ring);
+	
+	template<typename T>
+	static uint32_t Checksum(const T& data);
+	
+};
+
+//========================================
\ No newline at end of file
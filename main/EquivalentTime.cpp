@@ -0,0 +1,167 @@
+#include <algorithm>
+
+#include <EquivalentTime.hpp>
+
+//========================================
+
+void EquivalentTime::setup(const Config& config)
+{
+	m_config = config;
+	
+	// Window is at least a cycle per bin, which keeps the factor within 32 bits
+	m_config.window = std::max<uint32_t>(m_config.window, s_bins);
+	m_bin_factor = (static_cast<uint64_t>(s_bins) << 32) / m_config.window;
+	
+	m_sums.fill(0);
+	m_counts.fill(0);
+	m_average.fill(0);
+	
+	m_triggers.store(0, std::memory_order_relaxed);
+	m_filled.store(0, std::memory_order_relaxed);
+	
+	m_history_count = 0;
+	m_armed = false;
+	m_triggered = false;
+	
+	m_until_publish = s_publish_interval;
+	m_sequence.store(0, std::memory_order_release);
+}
+
+void EquivalentTime::add(Sample sample, uint32_t time)
+{
+	TimedSample current = { sample, time };
+	
+	const TimedSample& previous = m_history[(m_history_count + s_history_size - 1) % s_history_size];
+	bool has_previous = m_history_count > 0;
+	
+	// Far threshold is only crossed after the near one, so that noise around it does not fire again
+	Sample near = m_config.rising? m_config.low: m_config.high;
+	Sample far = m_config.rising? m_config.high: m_config.low;
+	
+	bool beyond_near = m_config.rising? sample < near: sample > near;
+	bool beyond_far = m_config.rising? sample >= far: sample <= far;
+	
+	m_armed |= beyond_near;
+	
+	bool fired = m_armed && beyond_far && has_previous;
+	if (fired) [[unlikely]]
+	{
+		m_armed = false;
+		m_triggered = true;
+		m_trigger_time = getCrossingTime(previous, current, far);
+		m_triggers.store(m_triggers.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	
+	m_history[m_history_count++ % s_history_size] = current;
+	
+	if (!--m_until_publish)
+	{
+		m_until_publish = s_publish_interval;
+		if (m_filled.load(std::memory_order_relaxed))
+			publish();
+	}
+	
+	if (!m_triggered)
+		return;
+	
+	// Samples preceding the trigger are binned once it fires, the following ones as they come
+	if (fired)
+	{
+		for (size_t i = m_history_count - std::min(m_history_count, s_history_size); i < m_history_count; i++)
+			addToBin(m_history[i % s_history_size]);
+	}
+	
+	else
+		addToBin(current);
+}
+
+uint32_t EquivalentTime::getTriggerCount() const
+{
+	return m_triggers.load(std::memory_order_relaxed);
+}
+
+size_t EquivalentTime::getFilledBins() const
+{
+	return m_filled.load(std::memory_order_relaxed);
+}
+
+// Copy is retried while it overlaps with publishing, a reader that keeps losing gives up rather than spin
+bool EquivalentTime::getWaveform(std::span<Sample, s_bins> waveform) const
+{
+	for (int attempt = 0; attempt < 4; attempt++)
+	{
+		uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+		if (!sequence)
+			return false;
+		
+		if (sequence & 1)
+			continue;
+		
+		std::ranges::copy(m_waveform, waveform.begin());
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) == sequence)
+			return true;
+	}
+	
+	return false;
+}
+
+// Linear interpolation, the samples are on opposite sides of the level
+uint32_t EquivalentTime::getCrossingTime(const TimedSample& before, const TimedSample& after, Sample level) const
+{
+	int32_t rise = after.sample - before.sample;
+	if (!rise)
+		return after.time;
+	
+	uint32_t period = after.time - before.time;
+	int64_t fraction = static_cast<int64_t>(level - before.sample) * period / rise;
+	
+	return before.time + static_cast<uint32_t>(std::clamp<int64_t>(fraction, 0, period));
+}
+
+void EquivalentTime::addToBin(const TimedSample& sample)
+{
+	// Offsets before the start of the window wrap around to large ones and fall outside of it as well
+	uint32_t offset = sample.time - m_trigger_time + m_config.window / 2;
+	if (offset >= m_config.window)
+		return;
+	
+	size_t bin = offset * m_bin_factor >> 32;
+	
+	if (!m_counts[bin])
+		m_filled.store(m_filled.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	
+	else if (m_counts[bin] == s_max_bin_count)
+	{
+		m_sums[bin] /= 2;
+		m_counts[bin] /= 2;
+	}
+	
+	m_sums[bin] += sample.sample;
+	m_counts[bin]++;
+	m_average[bin] = m_sums[bin] / m_counts[bin];
+}
+
+// Only called once a bin is filled
+void EquivalentTime::publish()
+{
+	uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	
+	// Bins before the first filled one take its value
+	auto first = std::ranges::find_if(m_counts, [](uint16_t count) { return count != 0; });
+	Sample value = m_average[first - m_counts.begin()];
+	for (size_t bin = 0; bin < s_bins; bin++)
+	{
+		if (m_counts[bin])
+			value = m_average[bin];
+		
+		m_waveform[bin] = value;
+	}
+	
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//========================================
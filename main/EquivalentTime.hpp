@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Equivalent-time reconstruction of a repetitive signal: every sample is placed by its offset from the nearest
+// trigger and averaged into a bin of a waveform much finer than the sample period; sampling is not locked to the
+// signal, so over many triggers the offsets fall all over the window and fill every bin
+// Trigger time is interpolated between the samples around the threshold crossing, which is what makes sub-sample
+// offsets meaningful, as long as the trigger edge spans a few samples; times are cycle counts, only their differences
+// are used, so wrapping is fine
+// Everything but the getters is called from the sampling loop only, the waveform is read from published snapshots
+class EquivalentTime
+{
+public:
+	static constexpr size_t s_bins         = 512;
+	static constexpr size_t s_history_size = 64; // Samples kept for the part of the window preceding the trigger
+	
+	struct Config
+	{
+		Sample   low;    // Crossing the near threshold arms the trigger, crossing the far one fires it
+		Sample   high;
+		bool     rising;
+		uint32_t window; // Cycles, the trigger is in the middle
+	};
+	
+	EquivalentTime() = default;
+	EquivalentTime(const EquivalentTime& copy) = delete;
+	
+	// Clears the waveform
+	void setup(const Config& config);
+	
+	void add(Sample sample, uint32_t time);
+	
+	uint32_t getTriggerCount() const;
+	size_t getFilledBins() const;
+	
+	// Bins nothing fell into yet take the value of the one before, returns false until a waveform has been published
+	bool getWaveform(std::span<Sample, s_bins> waveform) const;
+	
+private:
+	// Averages are halved once this many samples have fallen into a bin, so that the waveform keeps following the signal
+	static constexpr uint16_t s_max_bin_count = 1 << 12;
+	
+	// Waveform is published this often, which is also the cost of publishing spread over the samples
+	static constexpr uint32_t s_publish_interval = 1024;
+	
+	struct TimedSample
+	{
+		Sample   sample;
+		uint32_t time;
+	};
+	
+	Config m_config {};
+	
+	// Bin of a window offset in 32.32 fixed point
+	uint64_t m_bin_factor = 0;
+	
+	std::array<int32_t,  s_bins> m_sums    {};
+	std::array<uint16_t, s_bins> m_counts  {};
+	std::array<Sample,   s_bins> m_average {};
+	
+	std::atomic<uint32_t> m_triggers = 0;
+	std::atomic<size_t>   m_filled   = 0;
+	
+	std::array<Sample, s_bins> m_waveform {};
+	uint32_t m_until_publish = 0;
+	
+	// Odd while the waveform is being written
+	std::atomic<uint32_t> m_sequence = 0;
+	
+	std::array<TimedSample, s_history_size> m_history {};
+	size_t m_history_count = 0;
+	
+	bool     m_armed        = false;
+	bool     m_triggered    = false;
+	uint32_t m_trigger_time = 0;
+	
+	uint32_t getCrossingTime(const TimedSample& before, const TimedSample& after, Sample level) const;
+	void addToBin(const TimedSample& sample);
+	void publish();
+	
+};
+
+//========================================
@@ -0,0 +1,94 @@
+#include <cstdlib>
+#include <new>
+
+#include <HeapGuard.hpp>
+
+//========================================
+
+std::atomic<bool>        HeapGuard::s_sealed           = false;
+std::atomic<uint32_t>    HeapGuard::s_allocation_count = 0;
+std::atomic<const void*> HeapGuard::s_last_caller      = nullptr;
+
+//========================================
+
+void HeapGuard::Seal()
+{
+	s_sealed.store(true, std::memory_order_relaxed);
+}
+
+bool HeapGuard::IsSealed()
+{
+	return s_sealed.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapGuard::GetAllocationCount()
+{
+	return s_allocation_count.load(std::memory_order_relaxed);
+}
+
+const void* HeapGuard::GetLastCaller()
+{
+	return s_last_caller.load(std::memory_order_relaxed);
+}
+
+// Nothing here may allocate, logging included
+void HeapGuard::OnAllocation(const void* caller)
+{
+	if (!IsSealed())
+		return;
+	
+	#ifdef CONFIG_HEAP_GUARD_ABORT
+		// Backtrace of the abort leads to the allocation
+		abort();
+	#endif
+	
+	s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+	s_last_caller.store(caller, std::memory_order_relaxed);
+}
+
+//========================================
+
+// Replacements of the global allocation functions, the array forms and the nothrow ones of the C++ library end up here
+void* operator new(size_t size)
+{
+	HeapGuard::OnAllocation(__builtin_return_address(0));
+	
+	void* pointer = malloc(size);
+	if (!pointer)
+		abort();
+	
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	HeapGuard::OnAllocation(__builtin_return_address(0));
+	
+	void* pointer = malloc(size);
+	if (!pointer)
+		abort();
+	
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+//========================================
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+//========================================
+
+// Watches for heap allocations through operator new once the steady state is reached, which should not make any;
+// they are counted, along with the caller of the last one for addr2line, or abort right away with HEAP_GUARD_ABORT
+class HeapGuard
+{
+public:
+	HeapGuard() = delete;
+	
+	// Allocations from now on are reported
+	static void Seal();
+	static bool IsSealed();
+	
+	static uint32_t GetAllocationCount();
+	static const void* GetLastCaller();
+	
+	// Called by operator new
+	static void OnAllocation(const void* caller);
+	
+private:
+	static std::atomic<bool>        s_sealed;
+	static std::atomic<uint32_t>    s_allocation_count;
+	static std::atomic<const void*> s_last_caller;
+	
+};
+
+//========================================
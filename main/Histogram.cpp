@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cmath>
+
+#include <Histogram.hpp>
+
+//========================================
+
+void Histogram::setup(const Config& config)
+{
+	m_config = config;
+	
+	int32_t range = std::max<int32_t>(config.high - config.low, 1);
+	m_bin_width = (range + s_bins - 1) / s_bins;
+	m_bin_factor = ((uint64_t(1) << 32) + m_bin_width - 1) / m_bin_width;
+	
+	m_counts.fill(0);
+	m_count = 0;
+	m_until_publish = s_publish_interval;
+	m_complete = false;
+	
+	m_sequence.store(0, std::memory_order_release);
+}
+
+void Histogram::add(Sample sample)
+{
+	// Negative offsets fall below the range, the ones past its end are clamped above it
+	int32_t offset = sample - m_config.low;
+	size_t index = offset < 0? 0: std::min<uint64_t>((offset * m_bin_factor >> 32) + 1, s_bins + 1);
+	m_counts[index]++;
+	
+	m_count++;
+	
+	if (m_config.length && m_count == m_config.length)
+	{
+		publish(true);
+		
+		m_counts.fill(0);
+		m_count = 0;
+		m_until_publish = s_publish_interval;
+	}
+	
+	else if (!--m_until_publish)
+	{
+		if (!m_complete)
+			publish(false);
+		
+		m_until_publish = s_publish_interval;
+	}
+}
+
+uint32_t Histogram::getResultCount() const
+{
+	return m_sequence.load(std::memory_order_acquire) / 2;
+}
+
+// Copy is retried while it overlaps with publishing, a reader that keeps losing gives up rather than spin
+bool Histogram::getResult(Result* result) const
+{
+	for (int attempt = 0; attempt < 4; attempt++)
+	{
+		uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+		if (!sequence)
+			return false;
+		
+		if (sequence & 1)
+			continue;
+		
+		*result = m_result;
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) == sequence)
+			return true;
+	}
+	
+	return false;
+}
+
+bool Histogram::GetStatistics(const Result& result, Statistics* statistics)
+{
+	uint32_t in_range = 0;
+	double sum = 0;
+	double square_sum = 0;
+	
+	for (size_t bin = 0; bin < s_bins; bin++)
+	{
+		// Bins hold whole codes, so the middle one of them
+		double middle = result.low + bin * result.bin_width + (result.bin_width - 1) / 2.;
+		
+		in_range += result.bins[bin];
+		sum += result.bins[bin] * middle;
+		square_sum += result.bins[bin] * middle * middle;
+	}
+	
+	if (!in_range)
+		return false;
+	
+	double mean = sum / in_range;
+	
+	statistics->mean = mean;
+	statistics->deviation = std::sqrt(std::max(square_sum / in_range - mean * mean, 0.));
+	statistics->median = GetPercentile(result, in_range, .5f);
+	statistics->low_percentile = GetPercentile(result, in_range, .01f);
+	statistics->high_percentile = GetPercentile(result, in_range, .99f);
+	
+	return true;
+}
+
+//========================================
+
+void Histogram::publish(bool complete)
+{
+	uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	
+	std::copy_n(m_counts.begin() + 1, s_bins, m_result.bins.begin());
+	m_result.below = m_counts.front();
+	m_result.above = m_counts.back();
+	m_result.count = m_count;
+	m_result.complete = complete;
+	m_result.low = m_config.low;
+	m_result.bin_width = m_bin_width;
+	
+	m_sequence.store(sequence + 2, std::memory_order_release);
+	m_complete |= complete;
+}
+
+// Samples are taken to be spread evenly over their bin, which spans half a code past its outer codes
+float Histogram::GetPercentile(const Result& result, uint32_t in_range, float fraction)
+{
+	float start = result.low - .5f;
+	float target = fraction * in_range;
+	float below = 0;
+	
+	for (size_t bin = 0; bin < s_bins; bin++)
+	{
+		uint32_t count = result.bins[bin];
+		if (count && below + count >= target)
+			return start + (bin + (target - below) / count) * result.bin_width;
+		
+		below += count;
+	}
+	
+	return start + s_bins * result.bin_width;
+}
+
+//========================================
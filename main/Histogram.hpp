@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Amplitude histogram of every processed sample, for noise and ripple of a steady signal; adding a sample is a
+// multiplication to get its bin and an increment, statistics are derived from the bins once per result
+// Accumulates over a number of samples, then publishes the result and starts over; the running one is published
+// every now and then until the first result, or all along when accumulating endlessly
+// Everything but the getters is called from the sampling loop only, results are read through a sequence counter
+class Histogram
+{
+public:
+	static constexpr size_t s_bins = 64;
+	
+	struct Config
+	{
+		Sample   low;    // Lower edge of the first bin
+		Sample   high;   // Upper edge of the last bin, bins are whole codes wide, so it may end up a little higher
+		uint32_t length; // Samples per result, 0 to accumulate endlessly
+	};
+	
+	struct Result
+	{
+		std::array<uint32_t, s_bins> bins;
+		uint32_t below;
+		uint32_t above;
+		uint32_t count;     // All samples, in range or not
+		bool     complete;  // Covers the whole length
+		
+		Sample   low;       // Bin layout the result was accumulated with
+		uint16_t bin_width; // Codes
+	};
+	
+	// In codes, derived from the samples in range only, each of them taken for the middle of its bin
+	struct Statistics
+	{
+		float mean;
+		float deviation;
+		float median;
+		float low_percentile;  // 1st and 99th, percentiles are interpolated within the bin
+		float high_percentile;
+	};
+	
+	Histogram() = default;
+	Histogram(const Histogram& copy) = delete;
+	
+	// Starts over, nothing is published until the first interval passes
+	void setup(const Config& config);
+	
+	void add(Sample sample);
+	
+	// Number of results published since setup, complete or not
+	uint32_t getResultCount() const;
+	
+	// Returns false if nothing has been published yet
+	bool getResult(Result* result) const;
+	
+	// Returns false if there are no samples in range
+	static bool GetStatistics(const Result& result, Statistics* statistics);
+	
+private:
+	// Running result is published this often, which is also the cost of publishing spread over the samples
+	static constexpr uint32_t s_publish_interval = 1024;
+	
+	Config   m_config     {};
+	uint16_t m_bin_width  = 1;
+	uint64_t m_bin_factor = 0; // Bin of a code offset in 32.32 fixed point, exact for offsets in range
+	
+	// Below the range, bins, above it
+	std::array<uint32_t, s_bins + 2> m_counts {};
+	uint32_t m_count         = 0;
+	uint32_t m_until_publish = 0;
+	bool     m_complete      = false; // A complete result has been published since setup
+	
+	// Odd while the result is being written
+	std::atomic<uint32_t> m_sequence = 0;
+	Result m_result {};
+	
+	void publish(bool complete);
+	
+	static float GetPercentile(const Result& result, uint32_t in_range, float fraction);
+	
+};
+
+//========================================
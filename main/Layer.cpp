@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include <Layer.hpp>
+
+//========================================
+
+Layer::Layer(const Vector2u& size /*= Vector2u(128, 64)*/):
+	m_size(size),
+	m_offset((s_columns - size.x) / 2, (s_pages * 8 - size.y) / 2)
+{}
+
+//========================================
+
+const Vector2u& Layer::getSize() const
+{
+	return m_size;
+}
+
+bool Layer::setPixel(const Vector2i& position, bool value)
+{
+	if (!(0 <= position.x && position.x < m_size.x && 0 <= position.y && position.y < m_size.y))
+		return false;
+	
+	auto point = position + m_offset;
+	
+	uint8_t mask = 1 << (point.y % 8);
+	set(point.y / 8 * s_columns + point.x, mask, value * mask);
+	
+	return true;
+}
+
+void Layer::fillColumn(int x, int top, int bottom, bool value)
+{
+	top = std::max(top, 0);
+	bottom = std::min<int>(bottom, m_size.y - 1);
+	
+	if (!(0 <= x && x < m_size.x) || top > bottom)
+		return;
+	
+	x += m_offset.x;
+	top += m_offset.y;
+	bottom += m_offset.y;
+	
+	for (int page = top / 8; page <= bottom / 8; page++)
+	{
+		uint8_t mask = (0xFF << std::max(top - page * 8, 0)) & (0xFF >> (7 - std::min(bottom - page * 8, 7)));
+		set(page * s_columns + x, mask, value * mask);
+	}
+}
+
+void Layer::draw(const Sprite& sprite, const Vector2i& position)
+{
+	Vector2i origin = position + m_offset;
+	
+	// Sprite pages are shifted into pairs of adjacent layer pages
+	int first_page = origin.y >> 3;
+	int shift = origin.y & 7;
+	
+	int first_column = std::max(m_offset.x, origin.x);
+	int last_column = std::min<int>(m_offset.x + m_size.x, origin.x + sprite.getSize().x);
+	
+	for (size_t sprite_page = 0; sprite_page < sprite.getPageCount(); sprite_page++)
+	{
+		const auto* pixel_data = sprite.getPixelData(sprite_page);
+		const auto* mask_data = sprite.getMaskData(sprite_page);
+		
+		for (int half = 0; half < 2; half++)
+		{
+			int page = first_page + sprite_page + half;
+			if (!(0 <= page && page < static_cast<int>(s_pages)))
+				continue;
+			
+			for (int column = first_column; column < last_column; column++)
+			{
+				uint8_t pixels = (pixel_data[column - origin.x] << shift) >> (8 * half);
+				uint8_t mask = (mask_data[column - origin.x] << shift) >> (8 * half);
+				
+				set(page * s_columns + column, mask, pixels);
+			}
+		}
+	}
+}
+
+void Layer::clear()
+{
+	m_pixel_data.fill(0);
+	m_coverage_data.fill(0);
+}
+
+std::span<const uint32_t, Layer::s_word_count> Layer::getPixelData() const
+{
+	return m_pixel_data;
+}
+
+std::span<const uint32_t, Layer::s_word_count> Layer::getCoverageData() const
+{
+	return m_coverage_data;
+}
+
+//========================================
+
+void Layer::set(size_t byte, uint8_t mask, uint8_t pixels)
+{
+	auto* pixel_data = reinterpret_cast<uint8_t*>(m_pixel_data.data());
+	auto* coverage_data = reinterpret_cast<uint8_t*>(m_coverage_data.data());
+	
+	pixel_data[byte] = (pixel_data[byte] & ~mask) | (pixels & mask);
+	coverage_data[byte] |= mask;
+}
+
+//========================================
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+
+#include <Vector.hpp>
+#include <Sprite.hpp>
+
+//========================================
+
+// Full screen 1 bpp image with coverage, laid out exactly like the SH1106 display RAM (8 pages of 132 columns,
+// one byte is a column of 8 pixels, visible area is centered), so that layers are composed into the display
+// a word at a time; pixels that have not been drawn since the last clear are not covered
+class Layer
+{
+public:
+	enum class Blend: uint8_t
+	{
+		Copy,   // Replaces everything
+		Or,     // Sets the layer pixels
+		AndNot, // Clears the layer pixels
+		Xor,    // Inverts the layer pixels
+		Over    // Replaces covered pixels, the layer is opaque where it was drawn
+	};
+	
+	static constexpr size_t s_columns    = 132;
+	static constexpr size_t s_pages      = 8;
+	static constexpr size_t s_word_count = s_columns * s_pages / sizeof(uint32_t);
+	
+	explicit Layer(const Vector2u& size = Vector2u(128, 64));
+	Layer(const Layer& copy) = delete;
+	
+	const Vector2u& getSize() const;
+	
+	bool setPixel(const Vector2i& position, bool value);
+	void fillColumn(int x, int top, int bottom, bool value);
+	
+	// Copies opaque pixels of the sprite a byte at a time
+	void draw(const Sprite& sprite, const Vector2i& position);
+	
+	// Also removes coverage
+	void clear();
+	
+	std::span<const uint32_t, s_word_count> getPixelData() const;
+	std::span<const uint32_t, s_word_count> getCoverageData() const;
+	
+private:
+	Vector2u m_size;
+	Vector2i m_offset;
+	
+	std::array<uint32_t, s_word_count> m_pixel_data    {};
+	std::array<uint32_t, s_word_count> m_coverage_data {};
+	
+	void set(size_t byte, uint8_t mask, uint8_t pixels);
+	
+};
+
+//========================================
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <limits>
+
+#include <LimitTest.hpp>
+
+//========================================
+
+void LimitTest::setBand(Sample low, Sample high)
+{
+	m_low.fill(low);
+	m_high.fill(high);
+	m_column_factor = 0;
+	
+	reset();
+}
+
+void LimitTest::startMask(size_t length)
+{
+	m_low.fill(std::numeric_limits<Sample>::max());
+	m_high.fill(std::numeric_limits<Sample>::min());
+	m_column_factor = length? (s_columns << 16) / length: 0;
+	
+	reset();
+}
+
+void LimitTest::learn(Sample sample, size_t offset)
+{
+	size_t column = std::min<size_t>(offset * m_column_factor >> 16, s_columns - 1);
+	m_low[column] = std::min(m_low[column], sample);
+	m_high[column] = std::max(m_high[column], sample);
+}
+
+// Every column spans the samples learned into it widened by the margin
+void LimitTest::finishMask(Sample margin)
+{
+	// Columns without samples of their own take the ones of the column before
+	for (size_t column = 0; column < s_columns; column++)
+	{
+		if (m_low[column] > m_high[column])
+		{
+			m_low[column] = column? m_low[column - 1]: std::numeric_limits<Sample>::min();
+			m_high[column] = column? m_high[column - 1]: std::numeric_limits<Sample>::max();
+			continue;
+		}
+		
+		m_low[column] = std::max<int>(m_low[column] - margin, std::numeric_limits<Sample>::min());
+		m_high[column] = std::min<int>(m_high[column] + margin, std::numeric_limits<Sample>::max());
+	}
+	
+	reset();
+}
+
+void LimitTest::check(Sample sample, size_t offset, int64_t time_us)
+{
+	size_t column = std::min<size_t>(offset * m_column_factor >> 16, s_columns - 1);
+	
+	// Both compares are evaluated, which leaves only the rarely taken branch to the violation bookkeeping
+	uint32_t violated = (sample < m_low[column]) | (sample > m_high[column]);
+	
+	uint32_t checked = m_checked.load(std::memory_order_relaxed);
+	m_checked.store(checked + 1, std::memory_order_relaxed);
+	m_violations.store(m_violations.load(std::memory_order_relaxed) + violated, std::memory_order_relaxed);
+	
+	m_history[checked % s_history_size] = sample;
+	
+	if (m_snippet_fill)
+	{
+		auto& snippet = m_snippets[m_snippet_count.load(std::memory_order_relaxed) % s_snippet_count];
+		snippet.samples[m_snippet_fill++] = sample;
+		
+		if (m_snippet_fill == s_snippet_size)
+		{
+			m_snippet_fill = 0;
+			m_snippet_count.fetch_add(1, std::memory_order_release);
+		}
+	}
+	
+	if (violated) [[unlikely]]
+		onViolation(time_us);
+}
+
+uint32_t LimitTest::getCheckedCount() const
+{
+	return m_checked.load(std::memory_order_relaxed);
+}
+
+uint32_t LimitTest::getViolationCount() const
+{
+	return m_violations.load(std::memory_order_relaxed);
+}
+
+int64_t LimitTest::getFirstViolationTime() const
+{
+	return m_first_violation_time.load(std::memory_order_relaxed);
+}
+
+int64_t LimitTest::getLastViolationTime() const
+{
+	return m_last_violation_time.load(std::memory_order_relaxed);
+}
+
+uint32_t LimitTest::getSnippetCount() const
+{
+	return m_snippet_count.load(std::memory_order_acquire);
+}
+
+// The slot is reused by the snippet s_snippet_count later, which starts being captured as soon as this one is complete
+bool LimitTest::getSnippet(uint32_t number, Snippet* snippet) const
+{
+	if (number >= getSnippetCount() || getSnippetCount() >= number + s_snippet_count)
+		return false;
+	
+	*snippet = m_snippets[number % s_snippet_count];
+	
+	return getSnippetCount() < number + s_snippet_count;
+}
+
+void LimitTest::reset()
+{
+	m_checked.store(0, std::memory_order_relaxed);
+	m_violations.store(0, std::memory_order_relaxed);
+	m_snippet_count.store(0, std::memory_order_release);
+	m_snippet_fill = 0;
+	m_history.fill(0);
+}
+
+void LimitTest::onViolation(int64_t time_us)
+{
+	uint32_t violation = m_violations.load(std::memory_order_relaxed);
+	
+	if (violation == 1)
+		m_first_violation_time.store(time_us, std::memory_order_relaxed);
+	
+	m_last_violation_time.store(time_us, std::memory_order_relaxed);
+	
+	// Violations while a snippet is being captured end up in it
+	if (m_snippet_fill)
+		return;
+	
+	auto& snippet = m_snippets[m_snippet_count.load(std::memory_order_relaxed) % s_snippet_count];
+	snippet.time_us = time_us;
+	snippet.violation = violation - 1;
+	
+	// History is a ring ending with the violating sample
+	uint32_t checked = m_checked.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < s_history_size; i++)
+		snippet.samples[i] = m_history[(checked + i) % s_history_size];
+	
+	m_snippet_fill = s_history_size;
+}
+
+//========================================
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Checks every acquired sample against a band, or against a mask of per-column limits learned from the samples
+// following a trigger, and records the violations along with a snippet of samples around each of them
+// Everything but the getters is called from the sampling loop only, so that every value has a single writer
+class LimitTest
+{
+public:
+	static constexpr size_t s_columns       = 128;
+	static constexpr size_t s_snippet_size  = 32; // Half of it precedes the violating sample
+	static constexpr size_t s_snippet_count = 4;  // Most recent ones are kept
+	
+	struct Snippet
+	{
+		int64_t  time_us;   // Of the first violation
+		uint32_t violation; // Number of the first violation since the reset
+		
+		std::array<Sample, s_snippet_size> samples;
+	};
+	
+	LimitTest() = default;
+	LimitTest(const LimitTest& copy) = delete;
+	
+	// Both reset the results, the mask spans the given number of samples following the trigger and is empty until learned
+	void setBand(Sample low, Sample high);
+	void startMask(size_t length);
+	
+	// Widens the columns to the samples at given offsets from the trigger, finishing widens them by the margin
+	void learn(Sample sample, size_t offset);
+	void finishMask(Sample margin);
+	
+	// Sample is at given offset from the trigger, which the band ignores
+	void check(Sample sample, size_t offset, int64_t time_us);
+	
+	uint32_t getCheckedCount() const;
+	uint32_t getViolationCount() const;
+	
+	// Only meaningful once there are violations
+	int64_t getFirstViolationTime() const;
+	int64_t getLastViolationTime() const;
+	
+	// Snippets are numbered from 0 since the reset, returns false if the snippet is not complete yet or was overwritten
+	uint32_t getSnippetCount() const;
+	bool getSnippet(uint32_t number, Snippet* snippet) const;
+	
+private:
+	static constexpr size_t s_history_size = s_snippet_size / 2;
+	
+	std::array<Sample, s_columns> m_low  {};
+	std::array<Sample, s_columns> m_high {};
+	
+	// Column of an offset from the trigger in 16.16 fixed point, 0 for the band so that it uses the first column only
+	uint32_t m_column_factor = 0;
+	
+	std::atomic<uint32_t> m_checked    = 0;
+	std::atomic<uint32_t> m_violations = 0;
+	
+	std::atomic<int64_t> m_first_violation_time = 0;
+	std::atomic<int64_t> m_last_violation_time  = 0;
+	
+	// Last samples checked, the snippet starts with them
+	std::array<Sample, s_history_size> m_history {};
+	
+	std::array<Snippet, s_snippet_count> m_snippets {};
+	std::atomic<uint32_t> m_snippet_count = 0;
+	size_t m_snippet_fill = 0; // Samples in the snippet being captured, 0 if there is none
+	
+	void reset();
+	void onViolation(int64_t time_us);
+	
+};
+
+//========================================
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <bit>
+
+#include <LogicAnalyzer.hpp>
+
+//========================================
+
+void LogicAnalyzer::capture(std::span<const Sample> samples, size_t oldest, Sample low, Sample high)
+{
+	samples = samples.first(std::min(samples.size(), s_max_samples));
+	oldest = samples.empty()? 0: oldest % samples.size();
+	
+	m_sample_count = 0;
+	
+	// Starting level is whichever side of the middle the first sample is on
+	bool level = !samples.empty() && samples[oldest] > (low + high) / 2;
+	uint32_t word = 0;
+	
+	// Ring is unrolled as two contiguous parts
+	for (auto part: { samples.subspan(oldest), samples.first(oldest) })
+	{
+		for (Sample sample: part)
+		{
+			level = sample > high || (level && sample >= low);
+			word |= static_cast<uint32_t>(level) << (m_sample_count % 32);
+			
+			if (++m_sample_count % 32 == 0)
+			{
+				m_bits[m_sample_count / 32 - 1] = word;
+				word = 0;
+			}
+		}
+	}
+	
+	if (m_sample_count % 32)
+		m_bits[m_sample_count / 32] = word;
+	
+	findEdges();
+}
+
+size_t LogicAnalyzer::getSampleCount() const
+{
+	return m_sample_count;
+}
+
+bool LogicAnalyzer::getInitialLevel() const
+{
+	return m_sample_count && (m_bits[0] & 1);
+}
+
+bool LogicAnalyzer::getLevel(size_t position) const
+{
+	return position < m_sample_count && (m_bits[position / 32] >> (position % 32) & 1);
+}
+
+std::span<const uint32_t> LogicAnalyzer::getEdges() const
+{
+	return std::span(m_edges.data(), m_edge_count);
+}
+
+bool LogicAnalyzer::isTruncated() const
+{
+	return m_truncated;
+}
+
+// Word at a time: a bit differing from the one before it is an edge
+void LogicAnalyzer::findEdges()
+{
+	m_edge_count = 0;
+	m_truncated = false;
+	
+	uint32_t previous = getInitialLevel();
+	for (size_t i = 0; i < (m_sample_count + 31) / 32; i++)
+	{
+		uint32_t word = m_bits[i];
+		uint32_t changes = word ^ (word << 1 | previous);
+		
+		if (size_t valid = m_sample_count - i * 32; valid < 32)
+			changes &= (1u << valid) - 1;
+		
+		for (; changes; changes &= changes - 1)
+		{
+			if (m_edge_count == s_max_edges)
+			{
+				m_truncated = true;
+				return;
+			}
+			
+			m_edges[m_edge_count++] = i * 32 + std::countr_zero(changes);
+		}
+		
+		previous = word >> 31;
+	}
+}
+
+uint32_t LogicAnalyzer::getBitTime() const
+{
+	auto edges = getEdges();
+	if (edges.size() < 3)
+		return 0;
+	
+	uint32_t shortest = UINT32_MAX;
+	for (size_t i = 1; i < edges.size(); i++)
+		shortest = std::min(shortest, edges[i] - edges[i - 1]);
+	
+	// Every pulse is a whole number of bits, which averages the quantization of the shortest one out
+	uint64_t total_time = 0;
+	uint64_t total_bits = 0;
+	for (size_t i = 1; i < edges.size(); i++)
+	{
+		uint32_t width = edges[i] - edges[i - 1];
+		uint32_t bits = (width + shortest / 2) / shortest;
+		
+		// Idle gaps say little about the bit time
+		if (bits > 10)
+			continue;
+		
+		total_time += width;
+		total_bits += bits;
+	}
+	
+	return total_bits? (total_time << 16) / total_bits: 0;
+}
+
+size_t LogicAnalyzer::decodeUart(std::span<Byte> bytes) const
+{
+	uint32_t bit_time = getBitTime();
+	if (!bit_time)
+		return 0;
+	
+	// Middle of the bit, counting the start bit as 0
+	auto bit_center = [bit_time](uint32_t start, uint32_t bit) -> uint32_t
+	{
+		return start + ((2 * bit + 1) * static_cast<uint64_t>(bit_time) >> 17);
+	};
+	
+	auto edges = getEdges();
+	
+	size_t count = 0;
+	size_t edge = 0;
+	while (count < bytes.size())
+	{
+		// Start bit is a falling edge
+		while (edge < edges.size() && getLevel(edges[edge]))
+			edge++;
+		
+		if (edge == edges.size())
+			break;
+		
+		uint32_t start = edges[edge];
+		uint32_t stop = bit_center(start, 9);
+		if (stop >= m_sample_count)
+			break;
+		
+		Byte& byte = bytes[count++];
+		byte.position = start;
+		byte.value = 0;
+		byte.framing_error = !getLevel(stop);
+		
+		for (uint32_t bit = 0; bit < 8; bit++)
+			byte.value |= getLevel(bit_center(start, bit + 1)) << bit;
+		
+		// Next start bit cannot begin before the stop bit
+		while (edge < edges.size() && edges[edge] <= stop)
+			edge++;
+	}
+	
+	return count;
+}
+
+LogicAnalyzer::Pulses LogicAnalyzer::decodePulses() const
+{
+	auto edges = getEdges();
+	
+	// First rising edge
+	size_t first = 0;
+	while (first < edges.size() && !getLevel(edges[first]))
+		first++;
+	
+	Pulses pulses = {};
+	
+	uint64_t total_width = 0;
+	uint32_t last_rising = 0;
+	for (size_t i = first; i + 2 < edges.size(); i += 2)
+	{
+		total_width += edges[i + 1] - edges[i];
+		last_rising = edges[i + 2];
+		pulses.count++;
+	}
+	
+	if (pulses.count)
+	{
+		pulses.period = (last_rising - edges[first]) / pulses.count;
+		pulses.width = total_width / pulses.count;
+	}
+	
+	return pulses;
+}
+
+//========================================
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// One-channel logic analyzer over the sample buffer
+// Samples are thresholded with hysteresis into a bit-packed stream of 32 samples per word, then reduced to the
+// positions of level changes; decoders only look at those edges and at single bits, never at the samples
+class LogicAnalyzer
+{
+public:
+	static constexpr size_t s_max_samples = 25'000;
+	static constexpr size_t s_max_edges   = 1024;
+	
+	struct Byte
+	{
+		uint32_t position;      // Sample of the start bit edge
+		uint8_t  value;
+		bool     framing_error; // Stop bit was low
+	};
+	
+	struct Pulses
+	{
+		uint32_t count;  // Complete periods
+		uint32_t period; // Average, in samples
+		uint32_t width;  // Average high time, in samples
+	};
+	
+	LogicAnalyzer() = default;
+	LogicAnalyzer(const LogicAnalyzer& copy) = delete;
+	
+	// Ring buffer is captured starting from the oldest sample
+	// Level goes high above the high threshold and low below the low one, samples in between keep it
+	void capture(std::span<const Sample> samples, size_t oldest, Sample low, Sample high);
+	
+	size_t getSampleCount() const;
+	bool getInitialLevel() const;
+	bool getLevel(size_t position) const;
+	
+	// Samples at which the level flips, there are at most s_max_edges of them, the rest are dropped
+	std::span<const uint32_t> getEdges() const;
+	bool isTruncated() const;
+	
+	// 8N1 with idle high, the bit time is the shortest pulse refined by averaging all the pulses over it
+	// Returns the amount of bytes decoded
+	size_t decodeUart(std::span<Byte> bytes) const;
+	
+	// Bit time in samples as 16.16 fixed point, 0 if there are not enough edges
+	uint32_t getBitTime() const;
+	
+	Pulses decodePulses() const;
+	
+private:
+	std::array<uint32_t, (s_max_samples + 31) / 32> m_bits  {};
+	std::array<uint32_t, s_max_edges>               m_edges {};
+	
+	size_t m_sample_count = 0;
+	size_t m_edge_count   = 0;
+	bool   m_truncated    = false;
+	
+	void findEdges();
+	
+};
+
+//========================================
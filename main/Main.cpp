@@ -13,18 +13,41 @@
 
 #include "rom/ets_sys.h"
 
-#include <deque>
 #include <cstring>
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <numeric>
+#include <tuple>
+#include <limits>
+#include <cinttypes>
+#include <charconv>
+#include <cmath>
 
 #include <Peripherals/SH1106Display.hpp>
 #include <Peripherals/INA226.hpp>
 #include <Peripherals/RotaryEncoder.hpp>
 #include <Render.hpp>
+#include <Layer.hpp>
 #include <Selector.hpp>
+#include <DataLogger.hpp>
+#include <Settings.hpp>
+#include <Sample.hpp>
+#include <Performance.hpp>
+#include <Trace.hpp>
+#include <MathChannel.hpp>
+#include <LogicAnalyzer.hpp>
+#include <LimitTest.hpp>
+#include <Histogram.hpp>
+#include <Trigger.hpp>
+#include <EquivalentTime.hpp>
+#include <CicDecimator.hpp>
+#include <SignalGenerator.hpp>
+#include <SampleCodec.hpp>
+#include <CommandInterface.hpp>
+#include <Arena.hpp>
+#include <HeapGuard.hpp>
+#include <BlockQueue.hpp>
 
 //========================================
 
@@ -39,6 +62,29 @@ constexpr auto INTERNAL_ADC_UNIT       = ADC_UNIT_2;
 constexpr auto INTERNAL_ADC_CHANNEL    = ADC_CHANNEL_0;
 constexpr auto INTERNAL_ADC_ATTEN      = ADC_ATTEN_DB_2_5;
 constexpr auto INTERNAL_ADC_RESOLUTION = ADC_BITWIDTH_DEFAULT;
+constexpr int  INTERNAL_ADC_MAX_CODE   = 4095;
+
+// Math channel lags acquisition by at most this many samples, until the render loop is woken
+constexpr size_t MATH_BLOCK_SIZE       = 32;
+
+// Acquisition hands samples over to processing in blocks of this many, or fewer once the oldest one has waited too long
+constexpr size_t  SAMPLE_BLOCK_SIZE    = 32;
+constexpr size_t  SAMPLE_BLOCK_COUNT   = 8;
+constexpr int64_t MAX_BLOCK_LATENCY_US = 5'000;
+
+// Acquisition never yields, anything sharing its core starves, render and command tasks are on CPU0
+static_assert(CONFIG_PIPELINE_ACQUISITION_CORE != 0, "acquisition can't share CPU0 with the render loop");
+static_assert(CONFIG_PIPELINE_PROCESSING_CORE != CONFIG_PIPELINE_ACQUISITION_CORE, "processing can't share the acquisition core");
+
+// Amplitude histogram bars grow leftwards from the right edge of the plot, the fullest bin is this long
+constexpr int HISTOGRAM_WIDTH          = 16;
+
+// Equivalent-time sampling works in cycle counts, which are microseconds on the Linux target
+#ifdef CONFIG_IDF_TARGET_LINUX
+	constexpr uint32_t CYCLES_PER_US = 1;
+#else
+	constexpr uint32_t CYCLES_PER_US = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+#endif
 
 extern const uint8_t FONT_BEGIN[] asm("_binary_font_bin_start");
 extern const uint8_t FONT_END  [] asm("_binary_font_bin_end"  );
@@ -49,9 +95,9 @@ class Main
 {
 public:
 	Main() = default;
-
+	
 	void run();
-
+	
 private:
 	// Peripherals
 	SH1106Display m_display {};
@@ -61,6 +107,17 @@ private:
 	adc_oneshot_unit_handle_t m_internal_adc_handle      = nullptr;
 	adc_cali_handle_t         m_internal_adc_cali_handle = nullptr;
 	
+	// Calibration is a line, which lets the oversampled codes keep their fraction through it
+	int     m_internal_adc_offset_mv = 0;
+	int32_t m_internal_adc_slope     = 0; // Millivolts per code in 16.16 fixed point
+	int     m_internal_adc_read_ns   = 0;
+	
+	CicDecimator m_decimator {};
+	
+	// Generator source of each channel, only touched by the acquisition loop
+	SignalGenerator m_generator   {};
+	SignalGenerator m_generator_b {};
+	
 	// Selector menu
 	NumberSelectorItem<INA226::MeasurementType> m_min_voltage {
 		"vMin",
@@ -108,22 +165,339 @@ private:
 		false
 	};
 	
+	static constexpr OptionSelectorItem<PlotMode>::Option PLOT_MODES[] = {
+		{ "Average", PlotMode::Average },
+		{ "Peak",    PlotMode::Peak    }
+	};
+	
+	OptionSelectorItem<PlotMode> m_plot_mode {
+		"Plot mode",
+		PLOT_MODES
+	};
+	
 	enum class SignalSource: uint8_t
 	{
 		BusVoltage,
 		ShuntVoltage,
 		InternalADC,
-		TestSine
+		Generator,
+		OversampledADC // Internal ADC read back to back through the decimator, in 16ths of a millivolt
+	};
+	
+	static constexpr OptionSelectorItem<SignalSource>::Option SIGNAL_SOURCES[] = {
+		{ "Bus voltage",   SignalSource::BusVoltage     },
+		{ "Shunt voltage", SignalSource::ShuntVoltage   },
+		{ "Internal ADC",  SignalSource::InternalADC    },
+		{ "Generator",     SignalSource::Generator      },
+		{ "Oversampled",   SignalSource::OversampledADC }
 	};
 	
 	OptionSelectorItem<SignalSource> m_signal_source {
 		"Signal source",
-		{
-			{ "Bus voltage",   SignalSource::BusVoltage   },
-			{ "Shunt voltage", SignalSource::ShuntVoltage },
-			{ "Internal ADC",  SignalSource::InternalADC  },
-			{ "Sine",          SignalSource::TestSine     }
-		}
+		SIGNAL_SOURCES
+	};
+	
+	// Second channel, sampled right after the signal source when XY mode or math needs it
+	OptionSelectorItem<SignalSource> m_source_b {
+		"Source B",
+		SIGNAL_SOURCES
+	};
+	
+	static constexpr OptionSelectorItem<MathChannel::Operation>::Option MATH_OPERATIONS[] = {
+		{ "Off",        MathChannel::Operation::Off        },
+		{ "A-B",        MathChannel::Operation::Difference },
+		{ "AxB",        MathChannel::Operation::Product    },
+		{ "Integral",   MathChannel::Operation::Integral   },
+		{ "Derivative", MathChannel::Operation::Derivative }
+	};
+	
+	// Plotted instead of the signal source, or against it in XY mode
+	OptionSelectorItem<MathChannel::Operation> m_math_operation {
+		"Math",
+		MATH_OPERATIONS
+	};
+	
+	enum class DigitalMode: uint8_t
+	{
+		Off,
+		Logic,
+		Uart,
+		Pulses
+	};
+	
+	static constexpr OptionSelectorItem<DigitalMode>::Option DIGITAL_MODES[] = {
+		{ "Off",   DigitalMode::Off    },
+		{ "Logic", DigitalMode::Logic  },
+		{ "UART",  DigitalMode::Uart   },
+		{ "PWM",   DigitalMode::Pulses }
+	};
+	
+	// Plotted channel is thresholded halfway between vMin and vMax and shown as a logic trace, optionally decoded
+	OptionSelectorItem<DigitalMode> m_digital_mode {
+		"Digital",
+		DIGITAL_MODES
+	};
+	
+	enum class LimitMode: uint8_t
+	{
+		Off,
+		Band,
+		Mask
+	};
+	
+	static constexpr OptionSelectorItem<LimitMode>::Option LIMIT_MODES[] = {
+		{ "Off",  LimitMode::Off  },
+		{ "Band", LimitMode::Band },
+		{ "Mask", LimitMode::Mask }
+	};
+	
+	// Signal source is checked on every sample, mask needs a trigger and is learned from a buffer worth of samples following it
+	OptionSelectorItem<LimitMode> m_limit_mode {
+		"Limit test",
+		LIMIT_MODES
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_limit_low {
+		"Lower limit",
+		"%.3lf V",
+		0.00,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_limit_high {
+		"Upper limit",
+		"%.3lf V",
+		0.05,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_mask_margin {
+		"Mask margin",
+		"%.3lf V",
+		0.01,
+		0.00,
+		36.0,
+		.005
+	};
+	
+	static constexpr OptionSelectorItem<uint32_t>::Option HISTOGRAM_LENGTHS[] = {
+		{ "Endless", 0         },
+		{ "1k",      1'000     },
+		{ "10k",     10'000    },
+		{ "100k",    100'000   },
+		{ "1M",      1'000'000 }
+	};
+	
+	// Signal source is binned over its own range, as autoscale keeps moving the plot one; bars are drawn next to the plot
+	FlagSelectorItem m_histogram {
+		"Histogram",
+		false,
+		"On",
+		"Off"
+	};
+	
+	OptionSelectorItem<uint32_t> m_histogram_length {
+		"Hist. samples",
+		HISTOGRAM_LENGTHS,
+		10'000
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_histogram_low {
+		"Hist. min",
+		"%.3lf V",
+		0.00,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_histogram_high {
+		"Hist. max",
+		"%.3lf V",
+		0.05,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	enum class TriggerMode: uint8_t
+	{
+		Off,
+		Edge,
+		WidthLess,
+		WidthGreater,
+		WidthWithin,
+		Runt,
+		Glitch,
+		Dropout
+	};
+	
+	static constexpr OptionSelectorItem<TriggerMode>::Option TRIGGER_MODES[] = {
+		{ "Off",      TriggerMode::Off          },
+		{ "Edge",     TriggerMode::Edge         },
+		{ "Width <",  TriggerMode::WidthLess    },
+		{ "Width >",  TriggerMode::WidthGreater },
+		{ "Width in", TriggerMode::WidthWithin  },
+		{ "Runt",     TriggerMode::Runt         },
+		{ "Glitch",   TriggerMode::Glitch       },
+		{ "Dropout",  TriggerMode::Dropout      }
+	};
+	
+	// Signal source is captured around the trigger and held on screen until the next one, instead of free running
+	OptionSelectorItem<TriggerMode> m_trigger_mode {
+		"Trigger type",
+		TRIGGER_MODES
+	};
+	
+	FlagSelectorItem m_trigger_rising {
+		"Slope",
+		true,
+		"Rising",
+		"Falling"
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_trigger_low {
+		"Trigger low",
+		"%.3lf V",
+		0.02,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_trigger_high {
+		"Trigger high",
+		"%.3lf V",
+		0.03,
+		-36.0,
+		36.0,
+		.005
+	};
+	
+	IntSelectorItem m_trigger_width {
+		"Width",
+		"%d us",
+		1000,
+		40,
+		1'000'000,
+		40
+	};
+	
+	IntSelectorItem m_trigger_width_max {
+		"Max width",
+		"%d us",
+		2000,
+		40,
+		1'000'000,
+		40
+	};
+	
+	IntSelectorItem m_trigger_timeout {
+		"Timeout",
+		"%d ms",
+		100,
+		1,
+		10'000,
+		1
+	};
+	
+	// Repetitive signal is rebuilt from many triggers at a resolution finer than the sample period, using the edge
+	// thresholds and slope above; the window is centered on the trigger
+	FlagSelectorItem m_equivalent_time {
+		"Equiv. time",
+		false,
+		"On",
+		"Off"
+	};
+	
+	IntSelectorItem m_ets_window {
+		"ETS window",
+		"%d us",
+		2000,
+		20,
+		100'000,
+		20
+	};
+	
+	static constexpr OptionSelectorItem<SignalGenerator::Waveform>::Option GENERATOR_WAVEFORMS[] = {
+		{ "Sine",     SignalGenerator::Waveform::Sine     },
+		{ "Square",   SignalGenerator::Waveform::Square   },
+		{ "Triangle", SignalGenerator::Waveform::Triangle },
+		{ "Sawtooth", SignalGenerator::Waveform::Sawtooth },
+		{ "Pulse",    SignalGenerator::Waveform::Pulse    },
+		{ "Noise",    SignalGenerator::Waveform::Noise    },
+		{ "Chirp",    SignalGenerator::Waveform::Chirp    }
+	};
+	
+	// Generator source, channel B gets the same signal a quarter period ahead
+	OptionSelectorItem<SignalGenerator::Waveform> m_generator_waveform {
+		"Waveform",
+		GENERATOR_WAVEFORMS
+	};
+	
+	IntSelectorItem m_generator_frequency {
+		"Frequency",
+		"%d Hz",
+		50,
+		5,
+		12'500,
+		5
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_generator_amplitude {
+		"Amplitude",
+		"%.3lf V",
+		0.1,
+		0.0,
+		3.2,
+		.005
+	};
+	
+	NumberSelectorItem<INA226::MeasurementType> m_generator_offset {
+		"Offset",
+		"%.3lf V",
+		0.0,
+		-3.2,
+		3.2,
+		.005
+	};
+	
+	IntSelectorItem m_generator_duty {
+		"Duty",
+		"%d %%",
+		25,
+		1,
+		99,
+		1
+	};
+	
+	// Single sample spikes of the amplitude, none at 0
+	IntSelectorItem m_generator_glitches {
+		"Glitch every",
+		"%d ms",
+		0,
+		0,
+		10'000,
+		10
+	};
+	
+	// Signal source is plotted horizontally against source B or the math channel
+	FlagSelectorItem m_xy_mode {
+		"XY mode",
+		false,
+		"On",
+		"Off"
+	};
+	
+	FlagSelectorItem m_persistence {
+		"Persistence",
+		false,
+		"On",
+		"Off"
 	};
 	
 	FlagSelectorItem m_invert_display {
@@ -142,31 +516,341 @@ private:
 		1
 	};
 	
-	Selector m_selector {};
+	IntSelectorItem m_frame_rate {
+		"Frame rate",
+		"%d fps",
+		30,
+		5,
+		60,
+		5
+	};
+	
+	FlagSelectorItem m_logging {
+		"Data logger",
+		false,
+		"On",
+		"Off"
+	};
+	
+	enum class PerformanceOutput: uint8_t
+	{
+		Off,
+		Overlay,
+		Log
+	};
+	
+	static constexpr OptionSelectorItem<PerformanceOutput>::Option PERFORMANCE_OUTPUTS[] = {
+		{ "Off",     PerformanceOutput::Off     },
+		{ "Overlay", PerformanceOutput::Overlay },
+		{ "Log",     PerformanceOutput::Log     }
+	};
+	
+	OptionSelectorItem<PerformanceOutput> m_performance_output {
+		"Perf stats",
+		PERFORMANCE_OUTPUTS
+	};
+	
+	enum class TraceMode: uint8_t
+	{
+		Record,
+		Freeze
+	};
+	
+	static constexpr OptionSelectorItem<TraceMode>::Option TRACE_MODES[] = {
+		{ "Record", TraceMode::Record },
+		{ "Freeze", TraceMode::Freeze }
+	};
+	
+	OptionSelectorItem<TraceMode> m_trace_mode {
+		"Trace",
+		TRACE_MODES
+	};
+	
+	SubmenuSelectorItem<
+		FlagSelectorItem,
+		FlagSelectorItem
+	> m_xy_menu {
+		"XY",
+		m_xy_mode,
+		m_persistence
+	};
+	
+	SubmenuSelectorItem<
+		OptionSelectorItem<SignalGenerator::Waveform>,
+		IntSelectorItem,
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		IntSelectorItem,
+		IntSelectorItem
+	> m_generator_menu {
+		"Generator",
+		m_generator_waveform,
+		m_generator_frequency,
+		m_generator_amplitude,
+		m_generator_offset,
+		m_generator_duty,
+		m_generator_glitches
+	};
+	
+	SubmenuSelectorItem<
+		OptionSelectorItem<TriggerMode>,
+		FlagSelectorItem,
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		IntSelectorItem,
+		IntSelectorItem,
+		IntSelectorItem,
+		FlagSelectorItem,
+		IntSelectorItem
+	> m_trigger_menu {
+		"Trigger",
+		m_trigger_mode,
+		m_trigger_rising,
+		m_trigger_low,
+		m_trigger_high,
+		m_trigger_width,
+		m_trigger_width_max,
+		m_trigger_timeout,
+		m_equivalent_time,
+		m_ets_window
+	};
+	
+	SubmenuSelectorItem<
+		OptionSelectorItem<LimitMode>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>
+	> m_limits_menu {
+		"Limits",
+		m_limit_mode,
+		m_limit_low,
+		m_limit_high,
+		m_mask_margin
+	};
+	
+	SubmenuSelectorItem<
+		FlagSelectorItem,
+		OptionSelectorItem<uint32_t>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>
+	> m_histogram_menu {
+		"Amplitudes",
+		m_histogram,
+		m_histogram_length,
+		m_histogram_low,
+		m_histogram_high
+	};
+	
+	SubmenuSelectorItem<
+		FlagSelectorItem,
+		NumberSelectorItem<int8_t>,
+		IntSelectorItem
+	> m_screen_menu {
+		"Screen",
+		m_invert_display,
+		m_contrast,
+		m_frame_rate
+	};
+	
+	SubmenuSelectorItem<
+		FlagSelectorItem,
+		OptionSelectorItem<PerformanceOutput>,
+		OptionSelectorItem<TraceMode>
+	> m_diagnostics_menu {
+		"Diagnostics",
+		m_logging,
+		m_performance_output,
+		m_trace_mode
+	};
+	
+	Selector<
+		NumberSelectorItem<INA226::MeasurementType>,
+		NumberSelectorItem<INA226::MeasurementType>,
+		FlagSelectorItem,
+		IntSelectorItem,
+		NumberSelectorItem<int>,
+		FlagSelectorItem,
+		OptionSelectorItem<PlotMode>,
+		OptionSelectorItem<SignalSource>,
+		OptionSelectorItem<SignalSource>,
+		OptionSelectorItem<MathChannel::Operation>,
+		OptionSelectorItem<DigitalMode>,
+		decltype(m_generator_menu),
+		decltype(m_xy_menu),
+		decltype(m_trigger_menu),
+		decltype(m_limits_menu),
+		decltype(m_histogram_menu),
+		decltype(m_screen_menu),
+		decltype(m_diagnostics_menu)
+	> m_selector {
+		m_min_voltage,
+		m_max_voltage,
+		m_autoscale,
+		m_sample_rate_hz,
+		m_window_size_ms,
+		m_draw_line,
+		m_plot_mode,
+		m_signal_source,
+		m_source_b,
+		m_math_operation,
+		m_digital_mode,
+		m_generator_menu,
+		m_xy_menu,
+		m_trigger_menu,
+		m_limits_menu,
+		m_histogram_menu,
+		m_screen_menu,
+		m_diagnostics_menu
+	};
+	
+	Settings m_settings {};
+	
+	// Long-term logging
+	DataLogger m_logger {};
+	
+	// Diagnostics
+	Performance m_performance {};
 	
 	// Font
 	Font m_font { FONT_BEGIN, FONT_END };
 	
-	// Samples
+	// Screen layers, composed into the display bottom to top
+	Layer m_background  {}; // Graticule, drawn once
+	Layer m_trace_layer {}; // Plot and cursor, redrawn with new data
+	Layer m_ui_layer    {}; // Overlay and menu, redrawn with input
+	
+	// Samples, carved out of the arena anew with every resize, which the processing loop only does once the render
+	// loop has let go of the buffers and waits for it to be over
+	enum class ResizeState: uint8_t
+	{
+		Idle,
+		Requested,
+		Released
+	};
+	
+	std::atomic<ResizeState> m_resize_state = ResizeState::Idle;
+	
+	Arena m_sample_arena {};
 	size_t m_current_sample = 0;
-	std::span<INA226::MeasurementType> m_samples {};
-	QueueHandle_t m_queue = nullptr;
+	std::span<Sample> m_samples {};
+	std::span<Sample> m_samples_b {};    // Only allocated when XY mode or math needs it
+	std::span<Sample> m_samples_math {}; // Only allocated when math is on
+	
+	MathChannel m_math {};
+	
+	// Digital mode, only touched by the render loop
+	LogicAnalyzer m_logic {};
+	
+	// Filled by the processing loop, copied out by the render loop to be drawn
+	EquivalentTime m_ets {};
+	std::array<Sample, EquivalentTime::s_bins> m_ets_waveform {};
+	
+	// Written by the processing loop, results are shown and logged by the render loop
+	LimitTest m_limit_test {};
 	
+	// Written by the processing loop, drawn next to the plot and logged by the render loop
+	Histogram m_amplitude_histogram {};
+	
+	// Buffers are left alone by the processing loop while a triggered capture is held for the render loop to draw
+	Trigger m_trigger {};
+	std::atomic<bool> m_capture_held = false;
+	
+	// Acquisition control of the command interface, written by the render loop
+	// Single acquisition is over once the processing loop echoes the request number into done; it also tells
+	// whether it is still storing samples, so that the buffers are only read once it has let go of them
+	enum class RunMode: uint8_t
+	{
+		Run,
+		Stop,
+		Single
+	};
+	
+	std::atomic<RunMode>  m_run_mode       = RunMode::Run;
+	std::atomic<uint32_t> m_single_request = 0;
+	std::atomic<uint32_t> m_single_done    = 0;
+	std::atomic<bool>     m_acquiring      = true;
+	
+	// Remote control, each request is handed over to the render loop, which owns the settings
+	CommandInterface m_commands {};
+	CommandInterface::Command m_pending_command {};
+	
+	// Render loop sleeps until notified with these bits or the frame period passes
+	enum RenderNotification: uint32_t
+	{
+		NewData = 1 << 0, // Enough samples to change the plot
+		Input   = 1 << 1, // Knob button
+		Request = 1 << 2, // Remote command waiting to be executed
+		Resize  = 1 << 3  // Buffers about to be resized, or done with it
+	};
+	
+	// Pipeline: the acquisition loop fills blocks and queues them to the processing loop, which stores them into the
+	// buffers drawn by the render loop and queues them back; a block belongs to whichever side last popped it
+	struct SampleBlock
+	{
+		size_t count;
+		std::array<Sample,   SAMPLE_BLOCK_SIZE> samples;
+		std::array<Sample,   SAMPLE_BLOCK_SIZE> samples_b; // Zero unless channel B is in use
+		std::array<int64_t,  SAMPLE_BLOCK_SIZE> times;     // esp_timer time of each sample
+		std::array<uint32_t, SAMPLE_BLOCK_SIZE> cycles;    // Cycle count at the start of each conversion
+		std::array<uint16_t, SAMPLE_BLOCK_SIZE> missed;    // Sample periods without a sample right before each one
+	};
+	
+	std::array<SampleBlock, SAMPLE_BLOCK_COUNT> m_blocks {};
+	BlockQueue<SampleBlock, SAMPLE_BLOCK_COUNT> m_free_blocks   {};
+	BlockQueue<SampleBlock, SAMPLE_BLOCK_COUNT> m_filled_blocks {};
+	
+	TaskHandle_t m_render_task     = nullptr;
+	TaskHandle_t m_processing_task = nullptr;
+	TaskHandle_t m_command_task    = nullptr;
+	
+	void initSettings();
 	void initDisplay();
 	void initADC();
 	void initInternalAdc();
 	void initKnob();
+	void initLogger();
+	void initCommands();
 	
 	void renderLoop();
-	void measurementLoop();
+	void renderTriggerMarker();
+	void renderEquivalentTime();
+	void renderDigital(std::span<const Sample> samples, double lsb, double min_voltage, double max_voltage);
+	void renderLimitTest();
+	void renderHistogram(double min_voltage, double max_voltage);
+	void logHistogram(uint32_t* logged_results);
+	void logViolations(uint32_t* logged_snippets);
+	void logTrigger();
+	void acquisitionLoop();
+	void processingLoop();
+	void commandLoop();
+	bool executeCommand(const CommandInterface::Command& command);
+	void sendSamples();
+	void sendRecords(std::string_view tier_name, std::string_view from);
+	
+	Sample readSample(SignalSource source, SignalGenerator& generator);
+	int readInternalAdcMillivolts();
+	Sample readOversampledAdc();
+	void resizeBuffer(size_t new_size, bool channel_b, bool math);
+	void processMath(size_t count);
+	void holdCapture();
 	
-	float readInternalAdcVoltage();
-	void resizeBuffer(size_t new_size);
+	static constexpr INA226::MeasurementType GetSampleLSB(SignalSource source);
+	static Sample GetSampleCode(double voltage, double lsb);
+	static constexpr Trigger::Type GetTriggerType(TriggerMode mode);
+	static TickType_t GetTicks(int64_t time_us);
 	
 };
 
 //======================================== Initialization
 
+void Main::initSettings()
+{
+	m_settings.setup();
+	m_settings.restore(m_selector);
+	
+	ESP_LOGI(TAG, "settings initialized");
+}
+
 void Main::initDisplay()
 {
 	spi_bus_config_t spi_bus_config = {};
@@ -176,7 +860,7 @@ void Main::initDisplay()
 	spi_bus_config.quadwp_io_num = -1;
 	spi_bus_config.quadhd_io_num = -1;
 	spi_bus_config.max_transfer_sz = 0xFFFF;
-
+	
 	auto result = spi_bus_initialize(SCREEN_SPI_HOST, &spi_bus_config, SPI_DMA_CH_AUTO);
 	if (result != ESP_OK && result != ESP_ERR_INVALID_STATE)
 		ESP_ERROR_CHECK(result);
@@ -189,6 +873,8 @@ void Main::initDisplay()
 		1'000'000 * CONFIG_DISPLAY_SPI_FREQ_MHZ
 	);
 	
+	Graticule(m_background, Vector2i(8, 4));
+	
 	ESP_LOGI(TAG, "display initialized");
 }
 
@@ -219,11 +905,11 @@ void Main::initADC()
 		INA226::BusVoltageConversionTime140us   |
 		INA226::ModeShuntAndBusContinuous
 	);
-
+	
 	ESP_LOGI(TAG, "ADC initialized");
 	
-	m_queue = xQueueCreate(16, sizeof(uint32_t));
-	resizeBuffer((m_sample_rate_hz.getValue() * m_window_size_ms.getValue()) / 1000);
+	m_sample_arena.setup(CONFIG_SAMPLE_ARENA_SIZE_KB * 1024);
+	resizeBuffer((m_sample_rate_hz.getValue() * m_window_size_ms.getValue()) / 1000, false, false);
 }
 
 void Main::initInternalAdc()
@@ -243,6 +929,22 @@ void Main::initInternalAdc()
 	cali_cfg.atten = INTERNAL_ADC_ATTEN;
 	cali_cfg.bitwidth = INTERNAL_ADC_RESOLUTION;
 	ESP_ERROR_CHECK(adc_cali_create_scheme_line_fitting(&cali_cfg, &m_internal_adc_cali_handle));
+	
+	int max_code = 0;
+	ESP_ERROR_CHECK(adc_cali_raw_to_voltage(m_internal_adc_cali_handle, 0, &m_internal_adc_offset_mv));
+	ESP_ERROR_CHECK(adc_cali_raw_to_voltage(m_internal_adc_cali_handle, INTERNAL_ADC_MAX_CODE, &max_code));
+	m_internal_adc_slope = (static_cast<int64_t>(max_code - m_internal_adc_offset_mv) << 16) / INTERNAL_ADC_MAX_CODE;
+	
+	// Oversampling decimation is chosen from the time a read takes
+	constexpr int READ_COUNT = 64;
+	auto start_time = esp_timer_get_time();
+	
+	int raw = 0;
+	for (int i = 0; i < READ_COUNT; i++)
+		ESP_ERROR_CHECK(adc_oneshot_read(m_internal_adc_handle, INTERNAL_ADC_CHANNEL, &raw));
+	
+	m_internal_adc_read_ns = std::max<int>((esp_timer_get_time() - start_time) * 1000 / READ_COUNT, 1);
+	ESP_LOGI(TAG, "internal ADC read takes %d ns", m_internal_adc_read_ns);
 }
 
 void Main::initKnob()
@@ -255,16 +957,8 @@ void Main::initKnob()
 		static_cast<gpio_num_t>(CONFIG_ENCODER_PIN_B),
 		static_cast<gpio_num_t>(CONFIG_ENCODER_PIN_PRESS)
 	);
-
-	m_selector += &m_min_voltage;
-	m_selector += &m_max_voltage;
-	m_selector += &m_autoscale;
-	m_selector += &m_sample_rate_hz;
-	m_selector += &m_window_size_ms;
-	m_selector += &m_draw_line;
-	m_selector += &m_signal_source;
-	m_selector += &m_invert_display;
-	m_selector += &m_contrast;
+	
+	m_knob.setNotification(m_render_task, Input);
 	
 	ESP_LOGI(TAG, "knob initialized");
 	ESP_LOGI(
@@ -276,6 +970,24 @@ void Main::initKnob()
 	);
 }
 
+void Main::initLogger()
+{
+	m_logger.setup();
+	ESP_LOGI(TAG, "logger initialized");
+}
+
+void Main::initCommands()
+{
+	m_commands.setup(
+		static_cast<uart_port_t>(CONFIG_COMMAND_UART_PORT),
+		CONFIG_COMMAND_PIN_TX,
+		CONFIG_COMMAND_PIN_RX,
+		CONFIG_COMMAND_BAUD_RATE
+	);
+	
+	ESP_LOGI(TAG, "command interface initialized");
+}
+
 //======================================== Rendering
 
 void Main::renderLoop()
@@ -287,150 +999,1066 @@ void Main::renderLoop()
 	);
 	
 	const auto& display_size = m_display.getSize();
+	
+	// Limit test results last shown and logged
+	std::tuple<uint32_t, bool> shown_limit_test {};
+	uint32_t logged_snippets = 0;
+	
+	// Histogram results logged
+	uint32_t logged_histograms = 0;
+	
+	bool logging = m_logging;
+	
+	auto next_frame_time = esp_timer_get_time();
 	while (true)
 	{
-		// Queue
-		uint32_t sample_time = 0;
-		if (xQueueReceive(m_queue, &sample_time, 0) == pdPASS)
-			ESP_LOGW(TAG, "can't keep sample rate: last sample took %" PRIu32 " us", sample_time);
+		int64_t frame_period_us = 1'000'000 / m_frame_rate.getValue();
 		
-		// Knob
-		RotaryEncoder::Event event;
-		while (m_knob.pollEvent(&event))
+		// Sleeping until there is new data or a button press, but no longer than a frame period, so that knob rotation,
+		// animations and statistics keep going; notifications coming in before the frame is due are merged
+		uint32_t notification = 0;
+		xTaskNotifyWait(0, UINT32_MAX, &notification, GetTicks(frame_period_us));
+		
+		if (auto delay_us = next_frame_time - esp_timer_get_time(); delay_us > 0)
 		{
-			if (m_selector.onEvent(event))
-				continue;
+			vTaskDelay(GetTicks(delay_us));
 			
-			switch (event.type)
+			uint32_t pending = 0;
+			xTaskNotifyWait(0, UINT32_MAX, &pending, 0);
+			notification |= pending;
+		}
+		
+		// Nothing reads the buffers until the resize is over, notifications coming in meanwhile are merged; a late one
+		// of a resize already over finds nothing requested
+		if ((notification & Resize) && m_resize_state.load(std::memory_order_acquire) == ResizeState::Requested)
+		{
+			m_resize_state.store(ResizeState::Released, std::memory_order_release);
+			xTaskNotifyGive(m_processing_task);
+			
+			while (m_resize_state.load(std::memory_order_acquire) != ResizeState::Idle)
 			{
-				case RotaryEncoder::Event::Rotation:
-					m_min_voltage.setValue(m_min_voltage + .05 * event.delta);
-					m_max_voltage.setValue(m_max_voltage + .05 * event.delta);
-					break;
-				
-				default:
-					break;
-				
+				uint32_t pending = 0;
+				xTaskNotifyWait(0, UINT32_MAX, &pending, portMAX_DELAY);
+				notification |= pending;
 			}
+			
+			notification |= NewData;
 		}
 		
+		auto frame_start_time = esp_timer_get_time();
+		bool redraw_trace = notification & NewData;
+		bool redraw_ui = m_selector.isAnimating();
+		bool knob_event = false;
+		
+		// Diagnostics
+		if (m_performance.update(frame_start_time))
+		{
+			if (m_performance_output.getSelectedOption() == PerformanceOutput::Log)
+				m_performance.log();
+			
+			redraw_ui |= m_performance_output.getSelectedOption() == PerformanceOutput::Overlay;
+		}
+		
+		// Triggered trace only changes with a new capture, which stays held until drawn
+		bool ets = m_equivalent_time;
+		bool triggered = !ets && m_trigger_mode.getSelectedOption() != TriggerMode::Off;
+		bool capture_held = triggered && m_capture_held.load(std::memory_order_acquire);
+		if (triggered)
+			redraw_trace = capture_held;
+		
+		// Limit test
+		if (m_limit_mode.getSelectedOption() != LimitMode::Off)
+		{
+			std::tuple limit_test(m_limit_test.getViolationCount(), m_limit_test.getCheckedCount() > 0);
+			redraw_ui |= limit_test != shown_limit_test;
+			shown_limit_test = limit_test;
+			
+			logViolations(&logged_snippets);
+		}
+		
+		// Amplitude histogram, only complete results are logged
+		if (m_histogram)
+			logHistogram(&logged_histograms);
+		
+		// Trace is dumped once frozen
+		if ((m_trace_mode.getSelectedOption() == TraceMode::Freeze) == Trace::IsRecording())
+		{
+			if (Trace::IsRecording())
+				Trace::Freeze();
+			
+			else
+				Trace::Start();
+		}
+		
+		// Knob
+		RotaryEncoder::Event event;
+		while (m_knob.pollEvent(&event))
+		{
+			redraw_ui = knob_event = true;
+			redraw_trace |= !triggered;
+			
+			if (m_selector.onEvent(event))
+				continue;
+			
+			switch (event.type)
+			{
+				case RotaryEncoder::Event::Rotation:
+					m_min_voltage.setValue(m_min_voltage + .05 * event.delta);
+					m_max_voltage.setValue(m_max_voltage + .05 * event.delta);
+					break;
+				
+				default:
+					break;
+			
+			}
+		}
+		
+		// Remote command, taken like a knob event, so that the settings keep a single writer
+		if (notification & Request)
+		{
+			if (executeCommand(m_pending_command))
+			{
+				redraw_ui = true;
+				redraw_trace |= !triggered;
+			}
+			
+			xTaskNotifyGive(m_command_task);
+		}
+		
+		m_settings.update(m_selector);
+		
 		if (m_invert_display != m_display.isInverted())
 			m_display.setInverted(m_invert_display);
 		
 		if (m_contrast != m_display.getContrast())
 			m_display.setContrast(m_contrast);
 		
-		// Plot
-		m_display.clear();
+		// Logger paces its erases while samples are being stored, and writes out what is staged once turned off
+		m_logger.setErasePaced(m_acquiring.load(std::memory_order_acquire));
 		
-		if (m_autoscale)
+		if (m_logging != logging)
 		{
-			auto [min, max] = std::ranges::minmax_element(m_samples);
-			m_min_voltage.setValue(*min);
-			m_max_voltage.setValue(*max);
+			logging = m_logging;
+			if (!logging)
+				m_logger.flush();
 		}
 		
-		auto min_voltage = m_min_voltage.getValue();
-		auto max_voltage = m_max_voltage.getValue();
+		if (!redraw_trace && !redraw_ui)
+			continue;
+		
+		next_frame_time = frame_start_time + frame_period_us;
 		
-		Vector2i prev(-1, 0);
-		INA226::MeasurementType signal = 0;
-		for (size_t i = 0, signal_count = 0; i < m_samples.size(); i++)
 		{
-			signal += m_samples[i];
-			signal_count++;
+			Performance::Scope frame_scope(m_performance, Performance::Frame);
+			
+			TRACE_SYNC();
+			TRACE_SCOPE(Frame);
+			
+			auto render_start = Performance::GetCycleCount();
+			TRACE_BEGIN(Render);
 			
-			if (int x = i * display_size.x / m_samples.size(); x != prev.x)
+			// Plot
+			// Math channel stands in for source B in XY mode and for the signal source otherwise, once allocated
+			bool math =
+				m_math_operation.getSelectedOption() != MathChannel::Operation::Off &&
+				m_samples_math.size() == m_samples.size();
+			
+			std::span<const Sample> samples_y = math? m_samples_math: m_samples_b;
+			if (redraw_trace && m_xy_mode && samples_y.size() == m_samples.size())
 			{
-				signal /= signal_count;
+				// Persistent points stay until any setting changes
+				if (!m_persistence || knob_event)
+					m_trace_layer.clear();
 				
-				Vector2i curr(
-					x,
-					display_size.y * (1.f - (signal - min_voltage) / (max_voltage - min_voltage))
-				);
+				auto x_lsb = GetSampleLSB(m_signal_source.getSelectedOption());
+				auto y_lsb = math? m_math.getLSB(): GetSampleLSB(m_source_b.getSelectedOption());
 				
-				if (x)
-					Line(m_display, prev, curr);
+				// Each axis fits its own channel, voltage limits apply to both otherwise
+				AxisScale x_scale, y_scale;
+				if (m_autoscale)
+				{
+					auto [x_min, x_max] = std::ranges::minmax_element(m_samples);
+					auto [y_min, y_max] = std::ranges::minmax_element(samples_y);
+					x_scale = AxisScale(*x_min, *x_max, display_size.x);
+					y_scale = AxisScale(*y_min, *y_max, display_size.y);
+				}
 				
-				prev = curr;
-				signal = 0;
-				signal_count = 0;
+				else
+				{
+					x_scale = AxisScale::FromVolts(m_min_voltage, m_max_voltage, x_lsb, display_size.x);
+					y_scale = AxisScale::FromVolts(m_min_voltage, m_max_voltage, y_lsb, display_size.y);
+				}
+				
+				PlotXY(m_trace_layer, m_samples, samples_y, x_scale, y_scale);
 			}
+			
+			else if (redraw_trace)
+			{
+				m_trace_layer.clear();
+				
+				std::span<const Sample> samples = math? m_samples_math: m_samples;
+				auto sample_lsb = math? m_math.getLSB(): GetSampleLSB(m_signal_source.getSelectedOption());
+				
+				// Reconstructed waveform of the signal source replaces the buffer once anything has been binned
+				bool ets_waveform = ets && m_ets.getWaveform(m_ets_waveform);
+				if (ets_waveform)
+				{
+					samples = m_ets_waveform;
+					sample_lsb = GetSampleLSB(m_signal_source.getSelectedOption());
+				}
+				
+				if (m_autoscale)
+				{
+					auto [min, max] = std::ranges::minmax_element(samples);
+					m_min_voltage.setValue(*min * sample_lsb);
+					m_max_voltage.setValue(*max * sample_lsb);
+				}
+				
+				auto min_voltage = m_min_voltage.getValue();
+				auto max_voltage = m_max_voltage.getValue();
+				
+				if (ets)
+				{
+					if (ets_waveform)
+						Plot(m_trace_layer, samples, sample_lsb, min_voltage, max_voltage, m_plot_mode.getSelectedOption());
+					
+					renderEquivalentTime();
+				}
+				
+				else if (m_digital_mode.getSelectedOption() != DigitalMode::Off)
+					renderDigital(samples, sample_lsb, min_voltage, max_voltage);
+				
+				else
+				{
+					Plot(m_trace_layer, samples, sample_lsb, min_voltage, max_voltage, m_plot_mode.getSelectedOption());
+					
+					if (triggered)
+						renderTriggerMarker();
+					
+					else if (m_draw_line)
+					{
+						auto line_x = m_current_sample * display_size.x / m_samples.size();
+						Line(m_trace_layer, Vector2i(line_x, 0), Vector2i(line_x, display_size.y));
+					}
+					
+					if (m_histogram)
+						renderHistogram(min_voltage, max_voltage);
+				}
+			}
+			
+			if (capture_held)
+			{
+				logTrigger();
+				m_capture_held.store(false, std::memory_order_release);
+			}
+			
+			// Interface
+			if (redraw_ui)
+			{
+				m_ui_layer.clear();
+				
+				if (m_performance_output.getSelectedOption() == PerformanceOutput::Overlay)
+					m_performance.render(m_ui_layer, m_font);
+				
+				if (m_limit_mode.getSelectedOption() != LimitMode::Off)
+					renderLimitTest();
+				
+				TRACE_SCOPE(SelectorRender);
+				m_selector.render(m_ui_layer, m_font);
+			}
+			
+			m_display.compose(m_background, Layer::Blend::Copy);
+			m_display.compose(m_trace_layer, Layer::Blend::Or);
+			m_display.compose(m_ui_layer, Layer::Blend::Over);
+			
+			TRACE_END(Render);
+			m_performance.addStageTime(Performance::Render, Performance::GetCycleCount() - render_start);
+			
+			{
+				Performance::Scope flush_scope(m_performance, Performance::Flush);
+				TRACE_SCOPE(Flush);
+				m_display.flush();
+			}
+		}
+		
+		// Frame that took longer than the period is not followed by late ones back to back,
+		// the next frame shows the latest data instead
+		if (auto frame_time_us = esp_timer_get_time() - frame_start_time; frame_time_us > frame_period_us)
+			m_performance.addSkippedFrames(frame_time_us / frame_period_us);
+	}
+}
+
+// Trigger point is in the middle of both the held capture and the equivalent-time window
+void Main::renderTriggerMarker()
+{
+	int center_x = m_display.getSize().x / 2;
+	for (int y = 0; y < 3; y++)
+		Line(m_trace_layer, Vector2i(center_x - 2 + y, y), Vector2i(center_x + 2 - y, y));
+}
+
+// Share of the bins filled so far and the equivalent sample rate, top left
+void Main::renderEquivalentTime()
+{
+	renderTriggerMarker();
+	
+	uint32_t rate_khz = EquivalentTime::s_bins * 1000 / std::max(m_ets_window.getValue(), 1);
+	Text(
+		m_trace_layer,
+		m_font,
+		Vector2i(0, 0),
+		FormatTmp("ETS %zu%% %" PRIu32 "kS/s", 100 * m_ets.getFilledBins() / EquivalentTime::s_bins, rate_khz)
+	);
+}
+
+// Unlike the analog plot, the logic trace starts from the oldest sample, so that decoding is not cut at the write position
+void Main::renderDigital(std::span<const Sample> samples, double lsb, double min_voltage, double max_voltage)
+{
+	const auto& display_size = m_display.getSize();
+	
+	// Hysteresis is a fifth of the range
+	double middle = (min_voltage + max_voltage) / 2;
+	double hysteresis = (max_voltage - min_voltage) / 10;
+	m_logic.capture(samples, m_current_sample, GetSampleCode(middle - hysteresis, lsb), GetSampleCode(middle + hysteresis, lsb));
+	
+	if (!m_logic.getSampleCount())
+		return;
+	
+	// Decoded values take the top text row
+	LogicTrace(
+		m_trace_layer,
+		m_logic.getEdges(),
+		m_logic.getInitialLevel(),
+		m_logic.getSampleCount(),
+		m_font.getGlyphSize().y + 4,
+		display_size.y - 4
+	);
+	
+	switch (m_digital_mode.getSelectedOption())
+	{
+		// Labels overlapping the previous one are skipped, bytes with a framing error are marked
+		case DigitalMode::Uart:
+		{
+			std::array<LogicAnalyzer::Byte, 32> bytes;
+			size_t count = m_logic.decodeUart(bytes);
+			
+			int next_x = 0;
+			for (const auto& byte: std::span(bytes).first(count))
+			{
+				int x = byte.position * display_size.x / m_logic.getSampleCount();
+				if (x < next_x)
+					continue;
+				
+				auto text = FormatTmp(byte.framing_error? "%02X!": "%02X", byte.value);
+				Text(m_trace_layer, m_font, Vector2i(x, 0), text);
+				next_x = x + (text.length() + 1) * m_font.getGlyphSize().x;
+			}
+			
+			break;
 		}
 		
-		if (m_draw_line)
+		case DigitalMode::Pulses:
 		{
-			auto line_x = m_current_sample * display_size.x / m_samples.size();
-			Line(m_display, Vector2i(line_x, 0), Vector2i(line_x, display_size.y));
+			auto pulses = m_logic.decodePulses();
+			if (pulses.count && pulses.period)
+				Text(
+					m_trace_layer,
+					m_font,
+					Vector2i(0, 0),
+					FormatTmp(
+						"%" PRIu32 "Hz %" PRIu32 "%%",
+						static_cast<uint32_t>(m_sample_rate_hz.getValue()) / pulses.period,
+						100 * pulses.width / pulses.period
+					)
+				);
+			
+			break;
 		}
+		
+		default:
+			break;
+	
+	}
+}
+
+// Pass/fail indicator in the bottom right corner, the mask is still being learned while nothing has been checked
+void Main::renderLimitTest()
+{
+	const auto& display_size = m_display.getSize();
 	
-		m_selector.render(m_display, m_font);
-		m_display.flush();
+	std::string_view text = "WAIT";
+	if (m_limit_test.getCheckedCount())
+	{
+		if (uint32_t violations = m_limit_test.getViolationCount())
+			text = FormatTmp("FAIL %" PRIu32, violations);
 		
-		vTaskDelay(1);
+		else
+			text = "PASS";
 	}
+	
+	Text(
+		m_ui_layer,
+		m_font,
+		Vector2i(display_size.x - text.length() * m_font.getGlyphSize().x, display_size.y - m_font.getGlyphSize().y),
+		text,
+		true,
+		true
+	);
 }
 
-//======================================== Measurement
+// Bins are drawn at the rows of the plot they cover, so that the bars line up with the trace; statistics of the
+// latest result go to the bottom left corner, mean and deviation above median and the spread of the 1st to 99th percentile
+void Main::renderHistogram(double min_voltage, double max_voltage)
+{
+	const auto& display_size = m_display.getSize();
+	const auto& glyph_size = m_font.getGlyphSize();
+	
+	Histogram::Result result;
+	if (!m_amplitude_histogram.getResult(&result))
+		return;
+	
+	auto lsb = GetSampleLSB(m_signal_source.getSelectedOption());
+	auto scale = AxisScale::FromVolts(min_voltage, max_voltage, lsb, display_size.y);
+	uint32_t max_count = std::max(*std::ranges::max_element(result.bins), uint32_t(1));
+	
+	// Trace is cleared under the bars, so that they stay readable
+	Rectangle(m_trace_layer, Vector2i(display_size.x - HISTOGRAM_WIDTH, 0), Vector2i(HISTOGRAM_WIDTH, display_size.y), false);
+	
+	const int bottom = display_size.y - 1;
+	for (size_t bin = 0; bin < Histogram::s_bins; bin++)
+	{
+		if (!result.bins[bin])
+			continue;
+		
+		int32_t first = result.low + static_cast<int32_t>(bin * result.bin_width);
+		int32_t last = first + result.bin_width - 1;
+		if (last < scale.min || first > scale.max)
+			continue;
+		
+		int top = bottom - scale(std::min<int32_t>(last, std::numeric_limits<Sample>::max()));
+		int bin_bottom = bottom - scale(std::max<int32_t>(first, std::numeric_limits<Sample>::min()));
+		int length = std::max<int>(static_cast<uint64_t>(result.bins[bin]) * HISTOGRAM_WIDTH / max_count, 1);
+		
+		Rectangle(m_trace_layer, Vector2i(display_size.x - length, top), Vector2i(length, bin_bottom - top + 1));
+	}
+	
+	Histogram::Statistics statistics;
+	if (!Histogram::GetStatistics(result, &statistics))
+		return;
+	
+	Text(
+		m_trace_layer,
+		m_font,
+		Vector2i(0, display_size.y - 2 * glyph_size.y),
+		FormatTmp("M%.3lf S%.1lfm", statistics.mean * lsb, statistics.deviation * lsb * 1000),
+		true,
+		true
+	);
+	
+	Text(
+		m_trace_layer,
+		m_font,
+		Vector2i(0, display_size.y - glyph_size.y),
+		FormatTmp("~%.3lf R%.1lfm", statistics.median * lsb, (statistics.high_percentile - statistics.low_percentile) * lsb * 1000),
+		true,
+		true
+	);
+}
 
-void Main::measurementLoop()
+// Each complete result is logged once; results overwritten before the render loop got to them are skipped
+void Main::logHistogram(uint32_t* logged_results)
 {
-	// 60 ms
+	uint32_t result_count = m_amplitude_histogram.getResultCount();
+	if (result_count == *logged_results)
+		return;
+	
+	*logged_results = result_count;
+	
+	Histogram::Result result;
+	Histogram::Statistics statistics;
+	if (
+		!m_amplitude_histogram.getResult(&result) ||
+		!result.complete ||
+		!Histogram::GetStatistics(result, &statistics)
+	)
+		return;
 	
+	auto lsb = GetSampleLSB(m_signal_source.getSelectedOption());
 	ESP_LOGI(
 		TAG,
-		"measurement loop is running on CPU%d",
-		static_cast<int>(xTaskGetCoreID(xTaskGetCurrentTaskHandle()))
+		"histogram of %" PRIu32 " samples: mean %.4lf V, deviation %.2lf mV, median %.4lf V, "
+		"1%% %.4lf V, 99%% %.4lf V, %" PRIu32 " below and %" PRIu32 " above range",
+		result.count,
+		statistics.mean * lsb,
+		statistics.deviation * lsb * 1000,
+		statistics.median * lsb,
+		statistics.low_percentile * lsb,
+		statistics.high_percentile * lsb,
+		result.below,
+		result.above
 	);
+}
 
+// Snippets are reported by their extremes, the ones overwritten before the render loop got to them are skipped
+void Main::logViolations(uint32_t* logged_snippets)
+{
+	auto lsb = GetSampleLSB(m_signal_source.getSelectedOption());
+	
+	uint32_t snippet_count = m_limit_test.getSnippetCount();
+	if (snippet_count < *logged_snippets)
+		*logged_snippets = 0;
+	
+	*logged_snippets = std::max<uint32_t>(*logged_snippets, snippet_count - std::min<uint32_t>(snippet_count, LimitTest::s_snippet_count));
+	for (; *logged_snippets < snippet_count; ++*logged_snippets)
+	{
+		LimitTest::Snippet snippet;
+		if (!m_limit_test.getSnippet(*logged_snippets, &snippet))
+			continue;
+		
+		auto [min, max] = std::ranges::minmax_element(snippet.samples);
+		ESP_LOGW(
+			TAG,
+			"limit violation %" PRIu32 " at %.6lf s, %.4lf to %.4lf V around it",
+			snippet.violation + 1,
+			snippet.time_us / 1e6,
+			*min * lsb,
+			*max * lsb
+		);
+	}
+}
+
+// Counts of every trigger type are logged with each capture, since all of them are evaluated regardless of the selected one
+void Main::logTrigger()
+{
+	static constexpr const char* TYPE_NAMES[] = { "edge", "width", "runt", "glitch", "dropout" };
+	static_assert(std::size(TYPE_NAMES) == Trigger::TypeCount);
+	
+	auto type = GetTriggerType(m_trigger_mode.getSelectedOption());
+	ESP_LOGI(
+		TAG,
+		"%s trigger %" PRIu32 " at %.6lf s",
+		TYPE_NAMES[type],
+		m_trigger.getCount(type),
+		m_trigger.getLastTime(type) / 1e6
+	);
+	
+	for (uint8_t other = 0; other < Trigger::TypeCount; other++)
+		if (other != type && m_trigger.getCount(static_cast<Trigger::Type>(other)))
+			ESP_LOGI(
+				TAG,
+				"  %s: %" PRIu32 ", last at %.6lf s",
+				TYPE_NAMES[other],
+				m_trigger.getCount(static_cast<Trigger::Type>(other)),
+				m_trigger.getLastTime(static_cast<Trigger::Type>(other)) / 1e6
+			);
+}
+
+//======================================== Measurement
+
+void Main::acquisitionLoop()
+{
+	ESP_LOGI(
+		TAG,
+		"acquisition loop is running on CPU%d",
+		static_cast<int>(xTaskGetCoreID(xTaskGetCurrentTaskHandle()))
+	);
+	
 	auto start_time = esp_timer_get_time();
 	auto last_sample_time = start_time;
+	uint32_t iteration = 0;
+	
+	std::tuple<SignalSource, int> decimator_config {};
+	
+	std::tuple<SignalGenerator::Waveform, int, double, double, int, int, int> generator_config {};
+	
+	// Block being filled, handed over once full or once its oldest sample has waited long enough
+	SampleBlock* block = nullptr;
+	
+	// Sample periods lost to stalls, flash access of the data logger mostly, or to dropped samples, since the last one stored
+	uint32_t missed = 0;
 	
 	while (true)
 	{
 		auto sample_period_us = 1'000'000 / m_sample_rate_hz.getValue();
 		auto time_since_last_sample = esp_timer_get_time() - last_sample_time;
-
-		if (time_since_last_sample > sample_period_us)
-			xQueueSend(m_queue, &time_since_last_sample, 0);
 		
-		else
+		bool late = time_since_last_sample > sample_period_us;
+		if (!late)
 			ets_delay_us(sample_period_us - time_since_last_sample);
 		
+		else
+			missed += time_since_last_sample / sample_period_us - 1;
+		
 		last_sample_time = esp_timer_get_time();
+		m_performance.addSample(late);
+		
+		// Sample time is reused for clock sync, often enough to have some in the trace buffer even at the highest rate
+		if (iteration++ % 64 == 0)
+			Trace::Record(Trace::Sync, Trace::Clock, last_sample_time);
+		
+		if (late)
+			TRACE_INSTANT(LateSample, time_since_last_sample);
+		
+		Performance::Scope sample_scope(m_performance, Performance::SampleRead);
+		TRACE_SCOPE(Sample);
+		
+		auto signal_source = m_signal_source.getSelectedOption();
+		auto source_b = m_source_b.getSelectedOption();
+		bool channel_b = m_xy_mode || MathChannel::UsesB(m_math_operation.getSelectedOption());
 		
+		// Channel B sine is a quarter period ahead, so that the two of them draw a circle in XY mode
 		if (
-			size_t sample_count = (m_sample_rate_hz.getValue() * m_window_size_ms.getValue()) / 1000;
-			m_samples.size() != sample_count
+			decltype(generator_config) config(
+				m_generator_waveform.getSelectedOption(),
+				m_generator_frequency,
+				m_generator_amplitude,
+				m_generator_offset,
+				m_generator_duty,
+				m_generator_glitches,
+				m_sample_rate_hz.getValue()
+			);
+			config != generator_config
 		)
-			resizeBuffer(sample_count);
+		{
+			auto lsb = GetSampleLSB(SignalSource::Generator);
+			
+			SignalGenerator::Config generator = {};
+			generator.waveform = m_generator_waveform.getSelectedOption();
+			generator.frequency_hz = m_generator_frequency;
+			generator.sample_rate_hz = m_sample_rate_hz.getValue();
+			generator.amplitude = GetSampleCode(m_generator_amplitude, lsb);
+			generator.offset = GetSampleCode(m_generator_offset, lsb);
+			generator.duty_percent = m_generator_duty;
+			generator.glitch_interval = static_cast<int64_t>(m_generator_glitches) * m_sample_rate_hz.getValue() / 1000;
+			m_generator.setup(generator);
+			
+			generator.phase = 1u << 30;
+			m_generator_b.setup(generator);
+			
+			generator_config = config;
+		}
 		
-		auto& current_sample = m_samples[m_current_sample];
-		switch (m_signal_source.getSelectedOption())
+		// Oversampled reads take three quarters of the sample period, leaving the rest to the loop
+		if (
+			decltype(decimator_config) config(signal_source, m_sample_rate_hz.getValue());
+			config != decimator_config
+		)
+		{
+			m_decimator.setup(750'000'000 / m_sample_rate_hz.getValue() / m_internal_adc_read_ns);
+			decimator_config = config;
+			
+			if (signal_source == SignalSource::OversampledADC)
+				ESP_LOGI(
+					TAG,
+					"oversampling x%" PRIu32 ", %.1lf effective bits at most",
+					m_decimator.getDecimation(),
+					12 + std::log2(m_decimator.getDecimation()) / 2
+				);
+		}
+		
+		// Blocks only run out when processing falls behind, samples are dropped then rather than delayed
+		if (!block)
+		{
+			block = m_free_blocks.pop();
+			if (!block)
+			{
+				m_performance.addDroppedSample();
+				missed++;
+				continue;
+			}
+			
+			block->count = 0;
+		}
+		
+		// Conversion starts right away, which is what the cycle count stands for
+		size_t index = block->count++;
+		block->cycles[index] = Performance::GetCycleCount();
+		block->times[index] = last_sample_time;
+		block->samples[index] = readSample(signal_source, m_generator);
+		block->samples_b[index] = channel_b? readSample(source_b, m_generator_b): 0;
+		block->missed[index] = std::min<uint32_t>(missed, std::numeric_limits<uint16_t>::max());
+		missed = 0;
+		
+		if (block->count == SAMPLE_BLOCK_SIZE || last_sample_time - block->times[0] >= MAX_BLOCK_LATENCY_US)
+		{
+			m_filled_blocks.push(block);
+			xTaskNotifyGive(m_processing_task);
+			
+			block = nullptr;
+		}
+	}
+}
+
+void Main::processingLoop()
+{
+	ESP_LOGI(
+		TAG,
+		"processing loop is running on CPU%d",
+		static_cast<int>(xTaskGetCoreID(xTaskGetCurrentTaskHandle()))
+	);
+	
+	auto last_notification_time = esp_timer_get_time();
+	size_t samples_since_notification = 0;
+	
+	// Requested sample count, the buffers may be shorter if they do not fit
+	std::tuple<size_t, bool, bool> buffer_config {};
+	
+	std::tuple<MathChannel::Operation, SignalSource, SignalSource, int, size_t> math_config {};
+	size_t math_pending = 0;
+	
+	// Mask is learned from and checked against the samples following the trigger, a buffer length at most
+	std::tuple<LimitMode, SignalSource, double, double, double, size_t> limit_config {};
+	size_t limit_learning = 0;
+	size_t trigger_offset = 0;
+	
+	// Trigger is armed once half a buffer precedes it, the capture is held once another half follows it
+	std::tuple<TriggerMode, SignalSource, bool, double, double, int, int, int, int, size_t> trigger_config {};
+	size_t trigger_arming = 0;
+	size_t trigger_remaining = 0;
+	
+	std::tuple<bool, SignalSource, bool, double, double, int> ets_config {};
+	
+	std::tuple<bool, SignalSource, double, double, uint32_t> histogram_config {};
+	
+	// Single acquisition being run, it stores a buffer worth of samples, or a capture when triggered
+	uint32_t single_request = 0;
+	size_t single_remaining = 0;
+	
+	uint32_t block_count = 0;
+	
+	while (true)
+	{
+		auto* block = m_filled_blocks.pop();
+		if (!block)
+		{
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			continue;
+		}
+		
+		// Cycle counts of this core are paired with the time every now and then, in case it is not the render one
+		if (block_count++ % 64 == 0)
+			TRACE_SYNC();
+		
+		Performance::Scope process_scope(m_performance, Performance::Processing);
+		TRACE_SCOPE(Process, block->count);
+		
+		auto signal_source = m_signal_source.getSelectedOption();
+		auto source_b = m_source_b.getSelectedOption();
+		auto math_operation = m_math_operation.getSelectedOption();
+		
+		bool math = math_operation != MathChannel::Operation::Off;
+		bool channel_b = m_xy_mode || MathChannel::UsesB(math_operation);
+		
+		if (
+			decltype(buffer_config) config((m_sample_rate_hz.getValue() * m_window_size_ms.getValue()) / 1000, channel_b, math);
+			config != buffer_config
+		)
+		{
+			// Not storing meanwhile, which is also what a render loop waiting for the buffers to be let go of looks for
+			m_acquiring.store(false, std::memory_order_release);
+			
+			m_resize_state.store(ResizeState::Requested, std::memory_order_release);
+			xTaskNotify(m_render_task, Resize, eSetBits);
+			
+			// Acquisition loop notifies as well, blocks coming in meanwhile are left in the queue
+			while (m_resize_state.load(std::memory_order_acquire) != ResizeState::Released)
+				ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			
+			resizeBuffer(std::get<0>(config), channel_b, math);
+			
+			m_resize_state.store(ResizeState::Idle, std::memory_order_release);
+			xTaskNotify(m_render_task, Resize, eSetBits);
+			
+			buffer_config = config;
+			math_pending = 0;
+		}
+		
+		// Math scale depends on both sources, the rate and the window, running state starts over whenever they change
+		if (
+			decltype(math_config) config(math_operation, signal_source, source_b, m_sample_rate_hz.getValue(), m_samples.size());
+			config != math_config
+		)
+		{
+			m_math.setup(math_operation, GetSampleLSB(signal_source), GetSampleLSB(source_b), m_sample_rate_hz.getValue(), m_samples.size());
+			math_config = config;
+			math_pending = 0;
+		}
+		
+		// Equivalent-time sampling triggers on its own, the buffer keeps running free meanwhile
+		bool ets = m_equivalent_time;
+		auto trigger_mode = ets? TriggerMode::Off: m_trigger_mode.getSelectedOption();
+		if (
+			decltype(ets_config) config(ets, signal_source, m_trigger_rising, m_trigger_low, m_trigger_high, m_ets_window);
+			config != ets_config
+		)
 		{
-			case SignalSource::BusVoltage:
-				current_sample = m_adc.readBusVoltage();
-				break;
+			auto lsb = GetSampleLSB(signal_source);
+			
+			EquivalentTime::Config equivalent_time = {};
+			equivalent_time.low = GetSampleCode(m_trigger_low, lsb);
+			equivalent_time.high = GetSampleCode(m_trigger_high, lsb);
+			equivalent_time.rising = m_trigger_rising;
+			equivalent_time.window = static_cast<uint32_t>(m_ets_window) * CYCLES_PER_US;
+			
+			m_ets.setup(equivalent_time);
+			ets_config = config;
+		}
+		
+		bool histogram = m_histogram;
+		if (
+			decltype(histogram_config) config(
+				histogram,
+				signal_source,
+				m_histogram_low,
+				m_histogram_high,
+				m_histogram_length.getSelectedOption()
+			);
+			config != histogram_config
+		)
+		{
+			auto lsb = GetSampleLSB(signal_source);
+			auto [low, high] = std::minmax({ m_histogram_low.getValue(), m_histogram_high.getValue() });
+			
+			Histogram::Config amplitudes = {};
+			amplitudes.low = GetSampleCode(low, lsb);
+			amplitudes.high = GetSampleCode(high, lsb);
+			amplitudes.length = m_histogram_length.getSelectedOption();
+			
+			m_amplitude_histogram.setup(amplitudes);
+			histogram_config = config;
+		}
+		
+		if (
+			decltype(trigger_config) config(
+				trigger_mode,
+				signal_source,
+				m_trigger_rising,
+				m_trigger_low,
+				m_trigger_high,
+				m_trigger_width,
+				m_trigger_width_max,
+				m_trigger_timeout,
+				m_sample_rate_hz.getValue(),
+				m_samples.size()
+			);
+			config != trigger_config
+		)
+		{
+			auto lsb = GetSampleLSB(signal_source);
+			auto rate = m_sample_rate_hz.getValue();
+			
+			Trigger::Config trigger = {};
+			trigger.low = GetSampleCode(m_trigger_low, lsb);
+			trigger.high = GetSampleCode(m_trigger_high, lsb);
+			trigger.rising = m_trigger_rising;
+			trigger.width = static_cast<int64_t>(m_trigger_width) * rate / 1'000'000;
+			trigger.width_max = static_cast<int64_t>(m_trigger_width_max) * rate / 1'000'000;
+			trigger.timeout = static_cast<int64_t>(m_trigger_timeout) * rate / 1'000;
+			
+			switch (trigger_mode)
+			{
+				case TriggerMode::WidthGreater:
+					trigger.condition = Trigger::Condition::Greater;
+					break;
 				
-			case SignalSource::ShuntVoltage:
-				current_sample = m_adc.readShuntVoltage();
-				break;
+				case TriggerMode::WidthWithin:
+					trigger.condition = Trigger::Condition::Within;
+					break;
 				
-			case SignalSource::InternalADC:
-				current_sample = readInternalAdcVoltage();
-				break;
+				default:
+					trigger.condition = Trigger::Condition::Less;
+					break;
+			
+			}
+			
+			m_trigger.setup(trigger);
+			m_capture_held.store(false, std::memory_order_release);
+			
+			trigger_config = config;
+			trigger_arming = m_samples.size() / 2;
+			trigger_remaining = 0;
+			
+			// Offsets from the previous trigger mean nothing to the new one
+			limit_config = {};
+		}
+		
+		// Limits only change between checks; mask is learned anew from the samples following the next triggers
+		auto limit_mode = m_limit_mode.getSelectedOption();
+		if (
+			decltype(limit_config) config(limit_mode, signal_source, m_limit_low, m_limit_high, m_mask_margin, m_samples.size());
+			config != limit_config
+		)
+		{
+			auto lsb = GetSampleLSB(signal_source);
+			m_limit_test.setBand(GetSampleCode(m_limit_low, lsb), GetSampleCode(m_limit_high, lsb));
 			
-			case SignalSource::TestSine:
-				current_sample = .1 * sin(50 * 2.0 * std::numbers::pi * static_cast<double>(esp_timer_get_time() - start_time) / 1'000'000);
-				break;
+			if (limit_mode == LimitMode::Mask)
+				m_limit_test.startMask(m_samples.size());
+			
+			limit_config = config;
+			limit_learning = limit_mode == LimitMode::Mask? m_samples.size(): 0;
+			trigger_offset = m_samples.size();
+		}
+		
+		for (size_t i = 0; i < block->count; i++)
+		{
+			Sample current_sample = block->samples[i];
+			auto sample_time = block->times[i];
+			
+			if (ets)
+				m_ets.add(current_sample, block->cycles[i]);
+			
+			uint32_t fired = trigger_mode != TriggerMode::Off? m_trigger.process(current_sample, sample_time): 0;
+			
+			// Counts up to the buffer length, which it stays at until the next trigger, or until the first one
+			if (fired >> GetTriggerType(trigger_mode) & 1)
+				trigger_offset = 0;
+			
+			else if (trigger_offset < m_samples.size())
+				trigger_offset++;
+			
+			if (m_logging)
+				m_logger.addSample(current_sample, block->missed[i], static_cast<uint8_t>(signal_source), GetSampleLSB(signal_source), sample_time);
+			
+			// Stopped, samples keep being checked, but the buffers are left as they are to be read out
+			auto run_mode = m_run_mode.load(std::memory_order_relaxed);
+			auto request = m_single_request.load(std::memory_order_relaxed);
+			bool single = run_mode == RunMode::Single && request != m_single_done.load(std::memory_order_relaxed);
+			bool stopped = run_mode != RunMode::Run && !single;
+			
+			m_acquiring.store(!stopped, std::memory_order_release);
+			bool held = m_capture_held.load(std::memory_order_acquire);
+			
+			// Mask is learned only from samples being stored, so that it matches the captures shown
+			if (limit_mode == LimitMode::Band)
+				m_limit_test.check(current_sample, 0, sample_time);
+			
+			else if (limit_mode == LimitMode::Mask && trigger_offset < m_samples.size())
+			{
+				if (!limit_learning)
+					m_limit_test.check(current_sample, trigger_offset, sample_time);
 				
+				else if (!stopped && !held)
+				{
+					m_limit_test.learn(current_sample, trigger_offset);
+					if (!--limit_learning)
+						m_limit_test.finishMask(GetSampleCode(m_mask_margin, GetSampleLSB(signal_source)));
+				}
+			}
+			
+			if (stopped)
+				continue;
+			
+			// Counted whether the capture is held or not, stopping freezes it along with the buffers
+			if (histogram)
+				m_amplitude_histogram.add(current_sample);
+			
+			// Pre-trigger half has to be acquired anew as well
+			if (single && request != single_request)
+			{
+				single_request = request;
+				single_remaining = m_samples.size();
+				trigger_arming = m_samples.size() / 2;
+				trigger_remaining = 0;
+			}
+			
+			// Samples keep being checked while a capture is held, but not stored
+			if (held)
+				continue;
+			
+			m_samples[m_current_sample] = current_sample;
+			
+			if (channel_b)
+				m_samples_b[m_current_sample] = block->samples_b[i];
+			
+			(++m_current_sample) %= m_samples.size();
+			
+			// Free running, the render loop is woken once there is a plot column worth of new samples, but not more often than it draws;
+			// triggered, only once the capture is complete
+			bool notify = false;
+			if (trigger_mode == TriggerMode::Off)
+				notify =
+					++samples_since_notification >= m_samples.size() / m_display.getSize().x &&
+					sample_time - last_notification_time >= 1'000'000 / m_frame_rate.getValue();
+			
+			else if (trigger_remaining)
+				notify = !--trigger_remaining;
+			
+			else if (trigger_arming)
+				trigger_arming--;
+			
+			else if (fired >> GetTriggerType(trigger_mode) & 1)
+				trigger_remaining = std::max<size_t>(m_samples.size() / 2, 1);
+			
+			if (math && (++math_pending >= std::min(MATH_BLOCK_SIZE, m_samples.size()) || notify))
+			{
+				processMath(math_pending);
+				math_pending = 0;
+			}
+			
+			if (notify && trigger_mode != TriggerMode::Off)
+			{
+				holdCapture();
+				trigger_arming = m_samples.size() / 2;
+			}
+			
+			if (single && (trigger_mode == TriggerMode::Off? !--single_remaining: notify))
+			{
+				if (math && math_pending)
+				{
+					processMath(math_pending);
+					math_pending = 0;
+				}
+				
+				m_acquiring.store(false, std::memory_order_release);
+				m_single_done.store(request, std::memory_order_release);
+				notify = true;
+			}
+			
+			if (notify)
+			{
+				xTaskNotify(m_render_task, NewData, eSetBits);
+				
+				last_notification_time = sample_time;
+				samples_since_notification = 0;
+			}
+		}
+		
+		m_performance.addProcessedSamples(block->count);
+		m_free_blocks.push(block);
+	}
+}
+
+Sample Main::readSample(SignalSource source, SignalGenerator& generator)
+{
+	switch (source)
+	{
+		case SignalSource::BusVoltage:
+		{
+			Performance::Scope i2c_scope(m_performance, Performance::I2CTransfer);
+			return m_adc.readBusVoltageRaw();
 		}
 		
-		(++m_current_sample) %= m_samples.size();
+		case SignalSource::ShuntVoltage:
+		{
+			Performance::Scope i2c_scope(m_performance, Performance::I2CTransfer);
+			return m_adc.readShuntVoltageRaw();
+		}
+		
+		case SignalSource::InternalADC:
+			return readInternalAdcMillivolts();
+		
+		case SignalSource::OversampledADC:
+			return readOversampledAdc();
+		
+		case SignalSource::Generator:
+			return generator.next();
+	
 	}
+	
+	return 0;
 }
 
-float Main::readInternalAdcVoltage()
+int Main::readInternalAdcMillivolts()
 {
 	int raw_voltage = 0;
 	ESP_ERROR_CHECK(adc_oneshot_read(m_internal_adc_handle, INTERNAL_ADC_CHANNEL, &raw_voltage));
@@ -438,42 +2066,438 @@ float Main::readInternalAdcVoltage()
 	int voltage_mv = 0;
 	ESP_ERROR_CHECK(adc_cali_raw_to_voltage(m_internal_adc_cali_handle, raw_voltage, &voltage_mv));
 	
-	return static_cast<float>(voltage_mv) / 1000.f;
+	return voltage_mv;
+}
+
+// Reads take most of the sample period, the sample is the average of them in 16ths of a millivolt
+Sample Main::readOversampledAdc()
+{
+	int raw = 0;
+	do
+		ESP_ERROR_CHECK(adc_oneshot_read(m_internal_adc_handle, INTERNAL_ADC_CHANNEL, &raw));
+	while (!m_decimator.add(raw));
+	
+	int64_t code = m_decimator.getOutput();
+	return m_internal_adc_offset_mv * 16 + (code * m_internal_adc_slope >> (CicDecimator::s_fraction_bits + 16 - 4));
 }
 
-void Main::resizeBuffer(size_t new_size)
+// Buffers share the arena evenly, so that any window fits with a single buffer, shorter ones with more of them
+void Main::resizeBuffer(size_t new_size, bool channel_b, bool math)
 {
-	if (m_samples.data())
-		delete[] m_samples.data();
+	size_t max_size = m_sample_arena.getCapacity() / sizeof(Sample) / (1 + channel_b + math);
+	if (new_size > max_size)
+	{
+		ESP_LOGW(TAG, "window of %zu samples does not fit, shortened to %zu", new_size, max_size);
+		new_size = max_size;
+	}
+	
+	m_sample_arena.reset();
+	
+	m_samples = m_sample_arena.allocate<Sample>(new_size);
+	m_samples_b = channel_b? m_sample_arena.allocate<Sample>(new_size): std::span<Sample>();
+	m_samples_math = math? m_sample_arena.allocate<Sample>(new_size): std::span<Sample>();
+	
+	// Zeroed, so that the part not computed yet is flat
+	std::ranges::fill(m_samples_math, 0);
 	
-	m_samples = std::span(new INA226::MeasurementType[new_size], new_size);
 	m_current_sample = 0;
 }
 
+// Buffers are rotated to start from the oldest sample, which puts the trigger in the middle
+void Main::holdCapture()
+{
+	for (auto* buffer: { &m_samples, &m_samples_b, &m_samples_math })
+		if (m_current_sample < buffer->size())
+			std::rotate(buffer->begin(), buffer->begin() + m_current_sample, buffer->end());
+	
+	m_current_sample = 0;
+	m_capture_held.store(true, std::memory_order_release);
+}
+
+// Pending samples end right before the current one and may wrap around the ring, where the integral starts over
+void Main::processMath(size_t count)
+{
+	const size_t size = m_samples.size();
+	
+	size_t begin = (m_current_sample + size - count) % size;
+	while (count)
+	{
+		size_t length = std::min(count, size - begin);
+		
+		if (!begin)
+			m_math.startSweep();
+		
+		m_math.process(
+			m_samples.subspan(begin, length),
+			m_samples_b.empty()? std::span<const Sample>(): m_samples_b.subspan(begin, length),
+			m_samples_math.subspan(begin, length)
+		);
+		
+		begin = (begin + length) % size;
+		count -= length;
+	}
+}
+
+constexpr INA226::MeasurementType Main::GetSampleLSB(SignalSource source)
+{
+	switch (source)
+	{
+		case SignalSource::BusVoltage:
+			return INA226::BusVoltageLSB;
+		
+		case SignalSource::ShuntVoltage:
+			return INA226::ShuntVoltageLSB;
+		
+		case SignalSource::InternalADC:
+			return .001;
+		
+		case SignalSource::Generator:
+			return .0001;
+		
+		case SignalSource::OversampledADC:
+			return .001 / 16;
+	
+	}
+	
+	return 1;
+}
+
+// Clamped to the sample range
+Sample Main::GetSampleCode(double voltage, double lsb)
+{
+	return std::clamp<double>(voltage / lsb, std::numeric_limits<Sample>::min(), std::numeric_limits<Sample>::max());
+}
+
+constexpr Trigger::Type Main::GetTriggerType(TriggerMode mode)
+{
+	switch (mode)
+	{
+		case TriggerMode::WidthLess:
+		case TriggerMode::WidthGreater:
+		case TriggerMode::WidthWithin:
+			return Trigger::Width;
+		
+		case TriggerMode::Runt:
+			return Trigger::Runt;
+		
+		case TriggerMode::Glitch:
+			return Trigger::Glitch;
+		
+		case TriggerMode::Dropout:
+			return Trigger::Dropout;
+		
+		default:
+			return Trigger::Edge;
+	
+	}
+}
+
+// Rounded up, so that waits never end before the time has passed
+TickType_t Main::GetTicks(int64_t time_us)
+{
+	return (time_us * configTICK_RATE_HZ + 999'999) / 1'000'000;
+}
+
+//======================================== Remote control
+
+// Commands are only read here, the render loop executes them and writes the responses, while this waits
+void Main::commandLoop()
+{
+	while (true)
+	{
+		m_pending_command = m_commands.readCommand();
+		
+		xTaskNotify(m_render_task, Request, eSetBits);
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
+
+// Returns whether anything shown has changed
+bool Main::executeCommand(const CommandInterface::Command& command)
+{
+	using Verb = CommandInterface::Verb;
+	
+	char value[32] = "";
+	
+	switch (command.verb)
+	{
+		case Verb::Id:
+			m_commands.write("OK ESP32 oscilloscope\n");
+			return false;
+		
+		case Verb::List:
+			m_selector.forEachItem(
+				[&](const auto& item)
+				{
+					m_commands.write(item.getLabel());
+					m_commands.write("=");
+					m_commands.write(std::string_view(value, item.serializeValue(value, std::size(value))));
+					m_commands.write("\n");
+				}
+			);
+			
+			m_commands.write("OK\n");
+			return false;
+		
+		case Verb::Get:
+		{
+			bool found = false;
+			m_selector.forEachItem(
+				[&](const auto& item)
+				{
+					if (found || item.getLabel() != command.label)
+						return;
+					
+					found = true;
+					m_commands.write("OK ");
+					m_commands.write(std::string_view(value, item.serializeValue(value, std::size(value))));
+					m_commands.write("\n");
+				}
+			);
+			
+			if (!found)
+				m_commands.write("ERR unknown setting\n");
+			
+			return false;
+		}
+		
+		case Verb::Set:
+			if (!m_selector.setItemValue(command.label, command.value))
+			{
+				m_commands.write("ERR unknown setting or invalid value\n");
+				return false;
+			}
+			
+			m_commands.write("OK\n");
+			return true;
+		
+		case Verb::Run:
+			m_run_mode.store(RunMode::Run, std::memory_order_relaxed);
+			m_commands.write("OK\n");
+			return true;
+		
+		case Verb::Stop:
+			m_run_mode.store(RunMode::Stop, std::memory_order_relaxed);
+			m_commands.write("OK\n");
+			return false;
+		
+		case Verb::Single:
+			m_single_request.store(m_single_request.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			m_run_mode.store(RunMode::Single, std::memory_order_relaxed);
+			m_commands.write("OK\n");
+			return false;
+		
+		case Verb::Status:
+			switch (m_run_mode.load(std::memory_order_relaxed))
+			{
+				case RunMode::Run:
+					m_commands.write("OK RUN\n");
+					break;
+				
+				case RunMode::Single:
+					if (m_single_done.load(std::memory_order_acquire) != m_single_request.load(std::memory_order_relaxed))
+					{
+						m_commands.write("OK ARMED\n");
+						break;
+					}
+					
+					[[fallthrough]];
+				
+				default:
+					m_commands.write("OK STOP\n");
+					break;
+			
+			}
+			
+			return false;
+		
+		case Verb::Data:
+			sendSamples();
+			return false;
+		
+		case Verb::Log:
+			sendRecords(command.label, command.value);
+			return false;
+		
+		default:
+			m_commands.write("ERR unknown command\n");
+			return false;
+	
+	}
+}
+
+// Signal source buffer, oldest sample first, compressed; the knob is not read meanwhile, so nothing can resize it
+void Main::sendSamples()
+{
+	auto run_mode = m_run_mode.load(std::memory_order_relaxed);
+	bool single_done = m_single_done.load(std::memory_order_acquire) == m_single_request.load(std::memory_order_relaxed);
+	
+	if (run_mode == RunMode::Run || (run_mode == RunMode::Single && !single_done))
+	{
+		m_commands.write("ERR not stopped\n");
+		return;
+	}
+	
+	// Stopped by the last request, the processing loop lets go of the buffers within a block
+	while (m_acquiring.load(std::memory_order_acquire))
+		vTaskDelay(1);
+	
+	char header[64];
+	m_commands.write(
+		std::string_view(
+			header,
+			snprintf(
+				header,
+				std::size(header),
+				"BLOCK %zu %.9g %d\n",
+				m_samples.size(),
+				GetSampleLSB(m_signal_source.getSelectedOption()),
+				m_sample_rate_hz.getValue()
+			)
+		)
+	);
+	
+	// Buffer wraps around, so it is compressed a codec block at a time from either part
+	std::array<uint8_t, SampleCodec::GetMaxEncodedSize(SampleCodec::BlockSize)> encoded;
+	for (auto part: { m_samples.subspan(m_current_sample), m_samples.first(m_current_sample) })
+	{
+		for (size_t begin = 0; begin < part.size(); begin += SampleCodec::BlockSize)
+		{
+			size_t size = 0;
+			SampleCodec::Encode(part.subspan(begin, std::min(SampleCodec::BlockSize, part.size() - begin)), encoded, &size);
+			m_commands.write(std::span(encoded).first(size));
+		}
+	}
+	
+	m_commands.write("OK\n");
+}
+
+// Logged records of a tier from the given log time on, read a few at a time while the writer keeps going
+void Main::sendRecords(std::string_view tier_name, std::string_view from)
+{
+	constexpr std::pair<std::string_view, DataLogger::Tier> TIERS[] = {
+		{ "SECONDS", DataLogger::Seconds },
+		{ "MINUTES", DataLogger::Minutes },
+		{ "HOURS",   DataLogger::Hours   }
+	};
+	
+	auto tier = std::ranges::find_if(TIERS, [&](const auto& entry) { return CommandInterface::EqualsIgnoreCase(entry.first, tier_name); });
+	if (tier == std::end(TIERS))
+	{
+		m_commands.write("ERR unknown tier\n");
+		return;
+	}
+	
+	uint32_t timestamp = 0;
+	if (!from.empty() && std::from_chars(from.data(), from.data() + from.size(), timestamp).ptr != from.data() + from.size())
+	{
+		m_commands.write("ERR invalid time\n");
+		return;
+	}
+	
+	// Records closed early by a channel change share their timestamp, so pages continue from the sequence number
+	std::array<DataLogger::Record, 16> records;
+	uint32_t sequence = 0;
+	while (true)
+	{
+		size_t count = m_logger.read(tier->second, timestamp, sequence, records);
+		for (const auto& record: std::span(records).first(count))
+		{
+			// Records keep the units of the source, shunt voltage is the one in millivolts
+			float scale = static_cast<SignalSource>(record.channel) == SignalSource::ShuntVoltage? .001f: 1;
+			
+			char line[96];
+			m_commands.write(
+				std::string_view(
+					line,
+					snprintf(
+						line,
+						std::size(line),
+						"%" PRIu32 " %u %" PRIu32 " %.6g %.6g %.6g %u\n",
+						record.timestamp,
+						static_cast<unsigned>(record.channel),
+						record.count,
+						record.min * scale,
+						record.avg * scale,
+						record.max * scale,
+						static_cast<unsigned>(record.missed)
+					)
+				)
+			);
+		}
+		
+		if (count < records.size())
+			break;
+		
+		timestamp = records.back().timestamp;
+		sequence = records.back().sequence + 1;
+	}
+	
+	m_commands.write("OK\n");
+}
+
 //========================================
 
 void Main::run()
 {
+	m_render_task = xTaskGetCurrentTaskHandle();
+	
+	// Settings are restored first, so everything starts up in the last configuration
+	initSettings();
 	initDisplay();
 	initADC();
 	initInternalAdc();
 	initKnob();
-
-	// Running measurement loop on CPU1
-	TaskHandle_t task_handle = nullptr;
+	initLogger();
+	initCommands();
+	
+	for (auto& block: m_blocks)
+		m_free_blocks.push(&block);
+	
+	// Processing goes first, so that it is there to be woken by the first block
+	xTaskCreatePinnedToCore(
+		[](void* arg)
+		{
+			reinterpret_cast<Main*>(arg)->processingLoop();
+		},
+		"Processing loop",
+		4096,
+		this,
+		configMAX_PRIORITIES - 2,
+		&m_processing_task,
+		CONFIG_PIPELINE_PROCESSING_CORE
+	);
+	
 	xTaskCreatePinnedToCore(
 		[](void* arg)
 		{
-			reinterpret_cast<Main*>(arg)->measurementLoop();
+			reinterpret_cast<Main*>(arg)->acquisitionLoop();
 		},
-		"Measurement loop",
+		"Acquisition loop",
 		4096,
 		this,
 		configMAX_PRIORITIES - 1,
-		&task_handle,
-		1 // CPU1
+		nullptr,
+		CONFIG_PIPELINE_ACQUISITION_CORE
 	);
 	
+	// Command task mostly waits for the port, next to the render loop on CPU0
+	xTaskCreatePinnedToCore(
+		[](void* arg)
+		{
+			reinterpret_cast<Main*>(arg)->commandLoop();
+		},
+		"Command loop",
+		4096,
+		this,
+		uxTaskPriorityGet(nullptr),
+		&m_command_task,
+		0 // CPU0
+	);
+	
+	// Everything is set up, running should not touch the heap from here on
+	HeapGuard::Seal();
+	
 	renderLoop();
 }
 
@@ -481,7 +2505,8 @@ void Main::run()
 
 extern "C" void app_main()
 {
-	Main instance;
+	// Lives in static storage along with the whole menu
+	static Main instance;
 	instance.run();
 }
 
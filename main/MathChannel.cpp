@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <bit>
+
+#include <MathChannel.hpp>
+
+//========================================
+
+void MathChannel::setup(Operation operation, double lsb_a, double lsb_b, int sample_rate_hz, size_t window_size)
+{
+	m_operation = operation;
+	m_accumulator = 0;
+	m_previous_valid = false;
+	
+	switch (operation)
+	{
+		case Operation::Off:
+			m_lsb = lsb_a;
+			break;
+		
+		case Operation::Difference:
+			m_lsb = std::max(lsb_a, lsb_b);
+			m_scale_a = std::lround(lsb_a / m_lsb * (1 << s_fraction_bits));
+			m_scale_b = std::lround(lsb_b / m_lsb * (1 << s_fraction_bits));
+			break;
+		
+		case Operation::Product:
+			m_lsb = lsb_a * lsb_b * (1 << s_product_shift);
+			break;
+		
+		// Sum of a window of full scale samples is brought down to the sample range
+		case Operation::Integral:
+		{
+			uint64_t max_sum = static_cast<uint64_t>(std::max<size_t>(window_size, 1)) << std::numeric_limits<Sample>::digits;
+			m_integral_shift = std::max(0, static_cast<int>(std::bit_width(max_sum - 1)) - std::numeric_limits<Sample>::digits);
+			m_lsb = lsb_a * (int64_t(1) << m_integral_shift) / sample_rate_hz;
+			break;
+		}
+		
+		case Operation::Derivative:
+			m_lsb = lsb_a * sample_rate_hz / s_derivative_gain;
+			break;
+	
+	}
+}
+
+void MathChannel::process(std::span<const Sample> a, std::span<const Sample> b, std::span<Sample> output)
+{
+	const size_t size = std::min(a.size(), output.size());
+	
+	switch (m_operation)
+	{
+		case Operation::Off:
+			std::copy_n(a.begin(), size, output.begin());
+			break;
+		
+		case Operation::Difference:
+			for (size_t i = 0; i < std::min(size, b.size()); i++)
+				output[i] = Saturate((a[i] * m_scale_a - b[i] * m_scale_b) >> s_fraction_bits);
+			
+			break;
+		
+		case Operation::Product:
+			for (size_t i = 0; i < std::min(size, b.size()); i++)
+				output[i] = Saturate((a[i] * b[i]) >> s_product_shift);
+			
+			break;
+		
+		case Operation::Integral:
+			for (size_t i = 0; i < size; i++)
+			{
+				m_accumulator += a[i];
+				output[i] = Saturate(m_accumulator >> m_integral_shift);
+			}
+			
+			break;
+		
+		case Operation::Derivative:
+			for (size_t i = 0; i < size; i++)
+			{
+				output[i] = m_previous_valid? Saturate((a[i] - m_previous) * s_derivative_gain): 0;
+				m_previous = a[i];
+				m_previous_valid = true;
+			}
+			
+			break;
+	
+	}
+}
+
+void MathChannel::startSweep()
+{
+	m_accumulator = 0;
+}
+
+MathChannel::Operation MathChannel::getOperation() const
+{
+	return m_operation;
+}
+
+double MathChannel::getLSB() const
+{
+	return m_lsb;
+}
+
+bool MathChannel::UsesB(Operation operation)
+{
+	return operation == Operation::Difference || operation == Operation::Product;
+}
+
+Sample MathChannel::Saturate(int64_t value)
+{
+	return std::clamp<int64_t>(value, std::numeric_limits<Sample>::min(), std::numeric_limits<Sample>::max());
+}
+
+//========================================
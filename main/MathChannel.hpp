@@ -0,0 +1,67 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Channel computed from acquired ones a block at a time in fixed point
+// Results are stored as samples with their own LSB, chosen once per configuration so that the ring
+// buffer holding them stays consistent; values out of the sample range saturate
+class MathChannel
+{
+public:
+	enum class Operation: uint8_t
+	{
+		Off,
+		Difference, // A - B
+		Product,    // A * B
+		Integral,   // Running integral of A over the window, starting over with every sweep
+		Derivative  // Slope of A between consecutive samples
+	};
+	
+	MathChannel() = default;
+	MathChannel(const MathChannel& copy) = delete;
+	
+	// Resets the running state; the integral LSB is chosen so that a whole window of full scale input fits
+	void setup(Operation operation, double lsb_a, double lsb_b, int sample_rate_hz, size_t window_size);
+	
+	// Integral starts over from zero, called as the buffer wraps around
+	void startSweep();
+	
+	// Consecutive samples of both channels, B is only read by the operations that need it
+	void process(std::span<const Sample> a, std::span<const Sample> b, std::span<Sample> output);
+	
+	Operation getOperation() const;
+	double getLSB() const;
+	
+	static bool UsesB(Operation operation);
+	
+private:
+	static constexpr int s_fraction_bits   = 14; // Of the difference scale factors
+	static constexpr int s_product_shift   = 15; // Product of two samples fits into one after the shift
+	static constexpr int s_derivative_gain = 16; // Derivative resolution per code and sample
+	
+	Operation m_operation = Operation::Off;
+	double    m_lsb       = 1;
+	
+	// Difference, both channels are brought to the coarser LSB
+	int32_t m_scale_a = 0;
+	int32_t m_scale_b = 0;
+	
+	// Integral
+	int64_t m_accumulator    = 0;
+	int     m_integral_shift = 0;
+	
+	// Derivative
+	Sample m_previous       = 0;
+	bool   m_previous_valid = false;
+	
+	static Sample Saturate(int64_t value);
+	
+};
+
+//========================================
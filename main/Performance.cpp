@@ -0,0 +1,237 @@
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+#include <Performance.hpp>
+#include <HeapGuard.hpp>
+#include <Render.hpp>
+
+//========================================
+
+static const char* TAG = "performance";
+
+static const char* STAGE_NAMES[Performance::StageCount] = {
+	"sample read",
+	"i2c transfer",
+	"processing",
+	"render",
+	"flush",
+	"frame"
+};
+
+// Linux target has no cycle counter, microseconds are used instead
+#ifdef CONFIG_IDF_TARGET_LINUX
+	constexpr float CYCLES_PER_US = 1;
+#else
+	constexpr float CYCLES_PER_US = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+#endif
+
+//======================================== Scope
+
+Performance::Scope::Scope(Performance& performance, Stage stage):
+	m_performance(performance),
+	m_stage(stage),
+	m_start(GetCycleCount())
+{}
+
+Performance::Scope::~Scope()
+{
+	m_performance.addStageTime(m_stage, GetCycleCount() - m_start);
+}
+
+//======================================== Counters
+
+void Performance::addStageTime(Stage stage, uint32_t cycles)
+{
+	auto& counters = m_stages[stage];
+	counters.cycles.fetch_add(cycles, std::memory_order_relaxed);
+	counters.count.fetch_add(1, std::memory_order_relaxed);
+	
+	// Reader resets the maximum, so an occasional lost update is acceptable here
+	if (cycles > counters.max_cycles.load(std::memory_order_relaxed))
+		counters.max_cycles.store(cycles, std::memory_order_relaxed);
+}
+
+void Performance::addSample(bool late)
+{
+	m_samples.fetch_add(1, std::memory_order_relaxed);
+	
+	if (late)
+		m_late_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Performance::addProcessedSamples(uint32_t count)
+{
+	m_processed_samples.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Performance::addDroppedSample()
+{
+	m_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Performance::addSkippedFrames(uint32_t count)
+{
+	m_skipped_frames.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint32_t Performance::GetCycleCount()
+{
+	#ifdef CONFIG_IDF_TARGET_LINUX
+		return esp_timer_get_time();
+	#else
+		return esp_cpu_get_cycle_count();
+	#endif
+}
+
+//======================================== Statistics
+
+bool Performance::update(int64_t time_us)
+{
+	if (time_us - m_last_update_us < s_interval_us)
+		return false;
+	
+	auto reading = read();
+	
+	// Counters wrap around, but unsigned differences stay correct as long as the interval is short enough
+	for (size_t stage = 0; stage < StageCount; stage++)
+	{
+		uint32_t cycles = reading.cycles[stage] - m_last_reading.cycles[stage];
+		uint32_t count = reading.counts[stage] - m_last_reading.counts[stage];
+		uint32_t max_cycles = m_stages[stage].max_cycles.exchange(0, std::memory_order_relaxed);
+		
+		m_statistics.stages[stage] = {
+			count? cycles / CYCLES_PER_US / count: 0.f,
+			max_cycles / CYCLES_PER_US,
+			count
+		};
+	}
+	
+	float interval_s = (time_us - m_last_update_us) / 1e6f;
+	m_statistics.sample_rate_hz = (reading.samples - m_last_reading.samples) / interval_s;
+	m_statistics.late_samples = reading.late_samples - m_last_reading.late_samples;
+	m_statistics.processed_rate_hz = (reading.processed_samples - m_last_reading.processed_samples) / interval_s;
+	m_statistics.dropped_samples = reading.dropped_samples - m_last_reading.dropped_samples;
+	m_statistics.total_late_samples = reading.late_samples;
+	m_statistics.skipped_frames = reading.skipped_frames - m_last_reading.skipped_frames;
+	
+	for (size_t core = 0; core < portNUM_PROCESSORS; core++)
+	{
+		#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+			uint32_t run_time = reading.run_time - m_last_reading.run_time;
+			uint32_t idle_time = reading.idle_time[core] - m_last_reading.idle_time[core];
+			
+			m_statistics.cpu_load[core] = run_time? 1.f - std::min<float>(static_cast<float>(idle_time) / run_time, 1.f): 0.f;
+		#else
+			m_statistics.cpu_load[core] = -1.f;
+		#endif
+	}
+	
+	m_statistics.free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+	m_statistics.min_free_heap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+	m_statistics.late_allocations = HeapGuard::GetAllocationCount();
+	
+	m_last_reading = reading;
+	m_last_update_us = time_us;
+	
+	return true;
+}
+
+const Performance::Statistics& Performance::getStatistics() const
+{
+	return m_statistics;
+}
+
+Performance::Reading Performance::read() const
+{
+	Reading reading = {};
+	for (size_t stage = 0; stage < StageCount; stage++)
+	{
+		reading.cycles[stage] = m_stages[stage].cycles.load(std::memory_order_relaxed);
+		reading.counts[stage] = m_stages[stage].count.load(std::memory_order_relaxed);
+	}
+	
+	reading.samples = m_samples.load(std::memory_order_relaxed);
+	reading.late_samples = m_late_samples.load(std::memory_order_relaxed);
+	reading.processed_samples = m_processed_samples.load(std::memory_order_relaxed);
+	reading.dropped_samples = m_dropped_samples.load(std::memory_order_relaxed);
+	reading.skipped_frames = m_skipped_frames.load(std::memory_order_relaxed);
+	
+	#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+		for (size_t core = 0; core < portNUM_PROCESSORS; core++)
+			reading.idle_time[core] = ulTaskGetIdleRunTimeCounterForCore(core);
+		
+		reading.run_time = portGET_RUN_TIME_COUNTER_VALUE();
+	#endif
+	
+	return reading;
+}
+
+//======================================== Output
+
+void Performance::log() const
+{
+	for (size_t stage = 0; stage < StageCount; stage++)
+	{
+		const auto& statistics = m_statistics.stages[stage];
+		ESP_LOGI(
+			TAG,
+			"%-12s avg %9.1f us | max %9.1f us | %6" PRIu32 "/s",
+			STAGE_NAMES[stage],
+			statistics.average_us,
+			statistics.max_us,
+			statistics.count
+		);
+	}
+	
+	ESP_LOGI(
+		TAG,
+		"sample rate %.0f Hz | late %" PRIu32 " (%" PRIu32 " total)",
+		m_statistics.sample_rate_hz,
+		m_statistics.late_samples,
+		m_statistics.total_late_samples
+	);
+	
+	ESP_LOGI(
+		TAG,
+		"processed %.0f Hz | dropped %" PRIu32,
+		m_statistics.processed_rate_hz,
+		m_statistics.dropped_samples
+	);
+	
+	ESP_LOGI(TAG, "skipped frames %" PRIu32, m_statistics.skipped_frames);
+	
+	for (size_t core = 0; core < portNUM_PROCESSORS; core++)
+		ESP_LOGI(TAG, "CPU%zu load %.0f%%", core, m_statistics.cpu_load[core] * 100);
+	
+	ESP_LOGI(TAG, "heap free %zu | min free %zu", m_statistics.free_heap, m_statistics.min_free_heap);
+	
+	if (m_statistics.late_allocations)
+		ESP_LOGW(
+			TAG,
+			"%" PRIu32 " heap allocations since startup, last one from %p",
+			m_statistics.late_allocations,
+			HeapGuard::GetLastCaller()
+		);
+}
+
+void Performance::render(Layer& layer, const Font& font) const
+{
+	const auto& frame = m_statistics.stages[Frame];
+	
+	int line = 0;
+	auto print = [&](std::string_view text)
+	{
+		Text(layer, font, Vector2i(0, line++ * font.getGlyphSize().y), text, true, true);
+	};
+	
+	// Frames are paced, so the rate is counted rather than derived from the frame time
+	print(FormatTmp("%3" PRIu32 "fps %5.1fms", frame.count, frame.average_us / 1000));
+	print(FormatTmp("%5.0fHz L%" PRIu32, m_statistics.sample_rate_hz, m_statistics.late_samples));
+	print(FormatTmp("C%3.0f%%%3.0f%% %zuk", m_statistics.cpu_load[0] * 100, m_statistics.cpu_load[portNUM_PROCESSORS - 1] * 100, m_statistics.free_heap / 1024));
+}
+
+//========================================
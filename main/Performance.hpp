@@ -0,0 +1,137 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <Layer.hpp>
+#include <Font.hpp>
+
+//========================================
+
+// Lock-free runtime counters
+// Every counter has a single writer, so updating one costs a relaxed atomic add;
+// statistics are computed by the render loop from differences between successive readings
+class Performance
+{
+public:
+	enum Stage: uint8_t
+	{
+		SampleRead,  // Whole sample acquisition, excluding the wait for the sample period
+		I2CTransfer, // INA226 register read
+		Processing,  // Block of samples through triggering, tests, math and storage
+		Render,      // Drawing the frame into the display buffer
+		Flush,       // Sending the frame to the display
+		Frame,       // Whole drawn frame, excluding the wait for the next one
+		
+		StageCount
+	};
+	
+	struct StageStatistics
+	{
+		float    average_us;
+		float    max_us;
+		uint32_t count;
+	};
+	
+	struct Statistics
+	{
+		std::array<StageStatistics, StageCount> stages;
+		
+		float    sample_rate_hz;
+		uint32_t late_samples;       // Within the last interval
+		uint32_t total_late_samples;
+		
+		float    processed_rate_hz; // Through the processing stage
+		uint32_t dropped_samples;   // Within the last interval, for lack of a free block
+		
+		uint32_t skipped_frames; // Within the last interval
+		
+		std::array<float, portNUM_PROCESSORS> cpu_load; // Negative if FreeRTOS run time stats are disabled
+		
+		size_t free_heap;
+		size_t min_free_heap; // Heap watermark since boot
+		
+		uint32_t late_allocations; // Through operator new since startup, should stay zero
+	};
+	
+	// Accounts the time until destruction to the stage
+	class Scope
+	{
+	public:
+		Scope(Performance& performance, Stage stage);
+		Scope(const Scope& copy) = delete;
+		~Scope();
+		
+	private:
+		Performance& m_performance;
+		Stage        m_stage;
+		uint32_t     m_start;
+		
+	};
+	
+	Performance() = default;
+	Performance(const Performance& copy) = delete;
+	
+	void addStageTime(Stage stage, uint32_t cycles);
+	void addSample(bool late);
+	void addProcessedSamples(uint32_t count);
+	void addDroppedSample();
+	void addSkippedFrames(uint32_t count);
+	
+	// Recomputes statistics once per interval, returns true if they were updated
+	bool update(int64_t time_us);
+	const Statistics& getStatistics() const;
+	
+	void log() const;
+	void render(Layer& layer, const Font& font) const;
+	
+	static uint32_t GetCycleCount();
+	
+private:
+	struct StageCounters
+	{
+		std::atomic<uint32_t> cycles;
+		std::atomic<uint32_t> count;
+		std::atomic<uint32_t> max_cycles;
+	};
+	
+	struct Reading
+	{
+		std::array<uint32_t, StageCount> cycles;
+		std::array<uint32_t, StageCount> counts;
+		
+		uint32_t samples;
+		uint32_t late_samples;
+		uint32_t processed_samples;
+		uint32_t dropped_samples;
+		uint32_t skipped_frames;
+		
+		std::array<uint32_t, portNUM_PROCESSORS> idle_time;
+		uint32_t run_time;
+	};
+	
+	static constexpr int64_t s_interval_us = 1'000'000;
+	
+	std::array<StageCounters, StageCount> m_stages {};
+	
+	std::atomic<uint32_t> m_samples      = 0;
+	std::atomic<uint32_t> m_late_samples = 0;
+	
+	std::atomic<uint32_t> m_processed_samples = 0;
+	std::atomic<uint32_t> m_dropped_samples   = 0;
+	
+	std::atomic<uint32_t> m_skipped_frames = 0;
+	
+	// Render loop side
+	Reading    m_last_reading     {};
+	int64_t    m_last_update_us   = 0;
+	Statistics m_statistics       {};
+	
+	Reading read() const;
+	
+};
+
+//========================================
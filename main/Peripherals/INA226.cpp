@@ -6,6 +6,7 @@
 #include <ratio>
 
 #include <Peripherals/INA226.hpp>
+#include <Trace.hpp>
 
 //========================================
 
@@ -37,12 +38,22 @@ void INA226::reset()
 
 INA226::MeasurementType INA226::readShuntVoltage()
 {
-	return static_cast<int16_t>(readRegister(Register::ShuntVoltage)) * static_cast<MeasurementType>(.0025);
+	return readShuntVoltageRaw() * ShuntVoltageLSB;
 }
 
 INA226::MeasurementType INA226::readBusVoltage()
 {
-	return static_cast<int16_t>(readRegister(Register::BusVoltage)) * static_cast<MeasurementType>(.00125);
+	return readBusVoltageRaw() * BusVoltageLSB;
+}
+
+int16_t INA226::readShuntVoltageRaw()
+{
+	return static_cast<int16_t>(readRegister(Register::ShuntVoltage));
+}
+
+int16_t INA226::readBusVoltageRaw()
+{
+	return static_cast<int16_t>(readRegister(Register::BusVoltage));
 }
 
 void INA226::setConfiguration(uint16_t flags)
@@ -79,6 +90,8 @@ uint16_t INA226::getDieID()
 
 uint16_t INA226::readRegister(Register addr)
 {
+	TRACE_SCOPE(I2CRead, addr);
+	
 	uint16_t buffer = 0;
 	ESP_ERROR_CHECK(
 		i2c_master_transmit_receive(
@@ -96,6 +109,8 @@ uint16_t INA226::readRegister(Register addr)
 
 void INA226::writeRegister(Register addr, uint16_t data)
 {
+	TRACE_SCOPE(I2CWrite, addr);
+	
 	#pragma pack(push, 1)
 	struct
 	{
@@ -9,6 +9,10 @@ class INA226
 public:
 	using MeasurementType = double;
 	
+	// Value of a single register code
+	static constexpr MeasurementType ShuntVoltageLSB = .0025;  // mV
+	static constexpr MeasurementType BusVoltageLSB   = .00125; // V
+	
 	enum ConfigurationFlags: uint16_t
 	{
 		MODE1   = 1,
@@ -110,6 +114,9 @@ public:
 	MeasurementType readShuntVoltage();
 	MeasurementType readBusVoltage();
 	
+	int16_t readShuntVoltageRaw();
+	int16_t readBusVoltageRaw();
+	
 	void     setConfiguration(uint16_t flags);
 	uint16_t getConfiguration();
 	
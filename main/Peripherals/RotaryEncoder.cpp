@@ -1,21 +1,31 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
 #include <Peripherals/RotaryEncoder.hpp>
 
 //========================================
 
 RotaryEncoder::~RotaryEncoder()
 {
-	if (m_pin_a != GPIO_NUM_NC)
-		gpio_isr_handler_remove(m_pin_a);
-	
-	if (m_pin_b != GPIO_NUM_NC)
-		gpio_isr_handler_remove(m_pin_b);
-	
 	if (m_pin_press != GPIO_NUM_NC)
 		gpio_isr_handler_remove(m_pin_press);
 	
+	if (m_pcnt_unit)
+	{
+		pcnt_unit_stop(m_pcnt_unit);
+		pcnt_unit_disable(m_pcnt_unit);
+		
+		for (auto* channel: m_pcnt_channels)
+			if (channel)
+				pcnt_del_channel(channel);
+		
+		pcnt_del_unit(m_pcnt_unit);
+	}
+	
 	if (m_event_queue)
 		vQueueDelete(m_event_queue);
 }
@@ -28,25 +38,70 @@ void RotaryEncoder::setup(
 	gpio_num_t pin_press
 )
 {
-	m_pin_a = pin_a;
-	m_pin_b = pin_b;
 	m_pin_press = pin_press;
 	
-	m_last_state.a = true;
-	m_last_state.b = true;
-	m_last_state.press = true;
-	
 	gpio_config_t config = {};
-	config.pin_bit_mask = 1 << pin_a | 1 << pin_b | 1 << pin_press;
+	config.pin_bit_mask = 1ull << pin_a | 1ull << pin_b;
 	config.mode = GPIO_MODE_INPUT;
 	config.pull_up_en = GPIO_PULLUP_ENABLE;
+	config.intr_type = GPIO_INTR_DISABLE;
+	gpio_config(&config);
+	
+	config.pin_bit_mask = 1ull << pin_press;
 	config.intr_type = GPIO_INTR_ANYEDGE;
 	gpio_config(&config);
 	
+	// Counter wraps at the limits, which are accumulated by the driver
+	pcnt_unit_config_t unit_config = {};
+	unit_config.low_limit = -s_count_limit;
+	unit_config.high_limit = s_count_limit;
+	unit_config.flags.accum_count = true;
+	ESP_ERROR_CHECK(pcnt_new_unit(&unit_config, &m_pcnt_unit));
+	
+	pcnt_glitch_filter_config_t filter_config = {};
+	filter_config.max_glitch_ns = s_max_glitch_ns;
+	ESP_ERROR_CHECK(pcnt_unit_set_glitch_filter(m_pcnt_unit, &filter_config));
+	
+	// Full quadrature decoding: every edge of one pin counts in the direction given by the level of the other one
+	const gpio_num_t channel_pins[2][2] = {
+		{ pin_a, pin_b },
+		{ pin_b, pin_a }
+	};
+	
+	for (size_t i = 0; i < std::size(m_pcnt_channels); i++)
+	{
+		pcnt_chan_config_t channel_config = {};
+		channel_config.edge_gpio_num = channel_pins[i][0];
+		channel_config.level_gpio_num = channel_pins[i][1];
+		ESP_ERROR_CHECK(pcnt_new_channel(m_pcnt_unit, &channel_config, &m_pcnt_channels[i]));
+		
+		// Clockwise is A leading B
+		ESP_ERROR_CHECK(
+			pcnt_channel_set_edge_action(
+				m_pcnt_channels[i],
+				i? PCNT_CHANNEL_EDGE_ACTION_DECREASE: PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+				i? PCNT_CHANNEL_EDGE_ACTION_INCREASE: PCNT_CHANNEL_EDGE_ACTION_DECREASE
+			)
+		);
+		
+		ESP_ERROR_CHECK(
+			pcnt_channel_set_level_action(
+				m_pcnt_channels[i],
+				PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+				PCNT_CHANNEL_LEVEL_ACTION_INVERSE
+			)
+		);
+	}
+	
+	ESP_ERROR_CHECK(pcnt_unit_add_watch_point(m_pcnt_unit, -s_count_limit));
+	ESP_ERROR_CHECK(pcnt_unit_add_watch_point(m_pcnt_unit,  s_count_limit));
+	
+	ESP_ERROR_CHECK(pcnt_unit_enable(m_pcnt_unit));
+	ESP_ERROR_CHECK(pcnt_unit_clear_count(m_pcnt_unit));
+	ESP_ERROR_CHECK(pcnt_unit_start(m_pcnt_unit));
+	
 	m_event_queue = xQueueCreate(16, sizeof(Event));
 	
-	gpio_isr_handler_add(pin_a,     InterruptHandler, this);
-	gpio_isr_handler_add(pin_b,     InterruptHandler, this);
 	gpio_isr_handler_add(pin_press, InterruptHandler, this);
 }
 
@@ -67,9 +122,18 @@ bool RotaryEncoder::isPressed() const
 	return m_press;
 }
 
+void RotaryEncoder::setNotification(TaskHandle_t task, uint32_t bits)
+{
+	m_notify_bits = bits;
+	m_notify_task = task;
+}
+
 bool RotaryEncoder::pollEvent(Event* event)
 {
-	return xQueueReceive(m_event_queue, event, 0) == pdPASS;
+	if (xQueueReceive(m_event_queue, event, 0) == pdPASS)
+		return true;
+	
+	return pollRotation(event);
 }
 
 //========================================
@@ -78,42 +142,15 @@ void RotaryEncoder::InterruptHandler(void* arg)
 {
 	auto& instance = *reinterpret_cast<RotaryEncoder*>(arg);
 	
-	State state = {};
-	state.a     = gpio_get_level(instance.m_pin_a);
-	state.b     = gpio_get_level(instance.m_pin_b);
-	state.press = gpio_get_level(instance.m_pin_press);
-	
-	if (state.ab != instance.m_last_state.ab)
-	{
-		switch (instance.m_last_state.ab << 2 | state.ab)
-		{
-			// Clockwise
-			case 0b0010:
-			case 0b0100:
-			case 0b1011:
-			case 0b1101:
-				instance.updateCounter(1);
-				break;
-				
-			// Counterclockwise
-			case 0b0001:
-			case 0b0111:
-			case 0b1000:
-			case 0b1110:
-				instance.updateCounter(-1);
-				break;
-				
-		}
-	}
-	
-	if (state.press != instance.m_last_state.press)
+	bool press = gpio_get_level(instance.m_pin_press);
+	if (press != instance.m_last_press)
 	{
 		auto current_time = esp_timer_get_time();
 		if (current_time - instance.m_last_button_event_time > 10000 /* 10ms */)
 		{
 			Event event = {};
 			event.type = Event::Button;
-			event.button = !state.press;
+			event.button = !press;
 			
 			instance.enqueueEvent(event);
 		}
@@ -121,28 +158,44 @@ void RotaryEncoder::InterruptHandler(void* arg)
 		instance.m_last_button_event_time = current_time;
 	}
 	
-	instance.m_last_state = state;
+	instance.m_last_press = press;
 }
 
 void RotaryEncoder::enqueueEvent(Event event)
 {
 	xQueueSendFromISR(m_event_queue, &event, nullptr);
+	
+	if (m_notify_task)
+		xTaskNotifyFromISR(m_notify_task, m_notify_bits, eSetBits, nullptr);
 }
 
-void RotaryEncoder::updateCounter(int8_t direction)
+bool RotaryEncoder::pollRotation(Event* event)
 {
-	constexpr int8_t rotation_period = 4;
+	int count = 0;
+	ESP_ERROR_CHECK(pcnt_unit_get_count(m_pcnt_unit, &count));
 	
-	uint8_t abs_counter = abs(m_counter += direction);
-	if (abs_counter >= rotation_period)
-	{
-		Event event = {};
-		event.type = Event::Rotation;
-		event.delta = m_counter / abs_counter;
-		
-		enqueueEvent(event);
-		m_counter = 0;
-	}
+	// Partial detents are kept for the next poll
+	int detents = (count - m_last_count) / s_counts_per_detent;
+	if (!detents)
+		return false;
+	
+	m_last_count += detents * s_counts_per_detent;
+	
+	auto current_time = esp_timer_get_time();
+	float speed = 1'000'000.f * abs(detents) / std::max<uint64_t>(current_time - m_last_rotation_time, 1);
+	m_last_rotation_time = current_time;
+	
+	event->type = Event::Rotation;
+	event->button = false;
+	event->delta = std::clamp<long>(std::lround(detents * Accelerate(speed)), INT8_MIN, INT8_MAX);
+	
+	return true;
 }
 
-//========================================
\ No newline at end of file
+float RotaryEncoder::Accelerate(float speed)
+{
+	float t = std::clamp((speed - s_acceleration_start) / (s_acceleration_end - s_acceleration_start), 0.f, 1.f);
+	return 1.f + (s_max_acceleration - 1.f) * t * t;
+}
+
+//========================================
@@ -2,13 +2,17 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
 
 #include "esp_timer.h"
 
 #include "driver/gpio.h"
+#include "driver/pulse_cnt.h"
 
 //========================================
 
+// Quadrature is decoded by the pulse counter, so knob rotation does not cause any interrupts;
+// accumulated counts are turned into rotation events with acceleration when polled
 class RotaryEncoder
 {
 public:
@@ -19,9 +23,9 @@ public:
 			Rotation,
 			Button
 		} type: 1;
-	
+		
 		bool   button: 1;
-		int8_t delta:  2;
+		int8_t delta;
 	};
 	
 	RotaryEncoder() = default;
@@ -39,29 +43,37 @@ public:
 	
 	bool isPressed() const;
 	
+	// Task notified with the bits set on button events, so that it can sleep instead of polling;
+	// rotation does not cause interrupts and is only seen when polled
+	void setNotification(TaskHandle_t task, uint32_t bits);
+	
+	// Button events come first, rotation accumulated since the last poll is returned as a single event
 	bool pollEvent(Event* event);
 	
 private:
-	union State
-	{
-		struct
-		{
-			uint8_t a:     1;
-			uint8_t b:     1;
-			uint8_t press: 1;
-		};
+	static constexpr int      s_counts_per_detent = 4;
+	static constexpr int      s_count_limit       = 10000;
+	static constexpr uint32_t s_max_glitch_ns     = 10000;
 	
-		uint8_t ab: 2;
-	};
+	// Rotation is scaled up from 1 to the maximum factor between these speeds, detents per second
+	static constexpr float s_acceleration_start = 10;
+	static constexpr float s_acceleration_end   = 40;
+	static constexpr float s_max_acceleration   = 10;
 	
-	gpio_num_t m_pin_a     = GPIO_NUM_NC;
-	gpio_num_t m_pin_b     = GPIO_NUM_NC;
 	gpio_num_t m_pin_press = GPIO_NUM_NC;
 	
-	int8_t        m_counter = 0;
-	State         m_last_state {};
+	pcnt_unit_handle_t    m_pcnt_unit = nullptr;
+	pcnt_channel_handle_t m_pcnt_channels[2] {};
+	
+	int      m_last_count         = 0;
+	uint64_t m_last_rotation_time = esp_timer_get_time();
+	
+	bool          m_last_press  = true;
 	QueueHandle_t m_event_queue = nullptr;
 	
+	TaskHandle_t m_notify_task = nullptr;
+	uint32_t     m_notify_bits = 0;
+	
 	uint64_t m_last_button_event_time = esp_timer_get_time();
 	
 	int  m_value = 0;
@@ -69,7 +81,10 @@ private:
 	
 	static void InterruptHandler(void* arg);
 	void enqueueEvent(Event event);
-	void updateCounter(int8_t direction);
+	
+	bool pollRotation(Event* event);
+	
+	static float Accelerate(float speed);
 	
 };
 
@@ -1,12 +1,17 @@
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
 #include <Peripherals/SH1106Display.hpp>
+#include <Trace.hpp>
 
 //========================================
 
 Vector2u SH1106Display::s_max_size = Vector2u(132, 64);
-size_t   SH1106Display::s_buffer_size = s_max_size.x * s_max_size.y;
+size_t   SH1106Display::s_buffer_size = s_max_size.x * s_max_size.y / 8;
+
+// Layers are composed a word at a time straight into the display buffer
+static_assert(Layer::s_columns == 132 && Layer::s_pages == 8);
 
 //========================================
 
@@ -39,7 +44,7 @@ void SH1106Display::setup(
 	
 	ESP_ERROR_CHECK(gpio_reset_pin(m_pin_dc));
 	ESP_ERROR_CHECK(gpio_set_direction(m_pin_dc, GPIO_MODE_OUTPUT));
-
+	
 	sendCommand(Command::SetCommonOutputScanDirection | 8   );
 	sendCommand(Command::SetSegmentRemap              | true);
 	sendCommand(Command::SetDisplayOn                 | true);
@@ -55,18 +60,30 @@ void SH1106Display::flush()
 	constexpr size_t pages = 8;
 	for (size_t page = 0; page < pages; page++)
 	{
+		auto* page_data = m_pixel_data + page * s_max_size.x;
+		auto* sent_data = m_sent_data.data() + page * s_max_size.x;
+		
+		if (m_sent_valid && std::equal(page_data, page_data + s_max_size.x, sent_data))
+			continue;
+		
+		TRACE_SCOPE(FlushPage, page);
+		
 		sendCommand(Command::SetPageAddress | page);
 		setColumnAddress(0);
 		
 		spi_transaction_t transaction = {};
-		transaction.tx_buffer = m_pixel_data + page * s_max_size.x;
+		transaction.tx_buffer = page_data;
 		transaction.length = s_max_size.x * 8;
 		
 		sendCommand(Command::SetReadModifyWriteStart);
 		ESP_ERROR_CHECK(gpio_set_level(m_pin_dc, true));
 		ESP_ERROR_CHECK(spi_device_transmit(m_device_handle, &transaction));
 		sendCommand(Command::SetReadModifyWriteEnd);
+		
+		std::copy(page_data, page_data + s_max_size.x, sent_data);
 	}
+	
+	m_sent_valid = true;
 }
 
 const Vector2u& SH1106Display::getSize() const
@@ -88,6 +105,104 @@ bool SH1106Display::setPixel(const Vector2i& position, bool value)
 	return true;
 }
 
+void SH1106Display::fillColumn(int x, int top, int bottom, bool value)
+{
+	top = std::max(top, 0);
+	bottom = std::min<int>(bottom, m_size.y - 1);
+	
+	if (!(0 <= x && x < m_size.x) || top > bottom)
+		return;
+	
+	auto* column = m_pixel_data + x + (s_max_size.x - m_size.x) / 2;
+	
+	top += (s_max_size.y - m_size.y) / 2;
+	bottom += (s_max_size.y - m_size.y) / 2;
+	
+	for (int page = top / 8; page <= bottom / 8; page++)
+	{
+		uint8_t mask = (0xFF << std::max(top - page * 8, 0)) & (0xFF >> (7 - std::min(bottom - page * 8, 7)));
+		
+		auto& byte = column[page * s_max_size.x];
+		byte = value? byte | mask: byte & ~mask;
+	}
+}
+
+void SH1106Display::draw(const Sprite& sprite, const Vector2i& position)
+{
+	constexpr int pages = 8;
+	
+	Vector2i origin = position + Vector2i((s_max_size.x - m_size.x) / 2, (s_max_size.y - m_size.y) / 2);
+	
+	// Sprite pages are shifted into pairs of adjacent display pages
+	int first_page = origin.y >> 3;
+	int shift = origin.y & 7;
+	
+	int first_column = std::max<int>((s_max_size.x - m_size.x) / 2, origin.x);
+	int last_column = std::min<int>((s_max_size.x + m_size.x) / 2, origin.x + sprite.getSize().x);
+	
+	for (size_t sprite_page = 0; sprite_page < sprite.getPageCount(); sprite_page++)
+	{
+		const auto* pixel_data = sprite.getPixelData(sprite_page);
+		const auto* mask_data = sprite.getMaskData(sprite_page);
+		
+		for (int half = 0; half < 2; half++)
+		{
+			int page = first_page + sprite_page + half;
+			if (!(0 <= page && page < pages))
+				continue;
+			
+			auto* row = m_pixel_data + page * s_max_size.x;
+			for (int column = first_column; column < last_column; column++)
+			{
+				uint8_t pixels = (pixel_data[column - origin.x] << shift) >> (8 * half);
+				uint8_t mask = (mask_data[column - origin.x] << shift) >> (8 * half);
+				
+				row[column] = (row[column] & ~mask) | (pixels & mask);
+			}
+		}
+	}
+}
+
+void SH1106Display::compose(const Layer& layer, Layer::Blend blend)
+{
+	auto* destination = reinterpret_cast<uint32_t*>(m_pixel_data);
+	
+	const auto& pixel_data = layer.getPixelData();
+	const auto& coverage_data = layer.getCoverageData();
+	
+	switch (blend)
+	{
+		case Layer::Blend::Copy:
+			std::ranges::copy(pixel_data, destination);
+			break;
+		
+		case Layer::Blend::Or:
+			for (size_t i = 0; i < Layer::s_word_count; i++)
+				destination[i] |= pixel_data[i];
+			
+			break;
+		
+		case Layer::Blend::AndNot:
+			for (size_t i = 0; i < Layer::s_word_count; i++)
+				destination[i] &= ~pixel_data[i];
+			
+			break;
+		
+		case Layer::Blend::Xor:
+			for (size_t i = 0; i < Layer::s_word_count; i++)
+				destination[i] ^= pixel_data[i];
+			
+			break;
+		
+		case Layer::Blend::Over:
+			for (size_t i = 0; i < Layer::s_word_count; i++)
+				destination[i] = (destination[i] & ~coverage_data[i]) | pixel_data[i];
+			
+			break;
+	
+	}
+}
+
 void SH1106Display::setContrast(uint8_t contrast)
 {
 	sendCommand(Command::SetContrastControlMode);
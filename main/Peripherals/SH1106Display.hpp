@@ -1,6 +1,6 @@
 #pragma once
 
-#include "FreeRTOS/FreeRTOS.h"
+#include "freertos/FreeRTOS.h"
 
 #include "esp_log.h"
 
@@ -9,6 +9,10 @@
 #include "driver/gpio.h"
 
 #include <Vector.hpp>
+#include <Sprite.hpp>
+#include <Layer.hpp>
+
+#include <array>
 
 //========================================
 
@@ -26,12 +30,22 @@ public:
 		const Vector2u& size = Vector2u(128, 64)
 	);
 	
+	// Only sends pages that differ from the ones sent last time
 	void flush();
 	
 	const Vector2u& getSize() const;
 	
 	bool setPixel(const Vector2i& position, bool value);
 	
+	// Sets rows [top, bottom] of the column a page byte at a time, clipped to the screen
+	void fillColumn(int x, int top, int bottom, bool value);
+	
+	// Copies opaque pixels of the sprite a byte at a time
+	void draw(const Sprite& sprite, const Vector2i& position);
+	
+	// Blends the whole layer into the frame a word at a time
+	void compose(const Layer& layer, Layer::Blend blend);
+	
 	void setContrast(uint8_t contrast);
 	uint8_t getContrast() const;
 	
@@ -78,6 +92,10 @@ private:
 	
 	uint8_t* m_pixel_data = nullptr;
 	
+	// Display RAM contents, valid once the whole frame has been sent
+	std::array<uint8_t, Layer::s_columns * Layer::s_pages> m_sent_data {};
+	bool m_sent_valid = false;
+	
 	bool    m_inverted = false;
 	uint8_t m_contrast = 0x3F;
 	
@@ -1,10 +1,48 @@
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
 #include <Render.hpp>
 #include <Vector.hpp>
 
 //========================================
 
+AxisScale::AxisScale(Sample min_code, Sample max_code, int pixels):
+	min(min_code),
+	max(std::max(min_code, max_code))
+{
+	if (max > min)
+		factor = ((pixels - 1) << 16) / (max - min);
+	
+	else
+		offset = pixels / 2;
+}
+
+AxisScale AxisScale::FromVolts(double min, double max, double lsb, int pixels)
+{
+	auto to_code = [](double code)
+	{
+		return static_cast<Sample>(std::clamp<double>(
+			code,
+			std::numeric_limits<Sample>::min(),
+			std::numeric_limits<Sample>::max()
+		));
+	};
+	
+	return AxisScale(to_code(std::floor(min / lsb)), to_code(std::ceil(max / lsb)), pixels);
+}
+
+int AxisScale::operator()(Sample code) const
+{
+	// Range is at most 16 bits and the factor at most the pixel count in 16.16, so the product fits
+	return offset + (((std::clamp(code, min, max) - min) * factor + (1 << 15)) >> 16);
+}
+
+//========================================
+
+template<Canvas C>
 void Rectangle(
-	SH1106Display& display,
+	C& canvas,
 	const Vector2i& position,
 	const Vector2i& size,
 	bool value /*= true*/
@@ -13,11 +51,12 @@ void Rectangle(
 	Vector2i point;
 	for (point.x = 0; point.x < size.x; point.x++)
 		for (point.y = 0; point.y < size.y; point.y++)
-			display.setPixel(position + point, value);
+			canvas.setPixel(position + point, value);
 }
 
+template<Canvas C>
 void RoundedRectangle(
-	SH1106Display&  display,
+	C&              canvas,
 	const Vector2i& position,
 	const Vector2i& size,
 	int             radius,
@@ -69,9 +108,9 @@ void RoundedRectangle(
 				)
 					point_radius_sqr = pow(size.x - point.x - radius - 1, 2) + pow(size.y - point.y - 1 - radius, 2);
 			}
-
+			
 			if (point_radius_sqr < 0)
-				display.setPixel(
+				canvas.setPixel(
 					position + point,
 					style & RoundedRectangleStyle::Outline
 						? value ^ (point.x == 0 || point.x == size.x - 1 || point.y == 0 || point.y == size.y - 1)
@@ -79,7 +118,7 @@ void RoundedRectangle(
 				);
 			
 			else if (point_radius_sqr <= radius_sqr)
-				display.setPixel(
+				canvas.setPixel(
 					position + point,
 					style & RoundedRectangleStyle::Outline
 						? value ^ (radius_sqr - point_radius_sqr <= radius)
@@ -89,8 +128,9 @@ void RoundedRectangle(
 	}
 }
 
+template<Canvas C>
 void Circle(
-	SH1106Display& display,
+	C& canvas,
 	const Vector2f& center,
 	float radius,
 	bool value /*= true*/
@@ -102,17 +142,18 @@ void Circle(
 	for (point.x = -radius; point.x <= radius; point.x++)
 		for (point.y = -radius; point.y <= radius; point.y++)
 			if (point.lengthSqr() < radius_sqr)
-				display.setPixel(center + point, value);
+				canvas.setPixel(center + point, value);
 }
 
+template<Canvas C>
 void Line(
-	SH1106Display& display,
+	C& canvas,
 	Vector2i a,
 	Vector2i b,
 	bool value /*= true*/
 )
 {
-	auto display_size = display.getSize();
+	auto canvas_size = canvas.getSize();
 	
 	auto dx = abs(b.x - a.x);
 	auto sx = 1 - 2 * (a.x > b.x);
@@ -123,7 +164,7 @@ void Line(
 	auto error = dx + dy;
 	while (true)
 	{
-		display.setPixel(a, value);
+		canvas.setPixel(a, value);
 		
 		auto error2 = 2 * error;
 		if (error2 >= dy)
@@ -132,7 +173,7 @@ void Line(
 				break;
 			
 			a.x += sx;
-			if (!(0 <= a.x && a.x < display_size.x))
+			if (!(0 <= a.x && a.x < canvas_size.x))
 				break;
 			
 			error += dy;
@@ -144,7 +185,7 @@ void Line(
 				break;
 			
 			a.y += sy;
-			if (!(0 <= a.y && a.y < display_size.y))
+			if (!(0 <= a.y && a.y < canvas_size.y))
 				break;
 			
 			error += dx;
@@ -152,12 +193,13 @@ void Line(
 	}
 }
 
+template<Canvas C>
 void Character(
-	SH1106Display& display,
+	C& canvas,
 	const Font& font,
 	const Vector2i& position,
 	char ch,
-	bool value /*= true */,
+	bool value /*= true*/,
 	bool fill  /*= false*/
 )
 {
@@ -171,17 +213,18 @@ void Character(
 				uint16_t i = point.y * font.getGlyphSize().x + point.x;
 				
 				if ((data[i / 8] >> (i % 8)) & 1)
-					display.setPixel(position + point, value);
+					canvas.setPixel(position + point, value);
 				
 				else if (fill)
-					display.setPixel(position + point, !value);
+					canvas.setPixel(position + point, !value);
 			}
 		}
 	}
 }
 
+template<Canvas C>
 void Text(
-	SH1106Display& display,
+	C& canvas,
 	const Font& font,
 	const Vector2i& position,
 	std::string_view text,
@@ -190,7 +233,211 @@ void Text(
 )
 {
 	for (size_t i = 0; i < text.length(); i++)
-		Character(display, font, position + i * Vector2i(font.getGlyphSize().x, 0), text[i], value, fill);
+		Character(canvas, font, position + i * Vector2i(font.getGlyphSize().x, 0), text[i], value, fill);
 }
 
+template<Canvas C>
+void Plot(
+	C& canvas,
+	std::span<const Sample> samples,
+	double lsb,
+	double min,
+	double max,
+	PlotMode mode /*= PlotMode::Average*/,
+	bool value /*= true*/
+)
+{
+	const int width = canvas.getSize().x;
+	const int height = canvas.getSize().y;
+	
+	if (samples.empty() || !width || !height)
+		return;
+	
+	// Row of a sample code, flat range puts everything in the middle
+	double scale = max > min? height * lsb / (max - min): 0;
+	double offset = max > min? height + min * height / (max - min): height / 2;
+	
+	auto to_row = [&](double code) -> int
+	{
+		return std::clamp(offset - code * scale, 0., height - 1.);
+	};
+	
+	// Rows are kept with the top above the bottom, so that y grows downwards
+	int prev_column = -1;
+	int prev_top = 0;
+	int prev_bottom = 0;
+	
+	auto fill = [&](int column, int top, int bottom)
+	{
+		// Joined to the previous column
+		canvas.fillColumn(column, std::min(top, prev_bottom), std::max(bottom, prev_top), value);
+		
+		prev_top = top;
+		prev_bottom = bottom;
+	};
+	
+	const size_t size = samples.size();
+	
+	size_t end = 0;
+	for (int column = 0; column < width; column++)
+	{
+		// Samples whose position i * width / size falls into the column
+		size_t begin = end;
+		end = ((column + 1) * size + width - 1) / width;
+		
+		if (begin >= end)
+			continue;
+		
+		int32_t sum = 0;
+		Sample low = samples[begin];
+		Sample high = samples[begin];
+		for (size_t i = begin; i < end; i++)
+		{
+			sum += samples[i];
+			low = std::min(low, samples[i]);
+			high = std::max(high, samples[i]);
+		}
+		
+		int top = 0;
+		int bottom = 0;
+		if (mode == PlotMode::Peak)
+		{
+			top = to_row(high);
+			bottom = to_row(low);
+		}
+		
+		else
+			top = bottom = to_row(static_cast<double>(sum) / (end - begin));
+		
+		if (prev_column < 0)
+		{
+			prev_top = top;
+			prev_bottom = bottom;
+		}
+		
+		// Columns without samples of their own are interpolated, which happens when samples are fewer than columns
+		else
+		{
+			int first_top = prev_top;
+			int first_bottom = prev_bottom;
+			
+			for (int gap = prev_column + 1; gap < column; gap++)
+			{
+				int span = column - prev_column;
+				int step = gap - prev_column;
+				
+				fill(
+					gap,
+					first_top + (top - first_top) * step / span,
+					first_bottom + (bottom - first_bottom) * step / span
+				);
+			}
+		}
+		
+		fill(column, top, bottom);
+		prev_column = column;
+	}
+}
+
+template<Canvas C>
+void PlotXY(
+	C& canvas,
+	std::span<const Sample> x,
+	std::span<const Sample> y,
+	const AxisScale& x_scale,
+	const AxisScale& y_scale,
+	bool value /*= true*/
+)
+{
+	const int bottom = canvas.getSize().y - 1;
+	
+	const size_t size = std::min(x.size(), y.size());
+	for (size_t i = 0; i < size; i++)
+		canvas.setPixel(Vector2i(x_scale(x[i]), bottom - y_scale(y[i])), value);
+}
+
+template<Canvas C>
+void LogicTrace(
+	C& canvas,
+	std::span<const uint32_t> edges,
+	bool initial_level,
+	size_t sample_count,
+	int top,
+	int bottom,
+	bool value /*= true*/
+)
+{
+	const int width = canvas.getSize().x;
+	if (!sample_count)
+		return;
+	
+	bool level = initial_level;
+	int x = 0;
+	for (size_t i = 0; i <= edges.size(); i++)
+	{
+		int next_x = i < edges.size()? edges[i] * width / sample_count: width;
+		
+		int row = level? top: bottom;
+		for (; x < next_x; x++)
+			canvas.fillColumn(x, row, row, value);
+		
+		if (i < edges.size())
+		{
+			canvas.fillColumn(next_x, top, bottom, value);
+			level = !level;
+		}
+	}
+}
+
+template<Canvas C>
+void Graticule(
+	C& canvas,
+	const Vector2i& divisions,
+	bool value /*= true*/
+)
+{
+	Vector2i size(canvas.getSize());
+	Vector2i center = size / 2;
+	Vector2i division = size / divisions;
+	
+	for (int i = 1; i < divisions.x; i++)
+		for (int y = 0; y < size.y; y += 4)
+			canvas.setPixel(Vector2i(i * division.x, y), value);
+	
+	for (int i = 1; i < divisions.y; i++)
+		for (int x = 0; x < size.x; x += 4)
+			canvas.setPixel(Vector2i(x, i * division.y), value);
+	
+	// Axes are denser, with ticks every quarter of a division
+	for (int x = 0; x < size.x; x += 2)
+		canvas.setPixel(Vector2i(x, center.y), value);
+	
+	for (int y = 0; y < size.y; y += 2)
+		canvas.setPixel(Vector2i(center.x, y), value);
+	
+	for (int x = 0; x < size.x; x += std::max(division.x / 4, 1))
+		canvas.fillColumn(x, center.y - 1, center.y + 1, value);
+	
+	for (int y = 0; y < size.y; y += std::max(division.y / 4, 1))
+		Line(canvas, Vector2i(center.x - 1, y), Vector2i(center.x + 1, y), value);
+}
+
+//======================================== Instantiations
+
+#define INSTANTIATE_PRIMITIVES(C)                                                                                                   \
+	template void Rectangle       (C&, const Vector2i&, const Vector2i&, bool);                                                     \
+	template void RoundedRectangle(C&, const Vector2i&, const Vector2i&, int, bool, uint8_t);                                       \
+	template void Circle          (C&, const Vector2f&, float, bool);                                                               \
+	template void Line            (C&, Vector2i, Vector2i, bool);                                                                   \
+	template void Character       (C&, const Font&, const Vector2i&, char, bool, bool);                                             \
+	template void Text            (C&, const Font&, const Vector2i&, std::string_view, bool, bool);                                 \
+	template void Plot            (C&, std::span<const Sample>, double, double, double, PlotMode, bool);                            \
+	template void PlotXY          (C&, std::span<const Sample>, std::span<const Sample>, const AxisScale&, const AxisScale&, bool); \
+	template void LogicTrace      (C&, std::span<const uint32_t>, bool, size_t, int, int, bool);                                    \
+	template void Graticule       (C&, const Vector2i&, bool);
+
+INSTANTIATE_PRIMITIVES(SH1106Display)
+INSTANTIATE_PRIMITIVES(Sprite)
+INSTANTIATE_PRIMITIVES(Layer)
+
 //========================================
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
 #include <string_view>
+#include <span>
+#include <concepts>
 
 #include <Peripherals/SH1106Display.hpp>
+#include <Sprite.hpp>
+#include <Layer.hpp>
 #include <Vector.hpp>
 #include <Font.hpp>
+#include <Sample.hpp>
 
 //========================================
 
@@ -33,20 +38,57 @@ enum: uint8_t
 };
 
 //========================================
-	
+
 } // namespace RoundedRectangleStyle
 
 //========================================
 
+// Anything primitives can be drawn on
+// Column fills are expected to be clipped and done with byte masks rather than pixel by pixel
+template<typename T>
+concept Canvas = requires(T& canvas, const Vector2i& position, int x, int top, int bottom, bool value)
+{
+	{ canvas.setPixel(position, value) } -> std::same_as<bool>;
+	{ canvas.fillColumn(x, top, bottom, value) };
+	{ canvas.getSize() } -> std::convertible_to<Vector2u>;
+};
+
+enum class PlotMode: uint8_t
+{
+	Average, // Samples falling into the same column are averaged
+	Peak     // Column spans all the samples falling into it, so that short spikes are never lost
+};
+
+// Maps sample codes of [min, max] onto [0, pixels) with a 16.16 fixed point factor computed once,
+// so that plotting a whole buffer needs neither floating point nor division
+struct AxisScale
+{
+	Sample  min    = 0;
+	Sample  max    = 0;
+	int32_t factor = 0;
+	int32_t offset = 0;
+	
+	AxisScale() = default;
+	AxisScale(Sample min, Sample max, int pixels);
+	
+	// Voltage range is rounded outwards to whole codes and clamped to the sample type
+	static AxisScale FromVolts(double min, double max, double lsb, int pixels);
+	
+	// Codes out of range are clamped to the edges, flat range maps everything to the middle
+	int operator()(Sample code) const;
+};
+
+template<Canvas C>
 void Rectangle(
-	SH1106Display& display,
+	C& canvas,
 	const Vector2i& position,
 	const Vector2i& size,
 	bool value = true
 );
 
+template<Canvas C>
 void RoundedRectangle(
-	SH1106Display&  display,
+	C&              canvas,
 	const Vector2i& position,
 	const Vector2i& size,
 	int             radius,
@@ -54,30 +96,35 @@ void RoundedRectangle(
 	uint8_t         style = RoundedRectangleStyle::Default
 );
 
+template<Canvas C>
 void Circle(
-	SH1106Display& display,
+	C& canvas,
 	const Vector2f& center,
 	float radius,
 	bool value = true
 );
 
+template<Canvas C>
 void Line(
-	SH1106Display& display,
+	C& canvas,
 	Vector2i a,
 	Vector2i b,
 	bool value = true
 );
 
+template<Canvas C>
 void Character(
-	SH1106Display& display,
+	C& canvas,
 	const Font& font,
 	const Vector2i& position,
 	char ch,
-	bool value = true
+	bool value = true,
+	bool fill  = false
 );
 
+template<Canvas C>
 void Text(
-	SH1106Display& display,
+	C& canvas,
 	const Font& font,
 	const Vector2i& position,
 	std::string_view text,
@@ -85,6 +132,51 @@ void Text(
 	bool fill  = false
 );
 
+// Plots samples across the whole canvas width, scaled so that [min, max] volts fill its height
+// Every column is a single vertical span joined to the previous one, values out of range are clipped to the edge rows
+template<Canvas C>
+void Plot(
+	C& canvas,
+	std::span<const Sample> samples,
+	double lsb,
+	double min,
+	double max,
+	PlotMode mode = PlotMode::Average,
+	bool value = true
+);
+
+// Plots every (x, y) sample pair as a single pixel, y grows upwards
+template<Canvas C>
+void PlotXY(
+	C& canvas,
+	std::span<const Sample> x,
+	std::span<const Sample> y,
+	const AxisScale& x_scale,
+	const AxisScale& y_scale,
+	bool value = true
+);
+
+// Draws a digital signal across the whole canvas width from the samples at which its level flips,
+// high level is at the top row and low level at the bottom one
+template<Canvas C>
+void LogicTrace(
+	C& canvas,
+	std::span<const uint32_t> edges,
+	bool initial_level,
+	size_t sample_count,
+	int top,
+	int bottom,
+	bool value = true
+);
+
+// Dotted grid splitting the canvas into the divisions, with ticks along the axes crossing at its center
+template<Canvas C>
+void Graticule(
+	C& canvas,
+	const Vector2i& divisions,
+	bool value = true
+);
+
 //========================================
 
 template<typename... Args>
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+//========================================
+
+// Samples are kept as raw converter codes, the voltage of a single code depends on the signal source
+using Sample = int16_t;
+
+//========================================
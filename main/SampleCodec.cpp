@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include <SampleCodec.hpp>
+
+//========================================
+
+namespace SampleCodec
+{
+
+//========================================
+
+namespace
+{
+
+//========================================
+
+constexpr uint8_t EscapeLength  = 16; // Quotients this long are replaced by a raw delta
+constexpr uint8_t RawDeltaBits  = 17; // Zig-zag delta of two 16-bit samples
+constexpr uint8_t MaxParameter  = 16;
+
+//========================================
+
+uint32_t ZigZag(int32_t value)
+{
+	return static_cast<uint32_t>(value) << 1 ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t UnZigZag(uint32_t value)
+{
+	return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+// Picks the parameter minimizing estimated block size
+uint8_t ChooseParameter(uint32_t delta_sum, size_t delta_count)
+{
+	uint8_t best_parameter = 0;
+	uint32_t best_size = ~0u;
+	
+	for (uint8_t parameter = 0; parameter <= MaxParameter; parameter++)
+	{
+		uint32_t size = (delta_sum >> parameter) + delta_count * (parameter + 1);
+		if (size < best_size)
+		{
+			best_size = size;
+			best_parameter = parameter;
+		}
+	}
+	
+	return best_parameter;
+}
+
+//========================================
+
+// LSB-first bit packing
+class BitWriter
+{
+public:
+	explicit BitWriter(std::span<uint8_t> output):
+		m_output(output)
+	{}
+	
+	// Up to 24 bits at once
+	void write(uint32_t bits, uint8_t count)
+	{
+		m_accumulator |= bits << m_bits;
+		m_bits += count;
+		
+		while (m_bits >= 8)
+		{
+			if (m_size < m_output.size())
+				m_output[m_size] = m_accumulator;
+			
+			m_size++;
+			m_accumulator >>= 8;
+			m_bits -= 8;
+		}
+	}
+	
+	// Returns false if output has overflowed
+	bool finish()
+	{
+		if (m_bits)
+			write(0, 8 - m_bits);
+		
+		return m_size <= m_output.size();
+	}
+	
+	size_t getSize() const
+	{
+		return m_size;
+	}
+	
+private:
+	std::span<uint8_t> m_output;
+	size_t             m_size        = 0;
+	uint32_t           m_accumulator = 0;
+	uint8_t            m_bits        = 0;
+	
+};
+
+class BitReader
+{
+public:
+	explicit BitReader(std::span<const uint8_t> input):
+		m_input(input)
+	{}
+	
+	// Up to 24 bits at once
+	uint32_t read(uint8_t count)
+	{
+		refill(count);
+		
+		uint32_t bits = m_accumulator & ((1u << count) - 1);
+		consume(count);
+		
+		return bits;
+	}
+	
+	// Counts and consumes leading ones up to the limit, as well as the terminating zero
+	uint8_t readUnary(uint8_t limit)
+	{
+		refill(limit + 1);
+		
+		uint8_t count = std::min<uint8_t>(std::countr_one(m_accumulator), limit);
+		consume(count < limit? count + 1: count);
+		
+		return count;
+	}
+	
+	// Refills pad the input with zeros, so running out of data is only detected by the amount of consumed bits
+	bool hasOverrun() const
+	{
+		return m_consumed > m_input.size() * 8;
+	}
+	
+private:
+	std::span<const uint8_t> m_input;
+	size_t                   m_position    = 0;
+	uint32_t                 m_accumulator = 0;
+	size_t                   m_consumed    = 0;
+	uint8_t                  m_bits        = 0;
+	
+	void refill(uint8_t count)
+	{
+		while (m_bits < count)
+		{
+			if (m_position < m_input.size())
+				m_accumulator |= static_cast<uint32_t>(m_input[m_position++]) << m_bits;
+			
+			m_bits += 8;
+		}
+	}
+	
+	void consume(uint8_t count)
+	{
+		m_accumulator >>= count;
+		m_bits -= count;
+		m_consumed += count;
+	}
+	
+};
+
+//========================================
+
+} // namespace
+
+//========================================
+
+bool Encode(std::span<const Sample> samples, std::span<uint8_t> output, size_t* written)
+{
+	*written = 0;
+	for (size_t begin = 0; begin < samples.size(); begin += BlockSize)
+	{
+		auto block = samples.subspan(begin, std::min(BlockSize, samples.size() - begin));
+		
+		uint32_t delta_sum = 0;
+		for (size_t i = 1; i < block.size(); i++)
+			delta_sum += ZigZag(block[i] - block[i - 1]);
+		
+		uint8_t parameter = ChooseParameter(delta_sum, block.size() - 1);
+		uint32_t remainder_mask = (1u << parameter) - 1;
+		
+		if (output.size() - *written < sizeof(BlockHeader))
+			return false;
+		
+		BitWriter writer(output.subspan(*written + sizeof(BlockHeader)));
+		for (size_t i = 1; i < block.size(); i++)
+		{
+			uint32_t delta = ZigZag(block[i] - block[i - 1]);
+			uint32_t quotient = delta >> parameter;
+			
+			if (quotient < EscapeLength)
+			{
+				writer.write((1u << quotient) - 1, quotient + 1);
+				writer.write(delta & remainder_mask, parameter);
+			}
+			
+			else
+			{
+				writer.write((1u << EscapeLength) - 1, EscapeLength);
+				writer.write(delta, RawDeltaBits);
+			}
+		}
+		
+		if (!writer.finish())
+			return false;
+		
+		BlockHeader header = {};
+		header.count = block.size() - 1;
+		header.parameter = parameter;
+		header.payload_size = writer.getSize();
+		header.first = block.front();
+		
+		std::memcpy(output.data() + *written, &header, sizeof(header));
+		*written += sizeof(header) + writer.getSize();
+	}
+	
+	return true;
+}
+
+size_t Decode(std::span<const uint8_t> input, std::span<Sample> samples)
+{
+	size_t read = 0;
+	size_t decoded = 0;
+	
+	while (input.size() - read >= sizeof(BlockHeader))
+	{
+		BlockHeader header = {};
+		std::memcpy(&header, input.data() + read, sizeof(header));
+		
+		size_t count = header.count + 1;
+		if (
+			header.parameter > MaxParameter                            ||
+			input.size() - read - sizeof(header) < header.payload_size ||
+			samples.size() - decoded < count
+		)
+			break;
+		
+		BitReader reader(input.subspan(read + sizeof(header), header.payload_size));
+		
+		auto block = samples.subspan(decoded, count);
+		block[0] = header.first;
+		
+		for (size_t i = 1; i < count; i++)
+		{
+			uint32_t quotient = reader.readUnary(EscapeLength);
+			uint32_t delta = quotient < EscapeLength
+				? quotient << header.parameter | reader.read(header.parameter)
+				: reader.read(RawDeltaBits);
+			
+			block[i] = block[i - 1] + UnZigZag(delta);
+		}
+		
+		if (reader.hasOverrun())
+			break;
+		
+		read += sizeof(header) + header.payload_size;
+		decoded += count;
+	}
+	
+	return decoded;
+}
+
+//========================================
+
+} // namespace SampleCodec
+
+//========================================
\ No newline at end of file
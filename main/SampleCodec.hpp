@@ -0,0 +1,52 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Lossless sample compression
+// Samples are split into blocks, each one starts with a header followed by the first sample and
+// Rice coded zig-zag deltas. Rice parameter is chosen per block, so slowly varying signals take
+// only a couple of bits per sample. Has no platform dependencies and builds on the host as well.
+namespace SampleCodec
+{
+
+//========================================
+
+constexpr size_t BlockSize = 256;
+
+#pragma pack(push, 1)
+
+struct BlockHeader
+{
+	uint8_t  count;        // Sample count - 1
+	uint8_t  parameter;    // Rice parameter
+	uint16_t payload_size; // Size of the bitstream following the header and the first sample
+	Sample   first;
+};
+
+#pragma pack(pop)
+
+// Upper bound of the encoded size, useful for sizing output buffers
+constexpr size_t GetMaxEncodedSize(size_t sample_count)
+{
+	constexpr size_t max_delta_bits = 16 + 17; // Escape code followed by raw zig-zag delta
+	
+	size_t blocks = (sample_count + BlockSize - 1) / BlockSize;
+	return blocks * sizeof(BlockHeader) + (sample_count * max_delta_bits + 7) / 8 + blocks;
+}
+
+// Returns false if the output is too small, its contents are undefined then; no samples encode to no bytes
+bool Encode(std::span<const Sample> samples, std::span<uint8_t> output, size_t* written);
+
+// Returns the amount of samples decoded, decoding stops at the first malformed block
+size_t Decode(std::span<const uint8_t> input, std::span<Sample> samples);
+
+//========================================
+
+} // namespace SampleCodec
+
+//========================================
@@ -11,6 +11,11 @@ std::string_view SelectorItem::getLabel() const
 	return m_label;
 }
 
+uint32_t SelectorItem::getRevision() const
+{
+	return m_revision;
+}
+
 //================================ Flag selector item
 
 FlagSelectorItem::FlagSelectorItem(
@@ -19,129 +24,165 @@ FlagSelectorItem::FlagSelectorItem(
 	std::string_view true_text     /*= "Yes"*/,
 	std::string_view false_text    /*= "No"*/
 ):
-	OptionSelectorItem(
-		label,
-		{
-			{true_text,  true },
-			{false_text, false}
-		},
-		initial_value
-	)
+	SelectorItem(label),
+	m_true_text(true_text),
+	m_false_text(false_text),
+	m_value(initial_value)
 {}
 
+void FlagSelectorItem::setValue(bool value)
+{
+	if (m_value == value)
+		return;
+	
+	m_value = value;
+	m_revision++;
+}
+
+bool FlagSelectorItem::getValue() const
+{
+	return m_value;
+}
+
 FlagSelectorItem::operator bool() const
 {
-	return getSelectedOption();
+	return m_value;
 }
 
-//================================ Selector
+size_t FlagSelectorItem::serializeValue(char* buffer, size_t buffsize) const
+{
+	return (m_value? m_true_text: m_false_text).copy(buffer, buffsize);
+}
 
-void Selector::addItem(SelectorItem* item)
+void FlagSelectorItem::onRotate(int8_t delta)
 {
-	m_items.push_back(item);
+	m_value ^= delta & 1;
+	m_revision++;
 }
 
-void Selector::operator+=(SelectorItem* item)
+size_t FlagSelectorItem::saveState(uint8_t* buffer, size_t buffsize) const
 {
-	addItem(item);
+	if (buffsize < 1)
+		return 0;
+	
+	buffer[0] = !m_value;
+	return 1;
 }
 
-bool Selector::onEvent(RotaryEncoder::Event event)
+bool FlagSelectorItem::loadState(const uint8_t* buffer, size_t size)
 {
-	switch (event.type)
-	{
-		case RotaryEncoder::Event::Button:
-			if (event.button)
-			{
-				if (!m_shown)
-				{
-					m_shown = true;
-					m_item_focused = false;
-					m_animation_start_time = esp_timer_get_time();
-					
-					return true;
-				}
-				
-				if (!m_item_focused)
-				{
-					m_item_focused = true;
-					return true;
-				}
-				
-				m_shown = false;
-				m_animation_start_time = esp_timer_get_time();
-				
-				return true;
-			}
-			
-			return false;
-			
-		case RotaryEncoder::Event::Rotation:
-			if (!m_shown)
-				return false;
-			
-			if (m_item_focused)
-			{
-				auto current_time = esp_timer_get_time();
-				uint8_t rps = 1'000'000 / (current_time - m_last_rotation_time);
-				m_last_rotation_time = current_time;
-				
-				m_items[m_selected_item]->onRotate(rps > 10? 10 * event.delta: event.delta);
-			}
-			
-			else
-				m_selected_item = std::clamp<int>(m_selected_item + event.delta, 0, m_items.size() - 1);
-			
-			return true;
-	}
+	if (size != 1 || buffer[0] >= 2)
+		return false;
+	
+	m_value = !buffer[0];
+	m_revision++;
 	
-	return false;
+	return true;
 }
 
-void Selector::render(SH1106Display& display, const Font& font) const
+bool FlagSelectorItem::parseValue(std::string_view text)
 {
-	constexpr int animation_time_ms = 100;
-	constexpr int rounding_radius   = 2;
+	if (text == m_true_text || text == "1")
+		setValue(true);
 	
-	float t = static_cast<float>(esp_timer_get_time() - m_animation_start_time) / (1000 * animation_time_ms);
+	else if (text == m_false_text || text == "0")
+		setValue(false);
+	
+	else
+		return false;
+	
+	return true;
+}
+
+//================================ Selector
+
+const SelectorBase::BackItem SelectorBase::s_back_item {};
+
+SelectorBase::BackItem::BackItem():
+	SelectorItem("Back")
+{}
+
+size_t SelectorBase::BackItem::serializeValue(char* buffer, size_t buffsize) const
+{
+	return std::string_view("<<").copy(buffer, buffsize);
+}
+
+void SelectorBase::BackItem::onRotate(int8_t delta) const
+{}
+
+uint32_t SelectorBase::getRevision() const
+{
+	return m_revision;
+}
+
+bool SelectorBase::isAnimating() const
+{
+	return esp_timer_get_time() - m_animation_start_time < s_animation_time_us;
+}
+
+void SelectorBase::show()
+{
+	m_shown = true;
+	m_item_focused = false;
+	m_animation_start_time = esp_timer_get_time();
+}
+
+void SelectorBase::hide()
+{
+	m_shown = false;
+	m_animation_start_time = esp_timer_get_time();
+}
+
+float SelectorBase::getAnimationProgress() const
+{
+	float t = static_cast<float>(esp_timer_get_time() - m_animation_start_time) / s_animation_time_us;
 	
 	if (t > 1.f)
 	{
 		if (!m_shown)
-			return;
+			return -1.f;
 		
 		t = 1.f;
 	}
 	
-	t *= t;
+	return t * t;
+}
+
+bool SelectorBase::isSpriteValid(const SelectorItem* item, uint32_t revision) const
+{
+	return item == m_sprite_item && revision == m_sprite_revision && m_item_focused == m_sprite_focused;
+}
+
+void SelectorBase::updateSprite(
+	const Vector2u&     display_size,
+	const Font&         font,
+	const SelectorItem* item,
+	uint32_t            revision,
+	std::string_view    value
+) const
+{
+	constexpr int rounding_radius = 2;
 	
-	const auto& item = *m_items[m_selected_item];
+	m_sprite_item = item;
+	m_sprite_revision = revision;
+	m_sprite_focused = m_item_focused;
 	
-	char buffer[32] = "";
-	std::string_view value(
-		buffer,
-		item.serializeValue(buffer, std::size(buffer))
-	);
-
-	auto rect_size = font.getGlyphSize() * Vector2i(
-		std::max(item.getLabel().length(), value.length()),
+	Vector2i rect_size = font.getGlyphSize() * Vector2i(
+		std::max(item->getLabel().length(), value.length()),
 		1
 	);
 	
-	auto offset = (display.getSize() - Vector2i(rect_size.x, font.getGlyphSize().y * 2)) / 2;
-
-	if (m_shown)
-		offset.y += (1.f - t) * rect_size.y;
-	
-	else
-		offset.y -= t * rect_size.y;
+	// Sprite covers both boxes including the rounding, which sticks out to the top left
+	Vector2i offset = (Vector2i(display_size) - Vector2i(rect_size.x, font.getGlyphSize().y * 2)) / 2;
+	m_sprite_position = offset - rounding_radius;
+	m_sprite.resize(Vector2u(rect_size.x + rounding_radius, rect_size.y * 2 + rounding_radius));
 	
 	auto draw_text = [&](const std::string_view& text, uint8_t y, bool selected, uint8_t style)
 	{
-		Vector2i position(offset.x, offset.y + y * font.getGlyphSize().y);
+		Vector2i position(rounding_radius, rounding_radius + y * font.getGlyphSize().y);
 		
 		RoundedRectangle(
-			display,
+			m_sprite,
 			position - rounding_radius,
 			rect_size + rounding_radius,
 			rounding_radius,
@@ -150,16 +191,29 @@ void Selector::render(SH1106Display& display, const Font& font) const
 		);
 		
 		Text(
-			display,
+			m_sprite,
 			font,
-			Vector2i(display.getSize().x / 2 - text.length() * font.getGlyphSize().x / 2, position.y),
+			Vector2i(display_size.x / 2 - text.length() * font.getGlyphSize().x / 2 - m_sprite_position.x, position.y),
 			text,
 			!selected
 		);
 	};
 	
-	draw_text(item.getLabel(), 0, !m_item_focused, RoundedRectangleStyle::Top   );
-	draw_text(value,           1,  m_item_focused, RoundedRectangleStyle::Bottom);
+	draw_text(item->getLabel(), 0, !m_item_focused, RoundedRectangleStyle::Top   );
+	draw_text(value,            1,  m_item_focused, RoundedRectangleStyle::Bottom);
+}
+
+void SelectorBase::drawSprite(Layer& layer, const Font& font, float t) const
+{
+	auto position = m_sprite_position;
+	
+	if (m_shown)
+		position.y += (1.f - t) * font.getGlyphSize().y;
+	
+	else
+		position.y -= t * font.getGlyphSize().y;
+	
+	layer.draw(m_sprite, position);
 }
 
-//================================
\ No newline at end of file
+//================================
@@ -1,21 +1,40 @@
 #pragma once
 
 #include <string_view>
-#include <initializer_list>
-#include <vector>
+#include <span>
+#include <tuple>
+#include <array>
+#include <utility>
+#include <type_traits>
+#include <concepts>
 #include <algorithm>
-#include <chrono>
+#include <cstring>
+#include <cmath>
 #include <cassert>
+#include <charconv>
 
 #include "esp_timer.h"
 
-#include <Selector.hpp>
 #include <Render.hpp>
 #include <Peripherals/RotaryEncoder.hpp>
-#include <Peripherals/SH1106Display.hpp>
+#include <Layer.hpp>
+#include <Sprite.hpp>
 
 //================================ Basic selector item
 
+// Items are not polymorphic: the menu is a compile-time tuple of item references and Selector
+// dispatches to the concrete types, so every item type has to provide the following:
+//
+//     size_t serializeValue(char* buffer, size_t buffsize) const;
+//     void onRotate(int8_t delta);
+//
+//     // Raw value representation used for persistence, never longer than the state size
+//     static constexpr size_t s_state_size;
+//     size_t saveState(uint8_t* buffer, size_t buffsize) const;
+//     bool loadState(const uint8_t* buffer, size_t size);
+//
+//     // Value from the text serializeValue produces, used by the command interface
+//     bool parseValue(std::string_view text);
 class SelectorItem
 {
 public:
@@ -23,14 +42,27 @@ public:
 	
 	std::string_view getLabel() const;
 	
-	virtual size_t serializeValue(char* buffer, size_t buffsize) const = 0;
-	virtual void onRotate(int8_t delta) = 0;
+	// Incremented every time the value changes
+	uint32_t getRevision() const;
 	
 protected:
 	std::string_view m_label;
+	uint32_t         m_revision = 0;
 	
 };
 
+template<typename T>
+concept SelectorItemType = std::derived_from<T, SelectorItem> && requires(
+	T item,
+	const T const_item,
+	char* text,
+	size_t size
+)
+{
+	{ const_item.serializeValue(text, size) } -> std::same_as<size_t>;
+	{ item.onRotate(int8_t()) };
+};
+
 //================================ Number selector item
 
 template<typename T>
@@ -54,8 +86,15 @@ public:
 	
 	operator const T&() const;
 	
-	size_t serializeValue(char* buffer, size_t buffsize) const override;
-	void onRotate(int8_t delta) override;
+	size_t serializeValue(char* buffer, size_t buffsize) const;
+	void onRotate(int8_t delta);
+	
+	static constexpr size_t s_state_size = sizeof(T);
+	size_t saveState(uint8_t* buffer, size_t buffsize) const;
+	bool loadState(const uint8_t* buffer, size_t size);
+	
+	// Leading number, the unit after it is ignored; values out of range are rejected
+	bool parseValue(std::string_view text);
 	
 private:
 	std::string_view m_format;
@@ -79,30 +118,40 @@ class OptionSelectorItem: public SelectorItem
 public:
 	using Option = std::pair<std::string_view, T>;
 	
+	// Options are not copied, they are expected to be a static table
 	OptionSelectorItem(
 		std::string_view label,
-		const std::initializer_list<Option>& options,
+		std::span<const Option> options,
 		T initial_value
 	);
 	
 	OptionSelectorItem(
 		std::string_view label,
-		const std::initializer_list<Option>& options
+		std::span<const Option> options
 	);
-
+	
 	void setSelectedOption(T option);
 	T getSelectedOption() const;
 	
-	size_t serializeValue(char* buffer, size_t buffsize) const override;
-	void onRotate(int8_t delta) override;
+	size_t serializeValue(char* buffer, size_t buffsize) const;
+	void onRotate(int8_t delta);
+	
+	// Stored as the option index
+	static constexpr size_t s_state_size = 1;
+	size_t saveState(uint8_t* buffer, size_t buffsize) const;
+	bool loadState(const uint8_t* buffer, size_t size);
+	
+	bool parseValue(std::string_view text);
 	
 private:
-	std::vector<Option> m_options;
+	std::span<const Option> m_options;
 	size_t m_selected_option;
 	
 };
 
-class FlagSelectorItem: public OptionSelectorItem<bool>
+//================================ Flag selector item
+
+class FlagSelectorItem: public SelectorItem
 {
 public:
 	explicit FlagSelectorItem(
@@ -112,45 +161,177 @@ public:
 		std::string_view false_text    = "No"
 	);
 	
+	void setValue(bool value);
+	bool getValue() const;
+	
 	operator bool() const;
-
+	
+	size_t serializeValue(char* buffer, size_t buffsize) const;
+	void onRotate(int8_t delta);
+	
+	// Stored as an option index with the true option first
+	static constexpr size_t s_state_size = 1;
+	size_t saveState(uint8_t* buffer, size_t buffsize) const;
+	bool loadState(const uint8_t* buffer, size_t size);
+	
+	// Either of the texts, or 1 and 0
+	bool parseValue(std::string_view text);
+	
+private:
+	std::string_view m_true_text;
+	std::string_view m_false_text;
+	
+	bool m_value;
+	
 };
 
-//================================ Selector
+//================================ Submenu selector item
 
-class Selector
+// Opened by pressing the knob, has no value of its own
+template<SelectorItemType... Items>
+class SubmenuSelectorItem: public SelectorItem
 {
 public:
-	Selector() = default;
+	explicit SubmenuSelectorItem(std::string_view label, Items&... items);
 	
-	void addItem(SelectorItem* item);
-	void operator+=(SelectorItem* item);
+	const std::tuple<Items&...>& getItems() const;
 	
-	bool onEvent(RotaryEncoder::Event event);
-	void render(SH1106Display& display, const Font& font) const;
+	size_t serializeValue(char* buffer, size_t buffsize) const;
+	void onRotate(int8_t delta);
 	
 private:
-	std::vector<SelectorItem*> m_items {};
+	std::tuple<Items&...> m_items;
 	
-	bool   m_shown          = false;
-	bool   m_item_focused   = false;
-	size_t m_selected_item  = 0;
+};
 
-	uint64_t m_last_rotation_time = esp_timer_get_time();
+template<typename T>
+inline constexpr bool IsSubmenuSelectorItem = false;
+
+template<typename... Items>
+inline constexpr bool IsSubmenuSelectorItem<SubmenuSelectorItem<Items...>> = true;
+
+// Amount of nested menu levels, including the top one
+template<typename T>
+inline constexpr size_t SelectorMenuDepth = 0;
+
+template<typename... Items>
+inline constexpr size_t SelectorMenuDepth<SubmenuSelectorItem<Items...>> = 1 + std::max({ size_t(0), SelectorMenuDepth<Items>... });
+
+// Amount of value items, including the ones inside submenus
+template<typename T>
+inline constexpr size_t SelectorItemCount = 1;
+
+template<typename... Items>
+inline constexpr size_t SelectorItemCount<SubmenuSelectorItem<Items...>> = (size_t(0) + ... + SelectorItemCount<Items>);
+
+// Total state size of the value items, including the ones inside submenus
+template<typename T>
+inline constexpr size_t SelectorStateSize = T::s_state_size;
+
+template<typename... Items>
+inline constexpr size_t SelectorStateSize<SubmenuSelectorItem<Items...>> = (size_t(0) + ... + SelectorStateSize<Items>);
+
+//================================ Selector
+
+// State, animation and the widget sprite, which do not depend on the menu layout
+class SelectorBase
+{
+public:
+	// Incremented every time an item value is changed by the user
+	uint32_t getRevision() const;
 	
-	// Animation
-	uint64_t m_animation_start_time = esp_timer_get_time();
-	enum class AnimationType: uint8_t
+	// Widget has to be redrawn every frame while showing or hiding
+	bool isAnimating() const;
+	
+protected:
+	static constexpr int64_t s_animation_time_us = 100'000;
+	
+	// Entry appended to every submenu to get back to the parent menu
+	class BackItem: public SelectorItem
 	{
-		None,
+	public:
+		BackItem();
 		
-		Show,
-		Hide,
-		Left,
-		Right
-	} m_animation_type = AnimationType::None;
+		size_t serializeValue(char* buffer, size_t buffsize) const;
+		void onRotate(int8_t delta) const;
+		
+	};
+	
+	static const BackItem s_back_item;
 	
-	void startAnimation(AnimationType type);
+	SelectorBase() = default;
+	
+	uint32_t m_revision = 0;
+	
+	bool   m_shown        = false;
+	bool   m_item_focused = false;
+	size_t m_depth        = 0;
+	
+	uint64_t m_animation_start_time = esp_timer_get_time();
+	
+	void show();
+	void hide();
+	
+	// Negative once the widget is completely hidden
+	float getAnimationProgress() const;
+	
+	// Widget of the selected item is rendered into a sprite, which is only redrawn when
+	// another item is selected, the item value changes or the focus moves
+	bool isSpriteValid(const SelectorItem* item, uint32_t revision) const;
+	void updateSprite(const Vector2u& display_size, const Font& font, const SelectorItem* item, uint32_t revision, std::string_view value) const;
+	void drawSprite(Layer& layer, const Font& font, float t) const;
+	
+private:
+	mutable Sprite              m_sprite          {};
+	mutable Vector2i            m_sprite_position {};
+	mutable const SelectorItem* m_sprite_item     = nullptr;
+	mutable uint32_t            m_sprite_revision = 0;
+	mutable bool                m_sprite_focused  = false;
+	
+};
+
+// Menu over a fixed set of items, dispatched at compile time
+template<SelectorItemType... Items>
+class Selector: public SelectorBase
+{
+public:
+	explicit Selector(Items&... items);
+	Selector(const Selector& copy) = delete;
+	
+	bool onEvent(RotaryEncoder::Event event);
+	void render(Layer& layer, const Font& font) const;
+	
+	// Calls the function with every value item, including the ones inside submenus
+	template<typename F>
+	void forEachItem(F&& function) const;
+	
+	// Sets the value of the item with the label as if the user did, returns false if there is none or the text is not a value of it
+	bool setItemValue(std::string_view label, std::string_view text);
+	
+	// Of the items forEachItem goes through
+	static constexpr size_t s_item_count = SelectorItemCount<SubmenuSelectorItem<Items...>>;
+	static constexpr size_t s_state_size = SelectorStateSize<SubmenuSelectorItem<Items...>>;
+	
+private:
+	static constexpr size_t s_depth = SelectorMenuDepth<SubmenuSelectorItem<Items...>>;
+	
+	std::tuple<Items&...> m_items;
+	
+	// Selected entry of every open menu level
+	std::array<uint8_t, s_depth> m_path {};
+	
+	template<typename F>
+	void visitSelected(F&& function) const;
+	size_t getEntryCount() const;
+	
+	template<typename Tuple, typename F>
+	static void VisitMenu(const Tuple& items, const uint8_t* path, size_t depth, F&& function);
+	
+	template<typename Tuple, typename F>
+	static void VisitItem(const Tuple& items, size_t index, F&& function);
+	
+	template<typename T, typename F>
+	static void ForEachItem(T& item, F& function);
 	
 };
 
@@ -176,7 +357,11 @@ NumberSelectorItem<T>::NumberSelectorItem(
 template<NumberSelectorItemType T>
 void NumberSelectorItem<T>::setValue(T value)
 {
+	if (m_value == value)
+		return;
+	
 	m_value = value;
+	m_revision++;
 }
 
 template<NumberSelectorItemType T>
@@ -197,10 +382,60 @@ size_t NumberSelectorItem<T>::serializeValue(char* buffer, size_t buffsize) cons
 	return snprintf(buffer, buffsize, m_format.data(), m_value);
 }
 
+// Accelerated deltas step past the range of small integer types, so the value is clamped before it is narrowed
 template<NumberSelectorItemType T>
 void NumberSelectorItem<T>::onRotate(int8_t delta)
 {
-	m_value = std::clamp<T>(m_value + delta * m_step, m_min, m_max);
+	using Wide = std::common_type_t<T, int64_t>;
+	m_value = static_cast<T>(std::clamp<Wide>(static_cast<Wide>(m_value) + static_cast<Wide>(delta) * m_step, m_min, m_max));
+	m_revision++;
+}
+
+template<NumberSelectorItemType T>
+size_t NumberSelectorItem<T>::saveState(uint8_t* buffer, size_t buffsize) const
+{
+	if (buffsize < sizeof(T))
+		return 0;
+	
+	std::memcpy(buffer, &m_value, sizeof(T));
+	return sizeof(T);
+}
+
+template<NumberSelectorItemType T>
+bool NumberSelectorItem<T>::loadState(const uint8_t* buffer, size_t size)
+{
+	if (size != sizeof(T))
+		return false;
+	
+	T value {};
+	std::memcpy(&value, buffer, sizeof(T));
+	
+	// Also rejects NaN
+	if (!(m_min <= value && value <= m_max))
+		return false;
+	
+	m_value = value;
+	m_revision++;
+	
+	return true;
+}
+
+template<NumberSelectorItemType T>
+bool NumberSelectorItem<T>::parseValue(std::string_view text)
+{
+	text.remove_prefix(std::min(text.find_first_not_of(' '), text.size()));
+	
+	// Integers are parsed wider, so that out of range values are rejected rather than wrapped
+	std::conditional_t<std::floating_point<T>, double, long long> value {};
+	if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc())
+		return false;
+	
+	// Also rejects NaN
+	if (!(m_min <= value && value <= m_max))
+		return false;
+	
+	setValue(static_cast<T>(value));
+	return true;
 }
 
 //================================ Option selector item
@@ -208,23 +443,12 @@ void NumberSelectorItem<T>::onRotate(int8_t delta)
 template<typename T>
 OptionSelectorItem<T>::OptionSelectorItem(
 	std::string_view label,
-	const std::initializer_list<Option>& options,
+	std::span<const Option> options,
 	T initial_value
 ):
 	SelectorItem(label),
 	m_options(options),
-	m_selected_option(
-		std::ranges::distance(
-			options.begin(),
-			std::ranges::find_if(
-				options,
-				[&](const Option& option) -> bool
-				{
-					return option.second == initial_value;
-				}
-			)
-		)
-	)
+	m_selected_option(std::ranges::distance(options.begin(), std::ranges::find(options, initial_value, &Option::second)))
 {
 	assert(m_selected_option < m_options.size());
 }
@@ -232,7 +456,7 @@ OptionSelectorItem<T>::OptionSelectorItem(
 template<typename T>
 OptionSelectorItem<T>::OptionSelectorItem(
 	std::string_view label,
-	const std::initializer_list<Option>& options
+	std::span<const Option> options
 ):
 	SelectorItem(label),
 	m_options(options),
@@ -242,8 +466,14 @@ OptionSelectorItem<T>::OptionSelectorItem(
 template<typename T>
 void OptionSelectorItem<T>::setSelectedOption(T option)
 {
-	m_selected_option = std::ranges::distance(m_options.begin(), std::ranges::find(m_options, option));
-	assert(m_selected_option < m_options.size());
+	auto selected_option = std::ranges::distance(m_options.begin(), std::ranges::find(m_options, option, &Option::second));
+	assert(selected_option < m_options.size());
+	
+	if (m_selected_option == selected_option)
+		return;
+	
+	m_selected_option = selected_option;
+	m_revision++;
 }
 
 template<typename T>
@@ -258,10 +488,274 @@ size_t OptionSelectorItem<T>::serializeValue(char* buffer, size_t buffsize) cons
 	return m_options[m_selected_option].first.copy(buffer, buffsize);
 }
 
+// Wraps around either way, however many options the delta skips
 template<typename T>
 void OptionSelectorItem<T>::onRotate(int8_t delta)
 {
-	(m_selected_option += delta) %= m_options.size();
+	auto count = static_cast<ptrdiff_t>(m_options.size());
+	m_selected_option = ((static_cast<ptrdiff_t>(m_selected_option) + delta) % count + count) % count;
+	m_revision++;
+}
+
+template<typename T>
+bool OptionSelectorItem<T>::parseValue(std::string_view text)
+{
+	auto option = std::ranges::find(m_options, text, &Option::first);
+	if (option == m_options.end())
+		return false;
+	
+	setSelectedOption(option->second);
+	return true;
+}
+
+template<typename T>
+size_t OptionSelectorItem<T>::saveState(uint8_t* buffer, size_t buffsize) const
+{
+	if (buffsize < 1)
+		return 0;
+	
+	buffer[0] = m_selected_option;
+	return 1;
+}
+
+template<typename T>
+bool OptionSelectorItem<T>::loadState(const uint8_t* buffer, size_t size)
+{
+	if (size != 1 || buffer[0] >= m_options.size())
+		return false;
+	
+	m_selected_option = buffer[0];
+	m_revision++;
+	
+	return true;
+}
+
+//================================ Submenu selector item
+
+template<SelectorItemType... Items>
+SubmenuSelectorItem<Items...>::SubmenuSelectorItem(std::string_view label, Items&... items):
+	SelectorItem(label),
+	m_items(items...)
+{}
+
+template<SelectorItemType... Items>
+const std::tuple<Items&...>& SubmenuSelectorItem<Items...>::getItems() const
+{
+	return m_items;
+}
+
+template<SelectorItemType... Items>
+size_t SubmenuSelectorItem<Items...>::serializeValue(char* buffer, size_t buffsize) const
+{
+	return std::string_view(">>").copy(buffer, buffsize);
+}
+
+template<SelectorItemType... Items>
+void SubmenuSelectorItem<Items...>::onRotate(int8_t delta)
+{}
+
+//================================ Selector
+
+template<SelectorItemType... Items>
+Selector<Items...>::Selector(Items&... items):
+	m_items(items...)
+{}
+
+template<SelectorItemType... Items>
+bool Selector<Items...>::onEvent(RotaryEncoder::Event event)
+{
+	switch (event.type)
+	{
+		case RotaryEncoder::Event::Button:
+			if (!event.button)
+				return false;
+			
+			if (!m_shown)
+				show();
+			
+			else if (m_item_focused)
+				hide();
+			
+			else visitSelected(
+				[&]<typename T>(T& item)
+				{
+					if constexpr (IsSubmenuSelectorItem<T>)
+						m_path[++m_depth] = 0;
+					
+					else if constexpr (std::same_as<T, const BackItem>)
+						m_depth--;
+					
+					else
+						m_item_focused = true;
+				}
+			);
+			
+			return true;
+		
+		case RotaryEncoder::Event::Rotation:
+			if (!m_shown)
+				return false;
+			
+			if (m_item_focused)
+			{
+				// Rotation is already accelerated by the encoder
+				visitSelected(
+					[&](auto& item)
+					{
+						item.onRotate(event.delta);
+					}
+				);
+				
+				m_revision++;
+			}
+			
+			else
+				m_path[m_depth] = std::clamp<int>(m_path[m_depth] + event.delta, 0, getEntryCount() - 1);
+			
+			return true;
+	}
+	
+	return false;
+}
+
+template<SelectorItemType... Items>
+void Selector<Items...>::render(Layer& layer, const Font& font) const
+{
+	float t = getAnimationProgress();
+	if (t < 0)
+		return;
+	
+	visitSelected(
+		[&](const auto& item)
+		{
+			if (isSpriteValid(&item, item.getRevision()))
+				return;
+			
+			char buffer[32] = "";
+			std::string_view value(
+				buffer,
+				item.serializeValue(buffer, std::size(buffer))
+			);
+			
+			updateSprite(layer.getSize(), font, &item, item.getRevision(), value);
+		}
+	);
+	
+	drawSprite(layer, font, t);
+}
+
+template<SelectorItemType... Items>
+template<typename F>
+void Selector<Items...>::forEachItem(F&& function) const
+{
+	std::apply(
+		[&](auto&... items)
+		{
+			(ForEachItem(items, function), ...);
+		},
+		m_items
+	);
+}
+
+template<SelectorItemType... Items>
+bool Selector<Items...>::setItemValue(std::string_view label, std::string_view text)
+{
+	bool parsed = false;
+	forEachItem(
+		[&](auto& item)
+		{
+			if (!parsed && item.getLabel() == label)
+				parsed = item.parseValue(text);
+		}
+	);
+	
+	if (parsed)
+		m_revision++;
+	
+	return parsed;
+}
+
+template<SelectorItemType... Items>
+template<typename F>
+void Selector<Items...>::visitSelected(F&& function) const
+{
+	VisitMenu(
+		m_items,
+		m_path.data(),
+		m_depth,
+		[&]<typename Tuple>(const Tuple& items)
+		{
+			// Every submenu ends with the back entry
+			if (size_t index = m_path[m_depth]; index < std::tuple_size_v<Tuple>)
+				VisitItem(items, index, function);
+			
+			else
+				function(s_back_item);
+		}
+	);
+}
+
+template<SelectorItemType... Items>
+size_t Selector<Items...>::getEntryCount() const
+{
+	size_t count = 0;
+	VisitMenu(
+		m_items,
+		m_path.data(),
+		m_depth,
+		[&]<typename Tuple>(const Tuple& items)
+		{
+			count = std::tuple_size_v<Tuple> + (m_depth > 0);
+		}
+	);
+	
+	return count;
+}
+
+// Walks down the path to the menu at the given depth and calls the function with its items
+template<SelectorItemType... Items>
+template<typename Tuple, typename F>
+void Selector<Items...>::VisitMenu(const Tuple& items, const uint8_t* path, size_t depth, F&& function)
+{
+	if (!depth)
+		return function(items);
+	
+	VisitItem(
+		items,
+		*path,
+		[&]<typename T>(T& item)
+		{
+			if constexpr (IsSubmenuSelectorItem<T>)
+				VisitMenu(item.getItems(), path + 1, depth - 1, function);
+		}
+	);
+}
+
+template<SelectorItemType... Items>
+template<typename Tuple, typename F>
+void Selector<Items...>::VisitItem(const Tuple& items, size_t index, F&& function)
+{
+	[&]<size_t... I>(std::index_sequence<I...>)
+	{
+		((I == index && (function(std::get<I>(items)), true)) || ...);
+	}(std::make_index_sequence<std::tuple_size_v<Tuple>>());
+}
+
+template<SelectorItemType... Items>
+template<typename T, typename F>
+void Selector<Items...>::ForEachItem(T& item, F& function)
+{
+	if constexpr (IsSubmenuSelectorItem<T>)
+		std::apply(
+			[&](auto&... items)
+			{
+				(ForEachItem(items, function), ...);
+			},
+			item.getItems()
+		);
+	
+	else
+		function(item);
 }
 
 //================================
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "nvs_flash.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <Settings.hpp>
+
+//========================================
+
+static const char* TAG = "settings";
+
+//========================================
+
+Settings::~Settings()
+{
+	if (m_handle)
+		nvs_close(m_handle);
+}
+
+//========================================
+
+void Settings::setup(const char* nvs_namespace /*= "oscilloscope"*/)
+{
+	auto result = nvs_flash_init();
+	if (result == ESP_ERR_NVS_NO_FREE_PAGES || result == ESP_ERR_NVS_NEW_VERSION_FOUND)
+	{
+		ESP_LOGW(TAG, "NVS partition is unusable, erasing");
+		
+		ESP_ERROR_CHECK(nvs_flash_erase());
+		result = nvs_flash_init();
+	}
+	
+	ESP_ERROR_CHECK(result);
+	ESP_ERROR_CHECK(nvs_open(nvs_namespace, NVS_READWRITE, &m_handle));
+}
+
+std::span<const uint8_t> Settings::load(std::span<uint8_t> blob)
+{
+	size_t size = blob.size();
+	
+	auto result = nvs_get_blob(m_handle, s_blob_key, blob.data(), &size);
+	if (result != ESP_OK)
+	{
+		if (result != ESP_ERR_NVS_NOT_FOUND)
+			ESP_LOGW(TAG, "failed to read settings: %s", esp_err_to_name(result));
+		
+		return {};
+	}
+	
+	if (size < sizeof(BlobHeader))
+		return {};
+	
+	BlobHeader header = {};
+	std::memcpy(&header, blob.data(), sizeof(header));
+	
+	if (header.version != s_version)
+	{
+		ESP_LOGW(TAG, "ignoring settings of version %hu", header.version);
+		return {};
+	}
+	
+	return blob.first(size);
+}
+
+void Settings::finishRestore(size_t restored, size_t item_count, uint32_t revision)
+{
+	m_saved_revision = m_pending_revision = revision;
+	ESP_LOGI(TAG, "restored %zu/%zu items", restored, item_count);
+}
+
+bool Settings::shouldSave(uint32_t revision)
+{
+	if (revision == m_saved_revision)
+		return false;
+	
+	auto current_time = esp_timer_get_time();
+	if (revision != m_pending_revision)
+	{
+		m_pending_revision = revision;
+		m_pending_since_us = current_time;
+		return false;
+	}
+	
+	if (current_time - m_pending_since_us < s_save_delay_us)
+		return false;
+	
+	m_saved_revision = revision;
+	return true;
+}
+
+void Settings::save(std::span<const uint8_t> blob)
+{
+	if (std::ranges::equal(blob, std::span(m_saved_blob.data(), m_saved_size)))
+		return;
+	
+	auto result = nvs_set_blob(m_handle, s_blob_key, blob.data(), blob.size());
+	if (result == ESP_OK)
+		result = nvs_commit(m_handle);
+	
+	if (result != ESP_OK)
+	{
+		ESP_LOGW(TAG, "failed to save settings: %s", esp_err_to_name(result));
+		return;
+	}
+	
+	std::ranges::copy(blob, m_saved_blob.begin());
+	m_saved_size = blob.size();
+	
+	ESP_LOGI(TAG, "settings saved (%zu bytes)", blob.size());
+}
+
+std::span<const uint8_t> Settings::Find(std::span<const uint8_t> blob, std::string_view label)
+{
+	if (blob.empty())
+		return {};
+	
+	BlobHeader header = {};
+	std::memcpy(&header, blob.data(), sizeof(header));
+	
+	auto label_hash = Hash(label);
+	
+	size_t offset = sizeof(header);
+	for (uint16_t i = 0; i < header.item_count && offset + sizeof(ItemHeader) <= blob.size(); i++)
+	{
+		ItemHeader item_header = {};
+		std::memcpy(&item_header, blob.data() + offset, sizeof(item_header));
+		offset += sizeof(item_header);
+		
+		if (offset + item_header.size > blob.size())
+			break;
+		
+		if (item_header.label_hash == label_hash)
+			return blob.subspan(offset, item_header.size);
+		
+		offset += item_header.size;
+	}
+	
+	return {};
+}
+
+// FNV-1a
+uint32_t Settings::Hash(std::string_view label)
+{
+	uint32_t hash = 2166136261u;
+	for (char ch: label)
+		hash = (hash ^ static_cast<uint8_t>(ch)) * 16777619u;
+	
+	return hash;
+}
+
+//========================================
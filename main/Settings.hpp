@@ -0,0 +1,154 @@
+#pragma once
+
+#include "nvs.h"
+
+#include <array>
+#include <span>
+#include <string_view>
+#include <cstring>
+
+#include <Selector.hpp>
+
+//========================================
+
+// Persists selector item values in a single versioned NVS blob
+// Items are matched by label, so adding or removing items keeps the rest of the values
+class Settings
+{
+public:
+	Settings() = default;
+	Settings(const Settings& copy) = delete;
+	~Settings();
+	
+	void setup(const char* nvs_namespace = "oscilloscope");
+	
+	// Returns the amount of restored items
+	template<typename S>
+	size_t restore(S& selector);
+	
+	// Writes changed values once the user has left the selector alone for a while
+	template<typename S>
+	void update(const S& selector);
+	
+private:
+	#pragma pack(push, 1)
+	
+	struct BlobHeader
+	{
+		uint16_t version;
+		uint16_t item_count;
+	};
+	
+	struct ItemHeader
+	{
+		uint32_t label_hash;
+		uint8_t  size;
+	};
+	
+	#pragma pack(pop)
+	
+	static constexpr const char* s_blob_key      = "selector";
+	static constexpr uint16_t    s_version       = 1;
+	static constexpr size_t      s_max_blob_size = 512;
+	static constexpr int64_t     s_save_delay_us = 2'000'000;
+	
+	nvs_handle_t m_handle = 0;
+	
+	std::array<uint8_t, s_max_blob_size> m_saved_blob {};
+	size_t m_saved_size = 0;
+	
+	uint32_t m_saved_revision   = 0;
+	uint32_t m_pending_revision = 0;
+	int64_t  m_pending_since_us = 0;
+	
+	// Loaded blob, empty if there is none
+	std::span<const uint8_t> load(std::span<uint8_t> blob);
+	void finishRestore(size_t restored, size_t item_count, uint32_t revision);
+	
+	// Returns whether the values should be written now
+	bool shouldSave(uint32_t revision);
+	void save(std::span<const uint8_t> blob);
+	
+	// Every item is stored in full, so the size only depends on the menu layout
+	template<typename S>
+	static constexpr size_t GetBlobSize();
+	
+	template<typename S>
+	size_t serialize(const S& selector, std::span<uint8_t> blob) const;
+	
+	// Finds the state of the item in a loaded blob
+	static std::span<const uint8_t> Find(std::span<const uint8_t> blob, std::string_view label);
+	static uint32_t Hash(std::string_view label);
+	
+};
+
+//========================================
+
+template<typename S>
+size_t Settings::restore(S& selector)
+{
+	std::array<uint8_t, s_max_blob_size> buffer {};
+	auto blob = load(buffer);
+	
+	size_t restored = 0;
+	size_t item_count = 0;
+	selector.forEachItem(
+		[&](auto& item)
+		{
+			item_count++;
+			
+			if (auto state = Find(blob, item.getLabel()); state.data())
+				restored += item.loadState(state.data(), state.size());
+		}
+	);
+	
+	// Restored values are not written back until the user changes something
+	m_saved_size = serialize(selector, m_saved_blob);
+	finishRestore(restored, item_count, selector.getRevision());
+	
+	return restored;
+}
+
+template<typename S>
+void Settings::update(const S& selector)
+{
+	if (!shouldSave(selector.getRevision()))
+		return;
+	
+	std::array<uint8_t, s_max_blob_size> blob {};
+	save(std::span(blob.data(), serialize(selector, blob)));
+}
+
+template<typename S>
+constexpr size_t Settings::GetBlobSize()
+{
+	return sizeof(BlobHeader) + S::s_item_count * sizeof(ItemHeader) + S::s_state_size;
+}
+
+template<typename S>
+size_t Settings::serialize(const S& selector, std::span<uint8_t> blob) const
+{
+	static_assert(GetBlobSize<S>() <= s_max_blob_size, "Settings blob is too small for the menu");
+	
+	BlobHeader header = {};
+	header.version = s_version;
+	
+	size_t offset = sizeof(header);
+	selector.forEachItem(
+		[&](const auto& item)
+		{
+			ItemHeader item_header = {};
+			item_header.label_hash = Hash(item.getLabel());
+			item_header.size = item.saveState(blob.data() + offset + sizeof(item_header), blob.size() - offset - sizeof(item_header));
+			
+			std::memcpy(blob.data() + offset, &item_header, sizeof(item_header));
+			offset += sizeof(item_header) + item_header.size;
+			header.item_count++;
+		}
+	);
+	
+	std::memcpy(blob.data(), &header, sizeof(header));
+	return offset;
+}
+
+//========================================
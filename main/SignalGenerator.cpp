@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include <SignalGenerator.hpp>
+
+//========================================
+
+const std::array<int16_t, 1 << SignalGenerator::s_table_bits> SignalGenerator::s_sine_table = []
+{
+	std::array<int16_t, 1 << s_table_bits> table {};
+	for (size_t i = 0; i < table.size(); i++)
+		table[i] = std::lround(std::numeric_limits<int16_t>::max() * std::sin(2 * std::numbers::pi * i / table.size()));
+	
+	return table;
+}();
+
+//========================================
+
+void SignalGenerator::setup(const Config& config)
+{
+	m_config = config;
+	m_config.sample_rate_hz = std::max<uint32_t>(m_config.sample_rate_hz, 1);
+	
+	m_phase = m_config.phase;
+	m_increment = (static_cast<uint64_t>(m_config.frequency_hz) << 32) / m_config.sample_rate_hz;
+	m_duty_phase = (static_cast<uint64_t>(std::min<uint8_t>(m_config.duty_percent, 100)) << 32) / 100;
+	
+	m_chirp_increment = 0;
+	m_chirp_step = m_increment / m_config.sample_rate_hz;
+	m_chirp_samples = m_config.sample_rate_hz;
+	
+	m_noise_state = 1;
+	m_until_glitch = m_config.glitch_interval;
+	
+	m_block_position = s_block_size;
+}
+
+void SignalGenerator::generate(std::span<Sample> samples)
+{
+	std::array<int32_t, s_block_size> shape;
+	
+	for (size_t begin = 0; begin < samples.size(); begin += s_block_size)
+	{
+		auto block = samples.subspan(begin, std::min(s_block_size, samples.size() - begin));
+		auto block_shape = std::span(shape).first(block.size());
+		
+		generateShape(block_shape);
+		
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			int32_t value = m_config.offset + (block_shape[i] * m_config.amplitude >> 15);
+			
+			if (m_config.glitch_interval && !--m_until_glitch) [[unlikely]]
+			{
+				value += m_config.amplitude;
+				m_until_glitch = m_config.glitch_interval;
+			}
+			
+			block[i] = std::clamp<int32_t>(value, std::numeric_limits<Sample>::min(), std::numeric_limits<Sample>::max());
+		}
+	}
+}
+
+Sample SignalGenerator::next()
+{
+	if (m_block_position == s_block_size)
+	{
+		generate(m_block);
+		m_block_position = 0;
+	}
+	
+	return m_block[m_block_position++];
+}
+
+void SignalGenerator::generateShape(std::span<int32_t> shape)
+{
+	switch (m_config.waveform)
+	{
+		case Waveform::Sine:
+			for (auto& value: shape)
+			{
+				value = s_sine_table[m_phase >> (32 - s_table_bits)];
+				m_phase += m_increment;
+			}
+			
+			break;
+		
+		case Waveform::Square:
+			for (auto& value: shape)
+			{
+				value = m_phase < 0x8000'0000? INT16_MAX: -INT16_MAX;
+				m_phase += m_increment;
+			}
+			
+			break;
+		
+		// Folded at the half period, from the negative peak up and back
+		case Waveform::Triangle:
+			for (auto& value: shape)
+			{
+				uint32_t folded = m_phase < 0x8000'0000? m_phase: ~m_phase;
+				value = static_cast<int32_t>(folded >> 15) - INT16_MAX;
+				m_phase += m_increment;
+			}
+			
+			break;
+		
+		case Waveform::Sawtooth:
+			for (auto& value: shape)
+			{
+				value = static_cast<int32_t>(m_phase >> 16) - INT16_MAX;
+				m_phase += m_increment;
+			}
+			
+			break;
+		
+		case Waveform::Pulse:
+			for (auto& value: shape)
+			{
+				value = m_phase < m_duty_phase? INT16_MAX: -INT16_MAX;
+				m_phase += m_increment;
+			}
+			
+			break;
+		
+		// Xorshift, uniform over the range
+		case Waveform::Noise:
+			for (auto& value: shape)
+			{
+				m_noise_state ^= m_noise_state << 13;
+				m_noise_state ^= m_noise_state >> 17;
+				m_noise_state ^= m_noise_state << 5;
+				value = static_cast<int16_t>(m_noise_state);
+			}
+			
+			break;
+		
+		case Waveform::Chirp:
+			for (auto& value: shape)
+			{
+				value = s_sine_table[m_phase >> (32 - s_table_bits)];
+				m_phase += m_chirp_increment;
+				m_chirp_increment += m_chirp_step;
+				
+				if (!--m_chirp_samples)
+				{
+					m_chirp_increment = 0;
+					m_chirp_samples = m_config.sample_rate_hz;
+				}
+			}
+			
+			break;
+	
+	}
+}
+
+//========================================
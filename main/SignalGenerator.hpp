@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Direct digital synthesis test signal: a 32 bit phase accumulator advanced by a fixed increment every sample
+// drives a sine table or integer shapes, so producing a sample costs a few integer operations
+// Samples are produced a block at a time, the waveform is chosen once per block instead of once per sample
+class SignalGenerator
+{
+public:
+	static constexpr size_t s_block_size = 32;
+	
+	enum class Waveform: uint8_t
+	{
+		Sine,
+		Square,
+		Triangle,
+		Sawtooth,
+		Pulse,
+		Noise,
+		Chirp  // Sine swept from zero up to the frequency over a second, then over again
+	};
+	
+	struct Config
+	{
+		Waveform waveform;
+		uint32_t frequency_hz;
+		uint32_t sample_rate_hz;
+		Sample   amplitude;       // Peak, codes
+		Sample   offset;
+		uint8_t  duty_percent;    // Of the pulse
+		uint32_t phase;           // Initial, full turn is 2^32
+		uint32_t glitch_interval; // Samples between single sample spikes of the amplitude, 0 for none
+	};
+	
+	SignalGenerator() = default;
+	SignalGenerator(const SignalGenerator& copy) = delete;
+	
+	// Restarts the signal
+	void setup(const Config& config);
+	
+	void generate(std::span<Sample> samples);
+	
+	// Next sample out of an internally generated block
+	Sample next();
+	
+private:
+	static constexpr int s_table_bits = 10;
+	
+	// Full period, scaled to the sample range
+	static const std::array<int16_t, 1 << s_table_bits> s_sine_table;
+	
+	Config m_config {};
+	
+	uint32_t m_phase           = 0;
+	uint32_t m_increment       = 0;
+	uint32_t m_duty_phase      = 0; // Pulse is high below it
+	uint32_t m_chirp_increment = 0; // Current one, the chirp increment grows by the step every sample
+	uint32_t m_chirp_step      = 0;
+	uint32_t m_chirp_samples   = 0; // Left until the sweep starts over
+	uint32_t m_noise_state     = 1;
+	uint32_t m_until_glitch    = 0;
+	
+	std::array<Sample, s_block_size> m_block {};
+	size_t m_block_position = s_block_size;
+	
+	// Shapes in the full sample range, scaled to the amplitude and offset by the caller
+	void generateShape(std::span<int32_t> shape);
+	
+};
+
+//========================================
@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include <Sprite.hpp>
+
+//========================================
+
+void Sprite::resize(const Vector2u& size)
+{
+	m_size = Vector2u(
+		std::min<unsigned>(size.x, s_max_width),
+		std::min<unsigned>(size.y, s_max_pages * 8)
+	);
+	
+	clear();
+}
+
+void Sprite::clear()
+{
+	// Only the part in use, pages are packed by the current width
+	std::fill_n(m_pixel_data.begin(), m_size.x * getPageCount(), 0);
+	std::fill_n(m_mask_data.begin(),  m_size.x * getPageCount(), 0);
+}
+
+const Vector2u& Sprite::getSize() const
+{
+	return m_size;
+}
+
+size_t Sprite::getPageCount() const
+{
+	return (m_size.y + 7) / 8;
+}
+
+bool Sprite::setPixel(const Vector2i& position, bool value)
+{
+	if (!(0 <= position.x && position.x < m_size.x && 0 <= position.y && position.y < m_size.y))
+		return false;
+	
+	auto byte = position.y / 8 * m_size.x + position.x;
+	auto bit = position.y % 8;
+	
+	(m_pixel_data[byte] &= ~(1 << bit)) |= (value << bit);
+	m_mask_data[byte] |= 1 << bit;
+	
+	return true;
+}
+
+void Sprite::fillColumn(int x, int top, int bottom, bool value)
+{
+	top = std::max(top, 0);
+	bottom = std::min<int>(bottom, m_size.y - 1);
+	
+	if (!(0 <= x && x < m_size.x) || top > bottom)
+		return;
+	
+	for (int page = top / 8; page <= bottom / 8; page++)
+	{
+		uint8_t mask = (0xFF << std::max(top - page * 8, 0)) & (0xFF >> (7 - std::min(bottom - page * 8, 7)));
+		
+		auto byte = page * m_size.x + x;
+		(m_pixel_data[byte] &= ~mask) |= value * mask;
+		m_mask_data[byte] |= mask;
+	}
+}
+
+const uint8_t* Sprite::getPixelData(size_t page) const
+{
+	return m_pixel_data.data() + page * m_size.x;
+}
+
+const uint8_t* Sprite::getMaskData(size_t page) const
+{
+	return m_mask_data.data() + page * m_size.x;
+}
+
+//========================================
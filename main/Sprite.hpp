@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <Vector.hpp>
+
+//========================================
+
+// 1 bpp image with transparency
+// Pixels are stored in the display page layout (one byte is a column of 8 pixels), so that sprites can be
+// copied to the display a byte at a time; pixels that have not been drawn since the last clear stay transparent
+// Storage is fixed to the size of the display RAM, so that sprites never touch the heap
+class Sprite
+{
+public:
+	Sprite() = default;
+	Sprite(const Sprite& copy) = delete;
+	
+	// Also makes the whole sprite transparent; the size is clamped to the storage
+	void resize(const Vector2u& size);
+	void clear();
+	
+	const Vector2u& getSize() const;
+	size_t getPageCount() const;
+	
+	bool setPixel(const Vector2i& position, bool value);
+	void fillColumn(int x, int top, int bottom, bool value);
+	
+	// Column bytes of the page, getSize().x each
+	const uint8_t* getPixelData(size_t page) const;
+	const uint8_t* getMaskData(size_t page) const;
+	
+private:
+	static constexpr size_t s_max_width = 132;
+	static constexpr size_t s_max_pages = 8;
+	
+	Vector2u m_size {};
+	
+	std::array<uint8_t, s_max_width * s_max_pages> m_pixel_data {};
+	std::array<uint8_t, s_max_width * s_max_pages> m_mask_data  {};
+	
+};
+
+//========================================
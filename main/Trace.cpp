@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cstdio>
+
+#include <Trace.hpp>
+
+#ifdef CONFIG_TRACE_ENABLED
+
+//========================================
+
+std::array<Trace::Ring, portNUM_PROCESSORS> Trace::s_rings {};
+std::atomic<bool> Trace::s_recording = true;
+
+static const char* ID_NAMES[Trace::IdCount] = {
+	"clock",
+	"frame",
+	"render",
+	"selector render",
+	"flush",
+	"flush page",
+	"sample",
+	"late sample",
+	"process",
+	"i2c read",
+	"i2c write"
+};
+
+// Linux target timestamps are already in microseconds
+#ifdef CONFIG_IDF_TARGET_LINUX
+	constexpr int CYCLES_PER_US = 1;
+#else
+	constexpr int CYCLES_PER_US = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+#endif
+
+//========================================
+
+// Dump format, one record per line:
+//     TRACE BEGIN <version> <core count> <cycles per us>
+//     TRACE NAME <id> <name>
+//     TRACE CORE <core>
+//     TRACE DATA <hex of raw events, oldest first>
+//     TRACE END
+void Trace::Freeze()
+{
+	if (!s_recording.exchange(false))
+		return;
+	
+	printf("TRACE BEGIN 1 %d %d\n", portNUM_PROCESSORS, CYCLES_PER_US);
+	for (size_t id = 0; id < IdCount; id++)
+		printf("TRACE NAME %zu %s\n", id, ID_NAMES[id]);
+	
+	constexpr size_t events_per_line = 8;
+	for (size_t core = 0; core < s_rings.size(); core++)
+	{
+		const auto& ring = s_rings[core];
+		
+		uint32_t head = ring.head.load();
+		uint32_t count = std::min<uint32_t>(head, s_capacity);
+		
+		printf("TRACE CORE %zu\n", core);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (i % events_per_line == 0)
+				printf(i? "\nTRACE DATA ": "TRACE DATA ");
+			
+			const auto* bytes = reinterpret_cast<const uint8_t*>(&ring.events[(head - count + i) & (s_capacity - 1)]);
+			for (size_t byte = 0; byte < sizeof(Event); byte++)
+				printf("%02x", bytes[byte]);
+		}
+		
+		if (count)
+			printf("\n");
+	}
+	
+	printf("TRACE END\n");
+	fflush(stdout);
+}
+
+void Trace::Start()
+{
+	s_recording = true;
+}
+
+bool Trace::IsRecording()
+{
+	return s_recording;
+}
+
+//========================================
+
+#endif
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_timer.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+	#include "esp_cpu.h"
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//========================================
+
+// Event trace recorder
+// Events are appended to the ring buffer of the core they happen on; recording one is an atomic increment
+// and a few stores, so the recorder stays compiled in. Timestamps are CPU cycles, which are local to each core,
+// so every core records sync events pairing its cycle counter with esp_timer time every now and then.
+// Frozen buffers are dumped to the console and converted with tools/trace2chrome.py
+class Trace
+{
+public:
+	enum Type: uint8_t
+	{
+		Begin,
+		End,
+		Instant,
+		Sync
+	};
+	
+	// Names are listed in Trace.cpp
+	enum Id: uint8_t
+	{
+		Clock,
+		Frame,
+		Render,
+		SelectorRender,
+		Flush,
+		FlushPage,
+		Sample,
+		LateSample,
+		Process,
+		I2CRead,
+		I2CWrite,
+		
+		IdCount
+	};
+	
+	struct Event
+	{
+		uint32_t cycles;
+		uint32_t arg;
+		Type     type;
+		Id       id;
+		uint16_t reserved;
+	};
+	
+	static_assert(sizeof(Event) == 12);
+	
+	class Scope
+	{
+	public:
+		explicit Scope(Id id, uint32_t arg = 0):
+			m_id(id)
+		{
+			Record(Begin, id, arg);
+		}
+		
+		Scope(const Scope& copy) = delete;
+		
+		~Scope()
+		{
+			Record(End, m_id);
+		}
+		
+	private:
+		Id m_id;
+		
+	};
+	
+	Trace() = delete;
+	
+	static void Record(Type type, Id id, uint32_t arg = 0);
+	
+	// Pairs esp_timer time with the cycle counter of the calling core, has to be called on each core at least every few seconds
+	static void Synchronize();
+	
+	// Stops recording and prints contents of the buffers to the console
+	static void Freeze();
+	static void Start();
+	static bool IsRecording();
+	
+private:
+	#ifdef CONFIG_TRACE_ENABLED
+		static constexpr size_t s_capacity = CONFIG_TRACE_BUFFER_EVENTS;
+		static_assert((s_capacity & (s_capacity - 1)) == 0, "trace buffer size must be a power of two");
+		
+		struct Ring
+		{
+			std::atomic<uint32_t>         head;
+			std::array<Event, s_capacity> events;
+		};
+		
+		static std::array<Ring, portNUM_PROCESSORS> s_rings;
+		static std::atomic<bool> s_recording;
+	#endif
+	
+};
+
+//========================================
+
+#ifdef CONFIG_TRACE_ENABLED
+
+inline void Trace::Record(Type type, Id id, uint32_t arg /*= 0*/)
+{
+	if (!s_recording.load(std::memory_order_relaxed))
+		return;
+	
+	#ifdef CONFIG_IDF_TARGET_LINUX
+		auto& ring = s_rings[0];
+		uint32_t cycles = esp_timer_get_time();
+	#else
+		auto& ring = s_rings[esp_cpu_get_core_id()];
+		uint32_t cycles = esp_cpu_get_cycle_count();
+	#endif
+	
+	auto& event = ring.events[ring.head.fetch_add(1, std::memory_order_relaxed) & (s_capacity - 1)];
+	event.cycles = cycles;
+	event.arg = arg;
+	event.type = type;
+	event.id = id;
+}
+
+inline void Trace::Synchronize()
+{
+	Record(Sync, Clock, esp_timer_get_time());
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+
+#define TRACE_BEGIN(id, ...)   Trace::Record(Trace::Begin,   Trace::id __VA_OPT__(,) __VA_ARGS__)
+#define TRACE_END(id)          Trace::Record(Trace::End,     Trace::id)
+#define TRACE_INSTANT(id, ...) Trace::Record(Trace::Instant, Trace::id __VA_OPT__(,) __VA_ARGS__)
+#define TRACE_SCOPE(id, ...)   Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(Trace::id __VA_OPT__(,) __VA_ARGS__)
+#define TRACE_SYNC()           Trace::Synchronize()
+
+#else
+
+inline void Trace::Record(Type /*type*/, Id /*id*/, uint32_t /*arg = 0*/) {}
+inline void Trace::Synchronize() {}
+inline void Trace::Freeze() {}
+inline void Trace::Start() {}
+inline bool Trace::IsRecording() { return false; }
+
+#define TRACE_BEGIN(id, ...)   do {} while (false)
+#define TRACE_END(id)          do {} while (false)
+#define TRACE_INSTANT(id, ...) do {} while (false)
+#define TRACE_SCOPE(id, ...)   do {} while (false)
+#define TRACE_SYNC()           do {} while (false)
+
+#endif
+
+//========================================
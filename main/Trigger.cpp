@@ -0,0 +1,139 @@
+#include <Trigger.hpp>
+
+//========================================
+
+void Trigger::setup(const Config& config)
+{
+	m_config = config;
+	
+	m_position = 0;
+	m_last_edge = 0;
+	m_edge_seen = false;
+	m_level = false;
+	m_region = Below;
+	m_runt = false;
+	
+	for (auto& count: m_counts)
+		count.store(0, std::memory_order_relaxed);
+	
+	for (auto& time: m_last_times)
+		time.store(0, std::memory_order_relaxed);
+}
+
+// Level and region changes are rare, so the common path is a couple of compares and an increment
+uint32_t Trigger::process(Sample sample, int64_t time_us)
+{
+	m_position++;
+	
+	auto region = static_cast<Region>((sample >= m_config.low) + (sample > m_config.high));
+	bool level = region == Above || (region == Between && m_level);
+	
+	uint32_t fired = 0;
+	if (region != m_region) [[unlikely]]
+	{
+		fired |= onRegion(region);
+		m_region = region;
+	}
+	
+	if (level != m_level) [[unlikely]]
+	{
+		fired |= onEdge(level);
+		m_level = level;
+	}
+	
+	if (m_config.timeout && m_position - m_last_edge == m_config.timeout)
+		fired |= 1 << Dropout;
+	
+	return fired? fire(fired, time_us): 0;
+}
+
+uint32_t Trigger::getCount(Type type) const
+{
+	return m_counts[type].load(std::memory_order_relaxed);
+}
+
+int64_t Trigger::getLastTime(Type type) const
+{
+	return m_last_times[type].load(std::memory_order_relaxed);
+}
+
+uint32_t Trigger::onEdge(bool level)
+{
+	uint32_t width = m_position - m_last_edge;
+	bool had_edge = m_edge_seen;
+	
+	m_last_edge = m_position;
+	m_edge_seen = true;
+	
+	uint32_t fired = 0;
+	if (level == m_config.rising)
+		fired |= 1 << Edge;
+	
+	// Pulse that just ended is only complete if its leading edge was seen
+	if (!had_edge)
+		return fired;
+	
+	if (width < m_config.width)
+		fired |= 1 << Glitch;
+	
+	// Trailing edge of a pulse of the slope polarity
+	if (level != m_config.rising)
+	{
+		bool matches = false;
+		switch (m_config.condition)
+		{
+			case Condition::Less:
+				matches = width < m_config.width;
+				break;
+			
+			case Condition::Greater:
+				matches = width > m_config.width;
+				break;
+			
+			case Condition::Within:
+				matches = m_config.width <= width && width <= m_config.width_max;
+				break;
+		
+		}
+		
+		fired |= matches << Width;
+	}
+	
+	return fired;
+}
+
+uint32_t Trigger::onRegion(Region region)
+{
+	Region near = m_config.rising? Below: Above;
+	Region far = m_config.rising? Above: Below;
+	
+	if (m_region == near && region == Between)
+		m_runt = true;
+	
+	else if (region == far)
+		m_runt = false;
+	
+	else if (region == near && m_runt)
+	{
+		m_runt = false;
+		return 1 << Runt;
+	}
+	
+	return 0;
+}
+
+uint32_t Trigger::fire(uint32_t types, int64_t time_us)
+{
+	for (uint8_t type = 0; type < TypeCount; type++)
+	{
+		if (!(types >> type & 1))
+			continue;
+		
+		m_counts[type].store(m_counts[type].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		m_last_times[type].store(time_us, std::memory_order_relaxed);
+	}
+	
+	return types;
+}
+
+//========================================
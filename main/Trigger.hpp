@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <Sample.hpp>
+
+//========================================
+
+// Trigger state machine evaluated on every acquired sample in integer math
+// All the detectors run at once sharing the thresholds, so that every one of them keeps counting whichever
+// is used to capture; the signal is low below the low threshold, high above the high one and keeps its
+// level in between, runts are pulses crossing the first threshold but not the second
+class Trigger
+{
+public:
+	enum Type: uint8_t
+	{
+		Edge,    // Edge of the slope
+		Width,   // Pulse of the slope polarity with width matching the condition, fires at its end
+		Runt,    // Pulse of the slope polarity not reaching the far threshold, fires once back
+		Glitch,  // Pulse of either polarity narrower than the width
+		Dropout, // No edge for the timeout, fires once per dropout
+		
+		TypeCount
+	};
+	
+	enum class Condition: uint8_t
+	{
+		Less,    // Narrower than the width
+		Greater, // Wider than the width
+		Within   // Between the width and the maximum width
+	};
+	
+	struct Config
+	{
+		Sample    low;
+		Sample    high;
+		bool      rising;    // Slope of the edge and leading edge of pulses and runts
+		Condition condition;
+		uint32_t  width;     // Widths and timeout are in samples
+		uint32_t  width_max;
+		uint32_t  timeout;
+	};
+	
+	Trigger() = default;
+	Trigger(const Trigger& copy) = delete;
+	
+	// Resets the state and the counters
+	void setup(const Config& config);
+	
+	// Returns a mask of the types fired by the sample
+	uint32_t process(Sample sample, int64_t time_us);
+	
+	uint32_t getCount(Type type) const;
+	int64_t getLastTime(Type type) const;
+	
+private:
+	enum Region: uint8_t
+	{
+		Below,
+		Between,
+		Above
+	};
+	
+	Config m_config {};
+	
+	uint32_t m_position  = 0; // Samples processed
+	uint32_t m_last_edge = 0;
+	bool     m_edge_seen = false;
+	bool     m_level     = false;
+	Region   m_region    = Below;
+	bool     m_runt      = false; // Leading threshold was crossed coming from the far side
+	
+	std::array<std::atomic<uint32_t>, TypeCount> m_counts     {};
+	std::array<std::atomic<int64_t>,  TypeCount> m_last_times {};
+	
+	uint32_t onEdge(bool level);
+	uint32_t onRegion(Region region);
+	uint32_t fire(uint32_t types, int64_t time_us);
+	
+};
+
+//========================================
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+//========================================
+
+// Failed checks are reported and counted, a test keeps going and fails at the end if any did
+
+inline int s_failures = 0;
+
+#define CHECK(condition)                                                          \
+	do                                                                            \
+	{                                                                             \
+		if (!(condition))                                                         \
+		{                                                                         \
+			fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+			s_failures++;                                                         \
+		}                                                                         \
+	}                                                                             \
+	while (false)
+
+#define CHECK_NEAR(value, expected, tolerance) CHECK(std::abs((value) - (expected)) <= (tolerance))
+
+// Exit code of the test
+inline int Finish()
+{
+	if (s_failures)
+		fprintf(stderr, "%d checks failed\n", s_failures);
+	
+	return s_failures? EXIT_FAILURE: EXIT_SUCCESS;
+}
+
+//========================================
@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <algorithm>
+
+#include <CicDecimator.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+static CicDecimator s_decimator;
+
+// Feeds a decimation worth of inputs, returns whether it ended with an output
+static bool AddOutput(uint32_t input)
+{
+	bool output = false;
+	for (uint32_t i = 0; i < s_decimator.getDecimation(); i++)
+		output = s_decimator.add(input);
+	
+	return output;
+}
+
+//========================================
+
+int main()
+{
+	constexpr int32_t one = 1 << CicDecimator::s_fraction_bits;
+	
+	for (uint32_t decimation: { 1u, 16u, 64u, CicDecimator::s_max_decimation })
+	{
+		s_decimator.setup(decimation);
+		CHECK(s_decimator.getDecimation() == decimation);
+		
+		// Outputs are held back until every comb stage has seen a whole decimation, then start at the input level
+		for (size_t output = 0; output < CicDecimator::s_stages; output++)
+			CHECK(!AddOutput(4000));
+		
+		CHECK(AddOutput(4000));
+		CHECK(s_decimator.getOutput() == 4000 * one);
+		
+		// DC gain is exactly one, a step settles within the combs and the compensation filter
+		CHECK(AddOutput(4000));
+		CHECK(s_decimator.getOutput() == 4000 * one);
+		
+		int32_t peak = 0;
+		for (size_t output = 0; output < CicDecimator::s_stages + 2; output++)
+		{
+			CHECK(AddOutput(1000));
+			peak = std::max(peak, s_decimator.getOutput());
+		}
+		
+		// Sharpening overshoots by 3/16 of the step at most
+		CHECK(s_decimator.getOutput() == 1000 * one);
+		CHECK(peak <= 4000 * one + 3 * 3000 * one / 16);
+		
+		for (int output = 0; output < 10; output++)
+		{
+			CHECK(AddOutput(1000));
+			CHECK(s_decimator.getOutput() == 1000 * one);
+		}
+	}
+	
+	CHECK(s_decimator.getDecimation() == CicDecimator::s_max_decimation);
+	s_decimator.setup(10'000);
+	CHECK(s_decimator.getDecimation() == CicDecimator::s_max_decimation);
+	
+	// Noise averages down, the mean keeps the fraction the input codes can't hold
+	{
+		s_decimator.setup(64);
+		
+		std::mt19937 random(1);
+		std::normal_distribution<double> noise(0, 2);
+		
+		double sum = 0;
+		double square_sum = 0;
+		int count = 0;
+		while (count < 2000)
+		{
+			if (!s_decimator.add(std::lround(2000.37 + noise(random))))
+				continue;
+			
+			double output = s_decimator.getOutput() / static_cast<double>(one);
+			sum += output;
+			square_sum += output * output;
+			count++;
+		}
+		
+		double mean = sum / count;
+		double deviation = std::sqrt(square_sum / count - mean * mean);
+		printf("decimation 64: mean %.3f, deviation %.3f codes\n", mean, deviation);
+		
+		CHECK_NEAR(mean, 2000.37, .05);
+		CHECK(deviation < .5);
+	}
+	
+	// Compensation keeps the passband flat up to a quarter of the output rate, where three stages droop by 2 dB
+	{
+		constexpr uint32_t decimation = 16;
+		s_decimator.setup(decimation);
+		
+		double amplitude = 0;
+		for (uint32_t i = 0; i < decimation * 4'000; i++)
+		{
+			double input = 2048 + 1000 * std::sin(2 * std::numbers::pi * i / (decimation * 4.37));
+			if (s_decimator.add(std::lround(input)) && i > decimation * 100)
+				amplitude = std::max(amplitude, std::abs(s_decimator.getOutput() / static_cast<double>(one) - 2048));
+		}
+		
+		printf("gain at a quarter of the output rate %.3f\n", amplitude / 1000);
+		CHECK_NEAR(amplitude / 1000, 1., .05);
+	}
+	
+	return Finish();
+}
+
+//========================================
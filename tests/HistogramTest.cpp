@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+
+#include <Histogram.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+static Histogram s_histogram;
+
+//========================================
+
+int main()
+{
+	Histogram::Result result;
+	Histogram::Statistics statistics;
+	
+	// Every code of 64 bins 10 codes wide the same number of times, the percentiles fall where their share of codes ends
+	constexpr int repeats = 10;
+	s_histogram.setup({ 0, 640, 640 * repeats });
+	
+	CHECK(!s_histogram.getResult(&result));
+	
+	for (int repeat = 0; repeat < repeats; repeat++)
+		for (Sample sample = 0; sample < 640; sample++)
+			s_histogram.add(sample);
+	
+	CHECK(s_histogram.getResult(&result));
+	CHECK(result.complete);
+	CHECK(result.count == 640 * repeats);
+	CHECK(result.bin_width == 10);
+	CHECK(result.below == 0 && result.above == 0);
+	
+	for (auto count: result.bins)
+		CHECK(count == 10 * repeats);
+	
+	// Bins span half a code past their outer codes
+	CHECK(Histogram::GetStatistics(result, &statistics));
+	CHECK_NEAR(statistics.mean, 319.5f, .01f);
+	CHECK_NEAR(statistics.median, 319.5f, .01f);
+	CHECK_NEAR(statistics.low_percentile, -.5f + 6.4f, .01f);
+	CHECK_NEAR(statistics.high_percentile, -.5f + 633.6f, .01f);
+	CHECK_NEAR(statistics.deviation, 640 / std::sqrt(12.f), 1.f);
+	
+	// Samples out of range are counted apart, statistics only cover the ones in range
+	s_histogram.setup({ 100, 164, 4 });
+	for (Sample sample: { 99, 100, 163, 165 })
+		s_histogram.add(sample);
+	
+	CHECK(s_histogram.getResult(&result));
+	CHECK(result.below == 1 && result.above == 1);
+	CHECK(result.bins.front() == 1 && result.bins.back() == 1);
+	
+	CHECK(Histogram::GetStatistics(result, &statistics));
+	CHECK_NEAR(statistics.mean, 131.5f, .01f);
+	
+	s_histogram.setup({ 100, 164, 2 });
+	s_histogram.add(0);
+	s_histogram.add(1000);
+	CHECK(s_histogram.getResult(&result));
+	CHECK(!Histogram::GetStatistics(result, &statistics));
+	
+	// Noise around a level
+	{
+		s_histogram.setup({ 3900, 4100, 0 });
+		
+		std::mt19937 random(1);
+		std::normal_distribution<double> noise(4000, 10);
+		for (int i = 0; i < 100'000; i++)
+			s_histogram.add(std::lround(noise(random)));
+		
+		CHECK(s_histogram.getResult(&result));
+		CHECK(!result.complete);
+		CHECK(Histogram::GetStatistics(result, &statistics));
+		
+		printf(
+			"noise: mean %.2f deviation %.2f median %.2f 1%% %.2f 99%% %.2f\n",
+			statistics.mean,
+			statistics.deviation,
+			statistics.median,
+			statistics.low_percentile,
+			statistics.high_percentile
+		);
+		
+		// Bins are 4 codes wide, which adds their width squared over 12 to the variance
+		CHECK_NEAR(statistics.mean, 4000.f, .5f);
+		CHECK_NEAR(statistics.median, 4000.f, .5f);
+		CHECK_NEAR(statistics.deviation, std::sqrt(100.f + 16.f / 12), .3f);
+		CHECK_NEAR(statistics.low_percentile, 4000 - 23.26f, 1.f);
+		CHECK_NEAR(statistics.high_percentile, 4000 + 23.26f, 1.f);
+	}
+	
+	// Running result is published every now and then until the first complete one
+	s_histogram.setup({ 0, 64, 5000 });
+	for (int i = 0; i < 1023; i++)
+		s_histogram.add(1);
+	
+	CHECK(s_histogram.getResultCount() == 0);
+	
+	s_histogram.add(1);
+	CHECK(s_histogram.getResultCount() == 1);
+	CHECK(s_histogram.getResult(&result));
+	CHECK(!result.complete && result.count == 1024);
+	
+	return Finish();
+}
+
+//========================================
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cmath>
+#include <numbers>
+
+#include <LimitTest.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+static LimitTest s_limit_test;
+
+// Sine of a period that does not divide the mask length, offsets count from the rising zero crossing
+static Sample GetSine(size_t offset, size_t period)
+{
+	return std::lround(1000 * std::sin(2 * std::numbers::pi * (offset % period) / period));
+}
+
+//========================================
+
+int main()
+{
+	// Band, both limits included
+	s_limit_test.setBand(-100, 100);
+	for (Sample sample: { -100, 0, 100, 101, -101 })
+		s_limit_test.check(sample, 0, 0);
+	
+	CHECK(s_limit_test.getCheckedCount() == 5);
+	CHECK(s_limit_test.getViolationCount() == 2);
+	
+	// Mask learned over triggers repeating faster than its length, checked in phase and half a period off
+	constexpr size_t length = 1000;
+	constexpr size_t period = 333;
+	
+	s_limit_test.startMask(length);
+	for (size_t i = 0; i < length; i++)
+		s_limit_test.learn(GetSine(i, period), i % period);
+	
+	s_limit_test.finishMask(5);
+	CHECK(s_limit_test.getCheckedCount() == 0);
+	
+	for (size_t i = 0; i < 100 * period; i++)
+		s_limit_test.check(GetSine(i, period), i % period, i);
+	
+	CHECK(s_limit_test.getCheckedCount() == 100 * period);
+	CHECK(s_limit_test.getViolationCount() == 0);
+	
+	for (size_t i = 0; i < period; i++)
+		s_limit_test.check(GetSine(i + period / 2, period), i % period, i);
+	
+	CHECK(s_limit_test.getViolationCount() > period / 2);
+	
+	// Column of an offset is its share of the mask length, columns nothing was learned into take the one before
+	s_limit_test.startMask(LimitTest::s_columns * 2);
+	s_limit_test.learn(0, 0);
+	s_limit_test.learn(500, 20);
+	s_limit_test.finishMask(0);
+	
+	s_limit_test.check(0, 1, 0);     // Column 0
+	s_limit_test.check(0, 19, 0);    // Column 9, took column 0
+	s_limit_test.check(500, 21, 0);  // Column 10
+	s_limit_test.check(500, 255, 0); // Last column, took column 10
+	CHECK(s_limit_test.getViolationCount() == 0);
+	
+	s_limit_test.check(500, 2, 0);
+	s_limit_test.check(0, 20, 0);
+	CHECK(s_limit_test.getViolationCount() == 2);
+	
+	// Snippets hold the samples preceding the violation, the violating one and the ones following it
+	s_limit_test.setBand(-100, 100);
+	
+	constexpr size_t spacing = LimitTest::s_snippet_size * 2;
+	constexpr uint32_t violation_count = LimitTest::s_snippet_count + 2;
+	for (size_t i = 0; i < violation_count * spacing; i++)
+	{
+		bool violating = i % spacing == spacing / 2;
+		s_limit_test.check(violating? 1000 + i / spacing: i % 50, 0, i);
+	}
+	
+	CHECK(s_limit_test.getViolationCount() == violation_count);
+	CHECK(s_limit_test.getSnippetCount() == violation_count);
+	CHECK(s_limit_test.getFirstViolationTime() == spacing / 2);
+	CHECK(s_limit_test.getLastViolationTime() == (violation_count - 1) * spacing + spacing / 2);
+	
+	// Ring keeps the most recent ones only, the slot of the oldest one is given to the next snippet
+	constexpr uint32_t first_kept = violation_count - (LimitTest::s_snippet_count - 1);
+	
+	LimitTest::Snippet snippet;
+	for (uint32_t number = 0; number < first_kept; number++)
+		CHECK(!s_limit_test.getSnippet(number, &snippet));
+	
+	for (uint32_t number = first_kept; number < violation_count; number++)
+	{
+		size_t time = number * spacing + spacing / 2;
+		
+		CHECK(s_limit_test.getSnippet(number, &snippet));
+		CHECK(snippet.violation == number);
+		CHECK(snippet.time_us == static_cast<int64_t>(time));
+		
+		size_t violating = LimitTest::s_snippet_size / 2 - 1;
+		CHECK(snippet.samples[violating] == static_cast<Sample>(1000 + number));
+		CHECK(snippet.samples.front() == static_cast<Sample>((time - violating) % 50));
+		CHECK(snippet.samples[violating - 1] == static_cast<Sample>((time - 1) % 50));
+		CHECK(snippet.samples[violating + 1] == static_cast<Sample>((time + 1) % 50));
+		CHECK(snippet.samples.back() == static_cast<Sample>((time + LimitTest::s_snippet_size / 2) % 50));
+	}
+	
+	CHECK(!s_limit_test.getSnippet(violation_count, &snippet));
+	
+	return Finish();
+}
+
+//========================================
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+
+#include <LogicAnalyzer.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+static LogicAnalyzer s_logic;
+
+// 8N1 line at a bit time that is not a whole number of samples, idle high before, between and after the bytes
+class UartLine
+{
+public:
+	UartLine(double bit_time): m_bit_time(bit_time)
+	{
+		hold(true, 20);
+	}
+	
+	void send(uint8_t value, bool stop = true)
+	{
+		hold(false, 1);
+		for (int bit = 0; bit < 8; bit++)
+			hold(value >> bit & 1, 1);
+		
+		hold(stop, 1);
+		hold(true, 3);
+	}
+	
+	// Copied into a ring buffer which starts with the given oldest sample
+	std::vector<Sample> getRing(size_t oldest)
+	{
+		hold(true, 30);
+		
+		std::vector<Sample> ring(m_samples.size());
+		for (size_t i = 0; i < m_samples.size(); i++)
+			ring[(oldest + i) % ring.size()] = m_samples[i];
+		
+		return ring;
+	}
+	
+private:
+	double m_bit_time;
+	double m_time = 0;
+	std::vector<Sample> m_samples;
+	
+	void hold(bool level, double bits)
+	{
+		m_time += bits * m_bit_time;
+		while (m_samples.size() < m_time)
+			m_samples.push_back(level? 1000: 0);
+	}
+	
+};
+
+//========================================
+
+int main()
+{
+	std::array<LogicAnalyzer::Byte, 16> bytes;
+	
+	// 2400 baud at 25 kS/s, bytes with long runs of equal bits included
+	{
+		constexpr double bit_time = 25'000 / 2400.;
+		constexpr uint8_t text[] = { 'H', 'i', '!', 0x55, 0x00, 0xff };
+		
+		UartLine line(bit_time);
+		for (uint8_t value: text)
+			line.send(value);
+		
+		constexpr size_t oldest = 137;
+		auto ring = line.getRing(oldest);
+		s_logic.capture(ring, oldest, 400, 600);
+		
+		CHECK(s_logic.getSampleCount() == ring.size());
+		CHECK(s_logic.getInitialLevel());
+		CHECK(!s_logic.isTruncated());
+		CHECK_NEAR(s_logic.getBitTime() / 65536., bit_time, .05);
+		
+		size_t count = s_logic.decodeUart(bytes);
+		CHECK(count == std::size(text));
+		
+		for (size_t i = 0; i < std::min(count, std::size(text)); i++)
+		{
+			CHECK(bytes[i].value == text[i]);
+			CHECK(!bytes[i].framing_error);
+			
+			// Start bit edge of byte i, after the idle time and 13 bits per preceding byte
+			CHECK_NEAR(static_cast<double>(bytes[i].position), 20 * bit_time + i * 13 * bit_time, 1.);
+		}
+	}
+	
+	// Low stop bit is a framing error, the byte is still decoded
+	{
+		UartLine line(10);
+		line.send(0x41, false);
+		line.send(0x5a);
+		
+		auto ring = line.getRing(0);
+		s_logic.capture(ring, 0, 400, 600);
+		
+		size_t count = s_logic.decodeUart(bytes);
+		CHECK(count == 2);
+		CHECK(bytes[0].value == 0x41 && bytes[0].framing_error);
+		CHECK(bytes[1].value == 0x5a && !bytes[1].framing_error);
+	}
+	
+	// Samples between the thresholds keep the level
+	{
+		std::vector<Sample> samples(100, 0);
+		samples[40] = samples[41] = 550;
+		samples[60] = 1000;
+		samples[61] = 550;
+		
+		s_logic.capture(samples, 0, 400, 600);
+		
+		auto edges = s_logic.getEdges();
+		CHECK(edges.size() == 2 && edges[0] == 60 && edges[1] == 62);
+		CHECK(!s_logic.getLevel(41) && s_logic.getLevel(61) && !s_logic.getLevel(62));
+	}
+	
+	// PWM of 250 samples at 30% duty
+	{
+		std::vector<Sample> samples(5'000);
+		for (size_t i = 0; i < samples.size(); i++)
+			samples[i] = i % 250 < 75? 900: 100;
+		
+		s_logic.capture(samples, 0, 400, 600);
+		
+		auto pulses = s_logic.decodePulses();
+		CHECK(pulses.count >= 18);
+		CHECK(pulses.period == 250);
+		CHECK(pulses.width == 75);
+	}
+	
+	return Finish();
+}
+
+//========================================
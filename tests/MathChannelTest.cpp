@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+#include <MathChannel.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+// Processes a whole window in blocks the size the processing loop uses, starting a new sweep first
+static void Sweep(MathChannel& math, const std::vector<Sample>& a, const std::vector<Sample>& b, std::vector<Sample>& output)
+{
+	constexpr size_t block_size = 32;
+	
+	math.startSweep();
+	for (size_t begin = 0; begin < a.size(); begin += block_size)
+	{
+		size_t length = std::min(block_size, a.size() - begin);
+		math.process(
+			std::span(a).subspan(begin, length),
+			b.empty()? std::span<const Sample>(): std::span<const Sample>(b).subspan(begin, length),
+			std::span(output).subspan(begin, length)
+		);
+	}
+}
+
+//========================================
+
+int main()
+{
+	MathChannel math;
+	
+	// 5 V on the bus voltage LSB for a second integrates to 5 V*s, whatever the window
+	for (size_t window: { 10, 1'000, 25'000 })
+	{
+		constexpr int rate = 1'000;
+		constexpr double lsb = .00125;
+		
+		math.setup(MathChannel::Operation::Integral, lsb, 0, rate, window);
+		
+		std::vector<Sample> output(window);
+		Sweep(math, std::vector<Sample>(window, 4000), {}, output);
+		
+		double expected = 4000 * lsb * window / rate;
+		CHECK_NEAR(output.back() * math.getLSB(), expected, expected * .001 + math.getLSB());
+		printf("integral over %6zu samples %.4f V*s, %.4f expected\n", window, output.back() * math.getLSB(), expected);
+		
+		// Full scale either way over the whole window fits, so the integral keeps rising to its end rather than saturating
+		for (Sample level: { std::numeric_limits<Sample>::max(), std::numeric_limits<Sample>::min() })
+		{
+			Sweep(math, std::vector<Sample>(window, level), {}, output);
+			
+			double end = output.back() * math.getLSB();
+			double middle = output[window / 2 - 1] * math.getLSB();
+			CHECK_NEAR(middle, end / 2, std::abs(end) * .01 + math.getLSB());
+			CHECK(std::abs(output.back()) > std::numeric_limits<Sample>::max() / 4);
+		}
+	}
+	
+	// Every sweep starts over from zero, so the same input gives the same output
+	{
+		std::vector<Sample> a(1'000);
+		for (size_t i = 0; i < a.size(); i++)
+			a[i] = std::lround(1000 * std::sin(2 * std::numbers::pi * i / 300));
+		
+		math.setup(MathChannel::Operation::Integral, .0001, 0, 25'000, a.size());
+		
+		std::vector<Sample> first(a.size());
+		std::vector<Sample> second(a.size());
+		Sweep(math, a, {}, first);
+		Sweep(math, a, {}, second);
+		
+		CHECK(first == second);
+		
+		// Not starting over carries the integral of the previous sweep along
+		math.process(a, {}, second);
+		CHECK(first != second);
+	}
+	
+	// Difference brings both channels to the coarser LSB
+	{
+		math.setup(MathChannel::Operation::Difference, .00125, .0025, 25'000, 1);
+		
+		std::vector<Sample> output(1);
+		math.process(std::vector<Sample> { 4000 }, std::vector<Sample> { 1000 }, output);
+		CHECK(math.getLSB() == .0025);
+		CHECK_NEAR(output[0] * math.getLSB(), 4000 * .00125 - 1000 * .0025, math.getLSB());
+	}
+	
+	// Product of two 1 V samples
+	{
+		math.setup(MathChannel::Operation::Product, .0001, .0001, 25'000, 1);
+		
+		std::vector<Sample> output(1);
+		math.process(std::vector<Sample> { 10'000 }, std::vector<Sample> { 10'000 }, output);
+		CHECK_NEAR(output[0] * math.getLSB(), 1., math.getLSB());
+	}
+	
+	// Ramp of 1 V/s at 1 kHz, the first sample has nothing to be compared to
+	{
+		math.setup(MathChannel::Operation::Derivative, .0001, 0, 1'000, 4);
+		
+		std::vector<Sample> output(4);
+		math.process(std::vector<Sample> { 0, 10, 20, 30 }, {}, output);
+		CHECK(output[0] == 0);
+		CHECK_NEAR(output[3] * math.getLSB(), 1., 1e-9);
+	}
+	
+	return Finish();
+}
+
+//========================================
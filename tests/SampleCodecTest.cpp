@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include <SampleCodec.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+// Encodes and decodes back, returns the encoded size
+static size_t RoundTrip(const char* name, const std::vector<Sample>& samples)
+{
+	std::vector<uint8_t> encoded(SampleCodec::GetMaxEncodedSize(samples.size()));
+	size_t size = 0;
+	CHECK(SampleCodec::Encode(samples, encoded, &size));
+	CHECK(size <= encoded.size());
+	
+	std::vector<Sample> decoded(samples.size() + 1);
+	size_t count = SampleCodec::Decode(std::span(encoded).first(size), decoded);
+	decoded.resize(count);
+	CHECK(decoded == samples);
+	
+	printf(
+		"%-24s %6zu samples %7zu bytes %5.2fx\n",
+		name,
+		samples.size(),
+		size,
+		size? samples.size() * sizeof(Sample) / static_cast<double>(size): 0
+	);
+	
+	return size;
+}
+
+//========================================
+
+int main()
+{
+	constexpr size_t count = 10 * SampleCodec::BlockSize + 17;
+	
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> full_range(std::numeric_limits<Sample>::min(), std::numeric_limits<Sample>::max());
+	std::normal_distribution<double> noise(0, 2);
+	
+	CHECK(RoundTrip("empty", {}) == 0);
+	RoundTrip("single", { -1234 });
+	RoundTrip("constant", std::vector<Sample>(count, 4000));
+	
+	std::vector<Sample> samples(count);
+	for (auto& sample: samples)
+		sample = full_range(random);
+	
+	RoundTrip("random", samples);
+	
+	// Every delta is as large as it gets, either way
+	for (size_t i = 0; i < count; i++)
+		samples[i] = i & 1? std::numeric_limits<Sample>::max(): std::numeric_limits<Sample>::min();
+	
+	RoundTrip("full scale steps", samples);
+	
+	for (size_t i = 0; i < count; i++)
+		samples[i] = i < count / 2? std::numeric_limits<Sample>::min(): std::numeric_limits<Sample>::max();
+	
+	RoundTrip("full scale step", samples);
+	
+	// 5 V rail in bus voltage codes with a little ripple and noise, the case the codec is tuned for
+	for (size_t i = 0; i < count; i++)
+		samples[i] = std::lround(4000 + 3 * std::sin(2 * std::numbers::pi * i / 500) + noise(random));
+	
+	size_t rail_size = RoundTrip("rail", samples);
+	CHECK(samples.size() * sizeof(Sample) >= 4 * rail_size);
+	
+	// Too small output is told apart from empty input, at every size short of the needed one
+	std::vector<uint8_t> encoded(SampleCodec::GetMaxEncodedSize(samples.size()));
+	for (size_t available = 0; available < rail_size; available++)
+	{
+		size_t size = 0;
+		CHECK(!SampleCodec::Encode(samples, std::span(encoded).first(available), &size));
+	}
+	
+	// Truncated input decodes up to the last whole block
+	size_t size = 0;
+	CHECK(SampleCodec::Encode(samples, encoded, &size));
+	
+	std::vector<Sample> decoded(samples.size());
+	size_t decoded_count = SampleCodec::Decode(std::span(encoded).first(size - 1), decoded);
+	CHECK(decoded_count == samples.size() / SampleCodec::BlockSize * SampleCodec::BlockSize);
+	CHECK(std::equal(decoded.begin(), decoded.begin() + decoded_count, samples.begin()));
+	
+	return Finish();
+}
+
+//========================================
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <Trigger.hpp>
+
+#include <Check.hpp>
+
+//========================================
+
+static Trigger s_trigger;
+
+// Levels held for a number of samples each
+static std::vector<Sample> MakeSignal(std::initializer_list<std::pair<Sample, int>> levels)
+{
+	std::vector<Sample> signal;
+	for (auto [level, length]: levels)
+		signal.insert(signal.end(), length, level);
+	
+	return signal;
+}
+
+// Sample index is the time, checks that the type fires exactly once at the expected sample and returns the types fired
+static uint32_t Run(const Trigger::Config& config, const std::vector<Sample>& signal, Trigger::Type type, int64_t expected)
+{
+	s_trigger.setup(config);
+	
+	uint32_t fired = 0;
+	for (size_t i = 0; i < signal.size(); i++)
+	{
+		uint32_t types = s_trigger.process(signal[i], i);
+		if (types >> type & 1)
+			CHECK(static_cast<int64_t>(i) == expected);
+		
+		fired |= types;
+	}
+	
+	CHECK(s_trigger.getCount(type) == 1);
+	CHECK(s_trigger.getLastTime(type) == expected);
+	
+	return fired;
+}
+
+//========================================
+
+int main()
+{
+	Trigger::Config config = {};
+	config.low = 300;
+	config.high = 700;
+	config.rising = true;
+	config.condition = Trigger::Condition::Greater;
+	config.width = 10;
+	
+	// Edge fires on the slope only, once the far threshold is crossed
+	auto step = MakeSignal({ { 0, 20 }, { 500, 5 }, { 1000, 30 }, { 0, 20 } });
+	CHECK(Run(config, step, Trigger::Edge, 25) == (1 << Trigger::Edge | 1 << Trigger::Width));
+	
+	config.rising = false;
+	Run(config, step, Trigger::Edge, 55);
+	config.rising = true;
+	
+	// Width fires at the end of the pulse, for every condition it matches
+	auto pulse = MakeSignal({ { 0, 20 }, { 1000, 20 }, { 0, 20 } });
+	Run(config, pulse, Trigger::Width, 40);
+	
+	config.condition = Trigger::Condition::Within;
+	config.width_max = 25;
+	Run(config, pulse, Trigger::Width, 40);
+	
+	config.condition = Trigger::Condition::Less;
+	config.width = 30;
+	Run(config, pulse, Trigger::Width, 40);
+	
+	config.width = 15;
+	s_trigger.setup(config);
+	for (size_t i = 0; i < pulse.size(); i++)
+		s_trigger.process(pulse[i], i);
+	
+	CHECK(s_trigger.getCount(Trigger::Width) == 0);
+	
+	// Runt crosses the low threshold and falls back without reaching the high one, without an edge
+	config.condition = Trigger::Condition::Greater;
+	config.width = 10;
+	
+	auto runt = MakeSignal({ { 0, 20 }, { 500, 10 }, { 0, 20 } });
+	CHECK(Run(config, runt, Trigger::Runt, 30) == 1 << Trigger::Runt);
+	
+	// Glitch is a pulse narrower than the width, the leading edge alone is not one
+	auto glitch = MakeSignal({ { 0, 20 }, { 1000, 3 }, { 0, 20 } });
+	CHECK(Run(config, glitch, Trigger::Glitch, 23) == (1 << Trigger::Edge | 1 << Trigger::Glitch));
+	
+	// Dropout fires once the timeout passes after the last edge, once per dropout
+	config.timeout = 50;
+	auto dropout = MakeSignal({ { 0, 20 }, { 1000, 5 }, { 0, 200 } });
+	Run(config, dropout, Trigger::Dropout, 25 + 50);
+	
+	return Finish();
+}
+
+//========================================
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Remote control of the oscilloscope over its command UART.
+
+Usage:
+    tools/oscilloscope_client.py /dev/ttyUSB1 list
+    tools/oscilloscope_client.py /dev/ttyUSB1 set "Sample rate=5000"
+    tools/oscilloscope_client.py /dev/ttyUSB1 single --wait
+    tools/oscilloscope_client.py /dev/ttyUSB1 data -o capture.csv
+    tools/oscilloscope_client.py /dev/ttyUSB1 log minutes --since 3600 -o minutes.csv
+
+The simulator prints the pseudo terminal standing in for the port at startup.
+Needs pyserial. See main/CommandInterface.hpp for the protocol.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+
+class CommandError(Exception):
+    pass
+
+
+# See main/SampleCodec.hpp: count - 1, Rice parameter, payload size, first sample, then the LSB first bitstream
+BLOCK_HEADER = struct.Struct("<BBHh")
+ESCAPE_LENGTH = 16
+RAW_DELTA_BITS = 17
+
+
+def decode_block(header, payload):
+    """Returns the samples of a SampleCodec block."""
+    count, parameter, _, first = BLOCK_HEADER.unpack(header)
+    bits = "".join(f"{byte:08b}"[::-1] for byte in payload)
+    position = 0
+    samples = [first]
+    for _ in range(count):
+        # Unary quotient is terminated by a zero, unless it is the escape to a raw delta
+        end = bits.find("0", position, position + ESCAPE_LENGTH)
+        if end >= 0:
+            quotient = end - position
+            position = end + 1
+            remainder = int(bits[position:position + parameter][::-1] or "0", 2)
+            position += parameter
+            delta = quotient << parameter | remainder
+        else:
+            position += ESCAPE_LENGTH
+            delta = int(bits[position:position + RAW_DELTA_BITS][::-1], 2)
+            position += RAW_DELTA_BITS
+        value = samples[-1] + ((delta >> 1) ^ -(delta & 1))
+        samples.append((value + 0x8000) % 0x10000 - 0x8000)
+    return samples
+
+
+class Oscilloscope:
+    def __init__(self, port, baud_rate=921600, timeout=2.0):
+        self.serial = serial.Serial(port, baud_rate, timeout=timeout)
+        # Empty line ends whatever was left of a previous session
+        self.serial.write(b"\n")
+        self.serial.reset_input_buffer()
+
+    def close(self):
+        self.serial.close()
+
+    def read(self, size):
+        data = self.serial.read(size)
+        if len(data) != size:
+            raise TimeoutError("incomplete block")
+        return data
+
+    def readline(self):
+        line = self.serial.readline()
+        if not line.endswith(b"\n"):
+            raise TimeoutError("no response")
+        return line.decode(errors="replace").rstrip("\r\n")
+
+    def request(self, line):
+        """Sends a request, returns the text after OK of its response."""
+        self.serial.write(line.encode() + b"\n")
+        return self.response()
+
+    def response(self):
+        while True:
+            line = self.readline()
+            if line == "OK" or line.startswith("OK "):
+                return line[3:]
+            if line.startswith("ERR"):
+                raise CommandError(line[4:])
+
+    def id(self):
+        return self.request("ID")
+
+    def list(self):
+        self.serial.write(b"LIST\n")
+        settings = {}
+        while True:
+            line = self.readline()
+            if line == "OK":
+                return settings
+            if line.startswith("ERR"):
+                raise CommandError(line[4:])
+            label, separator, value = line.partition("=")
+            if separator:
+                settings[label] = value
+
+    def get(self, label):
+        return self.request(f"GET {label}")
+
+    def set(self, label, value):
+        self.request(f"SET {label}={value}")
+
+    def run(self):
+        self.request("RUN")
+
+    def stop(self):
+        self.request("STOP")
+
+    def single(self, wait=False, timeout=10.0):
+        self.request("SINGLE")
+        deadline = time.monotonic() + timeout
+        while wait and self.status() == "ARMED":
+            if time.monotonic() > deadline:
+                raise TimeoutError("no trigger")
+            time.sleep(0.05)
+
+    def status(self):
+        return self.request("STATUS")
+
+    def data(self):
+        """Returns the buffer in volts, oldest sample first, and the sample rate."""
+        self.serial.write(b"DATA\n")
+        while True:
+            line = self.readline()
+            if line.startswith("ERR"):
+                raise CommandError(line[4:])
+            if line.startswith("BLOCK "):
+                break
+
+        count, lsb, rate = line.split()[1:]
+        samples = []
+        while len(samples) < int(count):
+            header = self.read(BLOCK_HEADER.size)
+            samples += decode_block(header, self.read(BLOCK_HEADER.unpack(header)[2]))
+        self.response()
+
+        return [sample * float(lsb) for sample in samples], int(rate)
+
+    def log(self, tier, since=0):
+        """Returns data logger records of the tier as (time_s, channel, count, min, avg, max, missed) tuples."""
+        self.serial.write(f"LOG {tier}={since}\n".encode())
+        records = []
+        while True:
+            line = self.readline()
+            if line == "OK":
+                return records
+            if line.startswith("ERR"):
+                raise CommandError(line[4:])
+            timestamp, channel, count, minimum, average, maximum, missed = line.split()
+            records.append((int(timestamp), int(channel), int(count), float(minimum), float(average), float(maximum), int(missed)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", help="serial port of the command UART")
+    parser.add_argument("-b", "--baud", type=int, default=921600)
+    commands = parser.add_subparsers(dest="command", required=True)
+    commands.add_parser("id")
+    commands.add_parser("list")
+    commands.add_parser("get").add_argument("label")
+    commands.add_parser("set").add_argument("setting", help="label=value")
+    commands.add_parser("run")
+    commands.add_parser("stop")
+    commands.add_parser("single").add_argument("--wait", action="store_true", help="until the acquisition is over")
+    commands.add_parser("status")
+    commands.add_parser("data").add_argument("-o", "--output", type=argparse.FileType("w"), default=sys.stdout, help="CSV of time and voltage")
+    log_parser = commands.add_parser("log")
+    log_parser.add_argument("tier", choices=["seconds", "minutes", "hours"])
+    log_parser.add_argument("--since", type=int, default=0, help="log time in seconds")
+    log_parser.add_argument("-o", "--output", type=argparse.FileType("w"), default=sys.stdout, help="CSV of the records")
+    args = parser.parse_args()
+
+    oscilloscope = Oscilloscope(args.port, args.baud)
+    try:
+        if args.command == "list":
+            for label, value in oscilloscope.list().items():
+                print(f"{label}={value}")
+        elif args.command == "get":
+            print(oscilloscope.get(args.label))
+        elif args.command == "set":
+            label, _, value = args.setting.partition("=")
+            oscilloscope.set(label, value)
+        elif args.command == "single":
+            oscilloscope.single(args.wait)
+        elif args.command == "data":
+            volts, rate = oscilloscope.data()
+            args.output.write("time_s,voltage_v\n")
+            for i, voltage in enumerate(volts):
+                args.output.write(f"{i / rate:.9g},{voltage:.9g}\n")
+        elif args.command == "log":
+            args.output.write("time_s,channel,count,min_v,avg_v,max_v,missed\n")
+            for record in oscilloscope.log(args.tier, args.since):
+                args.output.write(",".join(str(value) for value in record) + "\n")
+        else:
+            response = getattr(oscilloscope, args.command)()
+            if response:
+                print(response)
+    except CommandError as error:
+        sys.exit(f"error: {error}")
+    finally:
+        oscilloscope.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Converts a trace dump from the device console into Chrome trace JSON.
+
+Usage:
+    idf.py monitor | tee console.log   # select Trace: Freeze on the device
+    tools/trace2chrome.py console.log > trace.json
+
+The result can be opened in chrome://tracing or https://ui.perfetto.dev
+See main/Trace.hpp for the recorder side.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+EVENT = struct.Struct("<IIBBH")
+BEGIN, END, INSTANT, SYNC = range(4)
+PHASES = {BEGIN: "B", END: "E", INSTANT: "i"}
+
+
+def unwrap(values, bits=32):
+    """Undoes wrap-around of a counter sequence, assuming it never runs backwards by more than half its range."""
+    offset = 0
+    previous = None
+    for value in values:
+        if previous is not None and value < previous and previous - value > 1 << (bits - 1):
+            offset += 1 << bits
+        previous = value
+        yield value + offset
+
+
+def parse(lines):
+    dumps = []
+    dump = None
+    core = None
+
+    for line in lines:
+        match = re.search(r"TRACE (\w+) ?(.*)$", line)
+        if not match:
+            continue
+
+        record, fields = match.group(1), match.group(2).split()
+        if record == "BEGIN":
+            dump = {"cores": int(fields[1]), "cycles_per_us": int(fields[2]), "names": {}, "events": {}}
+        elif dump is None:
+            continue
+        elif record == "NAME":
+            dump["names"][int(fields[0])] = " ".join(fields[1:])
+        elif record == "CORE":
+            core = int(fields[0])
+            dump["events"][core] = []
+        elif record == "DATA":
+            data = bytes.fromhex(fields[0])
+            dump["events"][core] += list(EVENT.iter_unpack(data[:len(data) - len(data) % EVENT.size]))
+        elif record == "END":
+            dumps.append(dump)
+            dump = None
+
+    return dumps
+
+
+def convert(dump):
+    trace_events = []
+    cycles_per_us = dump["cycles_per_us"]
+
+    for core, events in dump["events"].items():
+        if not events:
+            continue
+
+        cycles = list(unwrap(event[0] for event in events))
+        syncs = [(c, event[1]) for c, event in zip(cycles, events) if event[2] == SYNC]
+        if not syncs:
+            print(f"core {core}: no clock sync events, timestamps are relative", file=sys.stderr)
+            syncs = [(cycles[0], 0)]
+
+        sync_times = list(unwrap(time for _, time in syncs))
+        syncs = [(c, time) for (c, _), time in zip(syncs, sync_times)]
+
+        # Every event is anchored to the last sync before it, or to the first one for events preceding all syncs
+        sync = 0
+        open_scopes = []
+        for c, (_, arg, kind, event_id, _) in zip(cycles, events):
+            while sync + 1 < len(syncs) and syncs[sync + 1][0] <= c:
+                sync += 1
+
+            if kind == SYNC:
+                continue
+
+            sync_cycles, sync_time = syncs[sync]
+            timestamp = sync_time + (c - sync_cycles) / cycles_per_us
+            name = dump["names"].get(event_id, f"event {event_id}")
+
+            # Ring buffer may start in the middle of a scope, so unmatched ends are dropped
+            if kind == END:
+                if name not in open_scopes:
+                    continue
+                open_scopes.remove(name)
+            elif kind == BEGIN:
+                open_scopes.append(name)
+
+            trace_event = {"name": name, "ph": PHASES[kind], "ts": timestamp, "pid": 0, "tid": core}
+            if kind == INSTANT:
+                trace_event["s"] = "t"
+            if kind != END:
+                trace_event["args"] = {"arg": arg}
+
+            trace_events.append(trace_event)
+
+        trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": f"CPU{core}"}})
+
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r", errors="replace"), default=sys.stdin, help="console log containing a trace dump")
+    parser.add_argument("-o", "--output", type=argparse.FileType("w"), default=sys.stdout)
+    parser.add_argument("-n", "--dump", type=int, default=-1, help="index of the dump to convert if there are several, last one by default")
+    args = parser.parse_args()
+
+    dumps = parse(args.log)
+    if not dumps:
+        sys.exit("no trace dump found")
+
+    json.dump(convert(dumps[args.dump]), args.output)
+
+
+if __name__ == "__main__":
+    main()